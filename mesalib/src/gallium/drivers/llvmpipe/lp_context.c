@@ -38,6 +38,7 @@
 #include "util/u_memory.h"
 #include "util/list.h"
 #include "util/u_upload_mgr.h"
+#include "util/u_debug.h"
 #include "lp_clear.h"
 #include "lp_context.h"
 #include "lp_flush.h"
@@ -54,6 +55,8 @@
 #define USE_GLOBAL_LLVM_CONTEXT
 #endif
 
+DEBUG_GET_ONCE_BOOL_OPTION(async_compile, "LP_ASYNC_COMPILE", false)
+
 static void llvmpipe_destroy( struct pipe_context *pipe )
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
@@ -107,6 +110,8 @@ static void llvmpipe_destroy( struct pipe_context *pipe )
 
    lp_delete_setup_variants(llvmpipe);
 
+   llvmpipe_fs_async_fini(llvmpipe);
+
 #ifndef USE_GLOBAL_LLVM_CONTEXT
    LLVMContextDispose(llvmpipe->context);
 #endif
@@ -254,6 +259,17 @@ llvmpipe_create_context(struct pipe_screen *screen, void *priv,
    LLVMContextSetOpaquePointers(llvmpipe->context, false);
 #endif
 
+   /* Compile the specialized parts of fragment shader variants on a
+    * background thread, drawing with generic code meanwhile.
+    */
+   list_inithead(&llvmpipe->fs_async_orphans);
+   if (debug_get_option_async_compile()) {
+      llvmpipe->fs_async =
+         util_queue_init(&llvmpipe->fs_compile_queue, "lpfs", 32, 1,
+                         UTIL_QUEUE_INIT_RESIZE_IF_FULL |
+                         UTIL_QUEUE_INIT_USE_MINIMUM_PRIORITY, llvmpipe);
+   }
+
    /*
     * Create drawing context and plug our rendering stage into it.
     */
@@ -35,6 +35,7 @@
 
 #include "draw/draw_vertex.h"
 #include "util/u_blitter.h"
+#include "util/u_queue.h"
 
 #include "lp_tex_sample.h"
 #include "lp_jit.h"
@@ -159,6 +160,13 @@ struct llvmpipe_context {
    unsigned nr_fs_variants;
    unsigned nr_fs_instrs;
 
+   /** Background compilation of fragment shader variants */
+   boolean fs_async;
+   struct util_queue fs_compile_queue;
+   unsigned fs_async_done;   /**< jobs completed, incremented atomically */
+   unsigned fs_async_seen;   /**< fs_async_done at the last draw */
+   struct list_head fs_async_orphans;  /**< jobs of destroyed variants */
+
    boolean permit_linear_rasterizer;
    boolean single_vp;
 
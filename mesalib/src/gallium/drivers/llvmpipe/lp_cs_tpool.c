@@ -29,9 +29,52 @@
  */
 
 #include "util/u_thread.h"
+#include "util/u_atomic.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "lp_cs_tpool.h"
 
+/* Run batches of the task's iterations until they have all been
+ * claimed, and return how many were run.
+ */
+static unsigned
+lp_cs_tpool_run_task(struct lp_cs_tpool_task *task,
+                     struct lp_cs_local_mem *lmem)
+{
+   const unsigned chunk = task->iter_chunk;
+   unsigned done = 0;
+
+   for (;;) {
+      unsigned start = p_atomic_add_return(&task->iter_next, chunk) - chunk;
+      if (start >= task->iter_total)
+         break;
+
+      unsigned end = MIN2(start + chunk, task->iter_total);
+      for (unsigned i = start; i < end; i++)
+         task->work(task->data, i, lmem);
+      done += end - start;
+   }
+   return done;
+}
+
+/* Account for a thread leaving the task.  Every iteration has been
+ * claimed by now, so the task can come off the queue.  Called with the
+ * pool mutex held.
+ */
+static void
+lp_cs_tpool_leave_task(struct lp_cs_tpool_task *task, unsigned done)
+{
+   if (task->queued) {
+      list_del(&task->list);
+      task->queued = false;
+   }
+
+   task->iter_finished += done;
+   task->busy--;
+   if (task->iter_finished == task->iter_total && !task->busy)
+      cnd_broadcast(&task->finish);
+}
+
 static int
 lp_cs_tpool_worker(void *data)
 {
@@ -43,7 +86,6 @@ lp_cs_tpool_worker(void *data)
 
    while (!pool->shutdown) {
       struct lp_cs_tpool_task *task;
-      unsigned iter_per_thread;
 
       while (list_is_empty(&pool->workqueue) && !pool->shutdown)
          cnd_wait(&pool->new_work, &pool->m);
@@ -53,30 +95,13 @@ lp_cs_tpool_worker(void *data)
 
       task = list_first_entry(&pool->workqueue, struct lp_cs_tpool_task,
                               list);
-
-      unsigned this_iter = task->iter_start;
-
-      iter_per_thread = task->iter_per_thread;
-
-      if (task->iter_remainder &&
-          task->iter_start + task->iter_remainder == task->iter_total) {
-         task->iter_remainder--;
-         iter_per_thread = 1;
-      }
-
-      task->iter_start += iter_per_thread;
-
-      if (task->iter_start == task->iter_total)
-         list_del(&task->list);
+      task->busy++;
 
       mtx_unlock(&pool->m);
-      for (unsigned i = 0; i < iter_per_thread; i++)
-         task->work(task->data, this_iter + i, &lmem);
+      unsigned done = lp_cs_tpool_run_task(task, &lmem);
 
       mtx_lock(&pool->m);
-      task->iter_finished += iter_per_thread;
-      if (task->iter_finished == task->iter_total)
-         cnd_broadcast(&task->finish);
+      lp_cs_tpool_leave_task(task, done);
    }
    mtx_unlock(&pool->m);
    FREE(lmem.local_mem_ptr);
@@ -91,11 +116,18 @@ lp_cs_tpool_create(unsigned num_threads)
    if (!pool)
       return NULL;
 
+   if (num_threads) {
+      pool->threads = CALLOC(num_threads, sizeof(*pool->threads));
+      if (!pool->threads) {
+         FREE(pool);
+         return NULL;
+      }
+   }
+
    (void) mtx_init(&pool->m, mtx_plain);
    cnd_init(&pool->new_work);
 
    list_inithead(&pool->workqueue);
-   assert (num_threads <= LP_MAX_THREADS);
    for (unsigned i = 0; i < num_threads; i++) {
       if (thrd_success != u_thread_create(pool->threads + i, lp_cs_tpool_worker, pool)) {
          num_threads = i;  /* previous thread is max */
@@ -123,6 +155,7 @@ lp_cs_tpool_destroy(struct lp_cs_tpool *pool)
 
    cnd_destroy(&pool->new_work);
    mtx_destroy(&pool->m);
+   FREE(pool->threads);
    FREE(pool);
 }
 
@@ -151,14 +184,19 @@ lp_cs_tpool_queue_task(struct lp_cs_tpool *pool,
    task->data = data;
    task->iter_total = num_iters;
 
-   task->iter_per_thread = num_iters / pool->num_threads;
-   task->iter_remainder = num_iters % pool->num_threads;
+   /* Small enough batches that the threads, including the one waiting
+    * for the task, get about four each and even out if some run slower,
+    * but large enough to keep the atomic counter cold for big grids of
+    * small workgroups.
+    */
+   task->iter_chunk = DIV_ROUND_UP(num_iters, (pool->num_threads + 1) * 4);
 
    cnd_init(&task->finish);
 
    mtx_lock(&pool->m);
 
    list_addtail(&task->list, &pool->workqueue);
+   task->queued = true;
 
    cnd_broadcast(&pool->new_work);
    mtx_unlock(&pool->m);
@@ -174,11 +212,23 @@ lp_cs_tpool_wait_for_task(struct lp_cs_tpool *pool,
    if (!pool || !task)
       return;
 
+   /* Help out instead of just sleeping. */
+   struct lp_cs_local_mem lmem;
+   memset(&lmem, 0, sizeof(lmem));
+
    mtx_lock(&pool->m);
-   while (task->iter_finished < task->iter_total)
+   task->busy++;
+   mtx_unlock(&pool->m);
+
+   unsigned done = lp_cs_tpool_run_task(task, &lmem);
+
+   mtx_lock(&pool->m);
+   lp_cs_tpool_leave_task(task, done);
+   while (task->iter_finished < task->iter_total || task->busy)
       cnd_wait(&task->finish, &pool->m);
    mtx_unlock(&pool->m);
 
+   FREE(lmem.local_mem_ptr);
    cnd_destroy(&task->finish);
    FREE(task);
    *task_handle = NULL;
@@ -28,6 +28,10 @@
  * The item is added to the work queue once, but it must execute
  * number of iterations times. This saves storing a bunch of queue
  * structs with just unique indexes in them.
+ * Threads claim batches of iterations with an atomic counter rather
+ * than under the pool mutex, so threads which get through their
+ * batches faster take on more of them, and the thread waiting for the
+ * task runs batches too.
  * It also supports a local memory support struct to be passed from
  * outside the thread exec function.
  */
@@ -45,7 +49,7 @@ struct lp_cs_tpool {
    mtx_t m;
    cnd_t new_work;
 
-   thrd_t threads[LP_MAX_THREADS];
+   thrd_t *threads;
    unsigned num_threads;
    struct list_head workqueue;
    bool shutdown;
@@ -64,10 +68,11 @@ struct lp_cs_tpool_task {
    struct list_head list;
    cnd_t finish;
    unsigned iter_total;
-   unsigned iter_start;
+   unsigned iter_next;       /* next unclaimed iteration, atomic */
+   unsigned iter_chunk;      /* iterations claimed at a time */
    unsigned iter_finished;
-   unsigned iter_per_thread;
-   unsigned iter_remainder;
+   unsigned busy;            /* threads currently claiming iterations */
+   bool queued;
 };
 
 struct lp_cs_tpool *lp_cs_tpool_create(unsigned num_threads);
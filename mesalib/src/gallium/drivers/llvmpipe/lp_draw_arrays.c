@@ -35,10 +35,13 @@
 #include "pipe/p_context.h"
 #include "util/u_draw.h"
 #include "util/u_prim.h"
+#include "util/os_time.h"
 
 #include "lp_context.h"
 #include "lp_state.h"
 #include "lp_query.h"
+#include "lp_state_fs.h"
+#include "lp_trace.h"
 
 #include "draw/draw_context.h"
 
@@ -73,6 +76,12 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info,
       return;
    }
 
+   /* Swap in fragment shader variants compiled in the background */
+   if (p_atomic_read(&lp->fs_async_done) != lp->fs_async_seen) {
+      lp->fs_async_seen = p_atomic_read(&lp->fs_async_done);
+      lp->dirty |= LP_NEW_FS_VARIANT;
+   }
+
    if (lp->dirty)
       llvmpipe_update_derived( lp );
 
@@ -147,9 +156,23 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info,
                                      !lp->queries_disabled);
 
    /* draw! */
+   int64_t start = lp_trace_enabled ? os_time_get() : 0;
+
    draw_vbo(draw, info, drawid_offset, indirect, draws, num_draws,
             lp->patch_vertices);
 
+   if (lp_trace_enabled) {
+      unsigned count = 0;
+      for (i = 0; i < num_draws; i++)
+         count += draws[i].count;
+
+      lp_trace_event("draw", LP_TRACE_TID_SETUP, start, os_time_get(),
+                     "\"fs\":%u,\"count\":%u,\"draws\":%u,"
+                     "\"instances\":%u",
+                     lp->fs ? lp->fs->no : 0, count, num_draws,
+                     info->instance_count);
+   }
+
    /*
     * unmap vertex/index buffers
     */
@@ -83,33 +83,48 @@ lp_fence_destroy(struct lp_fence *fence)
 /**
  * Called by the rendering threads to increment the fence counter.
  * When the counter == the rank, the fence is finished.
+ *
+ * The counter is incremented atomically and only the last thread takes
+ * the mutex, to wake up the waiters.  As waiters check the counter
+ * with the mutex held, that can't miss a wakeup.
+ *
+ * Waiters which see the final count return without taking the mutex,
+ * and may release the fence before the broadcast, so hold a reference
+ * until it's done.
  */
 void
 lp_fence_signal(struct lp_fence *fence)
 {
+   struct lp_fence *ref = NULL;
+   unsigned count;
+
    if (LP_DEBUG & DEBUG_FENCE)
       debug_printf("%s %d\n", __FUNCTION__, fence->id);
 
-   mtx_lock(&fence->mutex);
+   lp_fence_reference(&ref, fence);
 
-   fence->count++;
-   assert(fence->count <= fence->rank);
+   count = p_atomic_inc_return(&fence->count);
+   assert(count <= fence->rank);
 
    if (LP_DEBUG & DEBUG_FENCE)
       debug_printf("%s count=%u rank=%u\n", __FUNCTION__,
-                   fence->count, fence->rank);
-
-   /* Wakeup all threads waiting on the mutex:
-    */
-   cnd_broadcast(&fence->signalled);
+                   count, fence->rank);
+
+   if (count == fence->rank) {
+      /* Wakeup all threads waiting on the mutex:
+       */
+      mtx_lock(&fence->mutex);
+      cnd_broadcast(&fence->signalled);
+      mtx_unlock(&fence->mutex);
+   }
 
-   mtx_unlock(&fence->mutex);
+   lp_fence_reference(&ref, NULL);
 }
 
 boolean
 lp_fence_signalled(struct lp_fence *f)
 {
-   return f->count == f->rank;
+   return p_atomic_read(&f->count) == f->rank;
 }
 
 void
@@ -118,9 +133,13 @@ lp_fence_wait(struct lp_fence *f)
    if (LP_DEBUG & DEBUG_FENCE)
       debug_printf("%s %d\n", __FUNCTION__, f->id);
 
-   mtx_lock(&f->mutex);
    assert(f->issued);
-   while (f->count < f->rank) {
+
+   if (lp_fence_signalled(f))
+      return;
+
+   mtx_lock(&f->mutex);
+   while (p_atomic_read(&f->count) < f->rank) {
       cnd_wait(&f->signalled, &f->mutex);
    }
    mtx_unlock(&f->mutex);
@@ -140,9 +159,13 @@ lp_fence_timedwait(struct lp_fence *f, uint64_t timeout)
    if (LP_DEBUG & DEBUG_FENCE)
       debug_printf("%s %d\n", __FUNCTION__, f->id);
 
-   mtx_lock(&f->mutex);
    assert(f->issued);
-   while (f->count < f->rank) {
+
+   if (lp_fence_signalled(f))
+      return TRUE;
+
+   mtx_lock(&f->mutex);
+   while (p_atomic_read(&f->count) < f->rank) {
       if (ts_overflow)
          ret = cnd_wait(&f->signalled, &f->mutex);
       else
@@ -150,7 +173,7 @@ lp_fence_timedwait(struct lp_fence *f, uint64_t timeout)
       if (ret != thrd_success)
          break;
    }
-   const boolean result = (f->count >= f->rank);
+   const boolean result = (p_atomic_read(&f->count) >= f->rank);
    mtx_unlock(&f->mutex);
    return result;
 }
@@ -48,7 +48,7 @@ struct lp_fence
 
    boolean issued;
    unsigned rank;
-   unsigned count;
+   unsigned count;   /**< incremented atomically by the rendering threads */
 };
 
 
@@ -66,8 +66,6 @@
 
 #define LP_MAX_SAMPLES 4
 
-#define LP_MAX_THREADS 16
-
 
 /**
  * Max number of shader variants (for all shaders combined,
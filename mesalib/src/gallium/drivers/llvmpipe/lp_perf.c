@@ -26,6 +26,7 @@
  **************************************************************************/
 
 #include "util/u_debug.h"
+#include "util/u_memory.h"
 #include "lp_debug.h"
 #include "lp_perf.h"
 
@@ -37,7 +38,44 @@ struct lp_counters lp_count;
 void
 lp_reset_counters(void)
 {
+   int64_t *busy = lp_count.rast_busy_time;
+   int64_t *idle = lp_count.rast_idle_time;
+   unsigned num_threads = lp_count.num_rast_threads;
+
    memset(&lp_count, 0, sizeof(lp_count));
+
+   if (num_threads) {
+      memset(busy, 0, num_threads * sizeof(*busy));
+      memset(idle, 0, num_threads * sizeof(*idle));
+      lp_count.rast_busy_time = busy;
+      lp_count.rast_idle_time = idle;
+      lp_count.num_rast_threads = num_threads;
+   }
+}
+
+
+/**
+ * Allocate the per-thread rasterizer counters.  They live as long as
+ * the process, like lp_count itself; every rasterizer has the screen's
+ * thread count, so the first one sizes them.
+ */
+void
+lp_init_rast_counters(unsigned num_threads)
+{
+   if (lp_count.num_rast_threads || !num_threads)
+      return;
+
+   lp_count.rast_busy_time = CALLOC(num_threads, sizeof(int64_t));
+   lp_count.rast_idle_time = CALLOC(num_threads, sizeof(int64_t));
+
+   if (lp_count.rast_busy_time && lp_count.rast_idle_time) {
+      lp_count.num_rast_threads = num_threads;
+   } else {
+      FREE(lp_count.rast_busy_time);
+      FREE(lp_count.rast_idle_time);
+      lp_count.rast_busy_time = NULL;
+      lp_count.rast_idle_time = NULL;
+   }
 }
 
 
@@ -117,6 +155,28 @@ lp_print_counters(void)
       debug_printf("llvmpipe: nr_color_tile_clear:          %9u\n", lp_count.nr_color_tile_clear);
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
+      debug_printf("llvmpipe: nr_color_tile_clear_elided:   %9u\n", lp_count.nr_color_tile_clear_elided);
+      debug_printf("llvmpipe: nr_hiz_culled:                %9u\n", lp_count.nr_hiz_culled);
+
+      debug_printf("llvmpipe: nr_scenes:                    %9u\n", lp_count.nr_scenes);
+      debug_printf("llvmpipe:   nr_scene_waits:             %9u\n", lp_count.nr_scene_waits);
+      debug_printf("llvmpipe: setup bin/wait time:          %.3f / %.3f sec\n",
+                   lp_count.setup_bin_time / 1000000.0,
+                   lp_count.setup_wait_time / 1000000.0);
+      debug_printf("llvmpipe: rast scene time:              %.3f sec\n",
+                   lp_count.rast_scene_time / 1000000.0);
+
+      for (unsigned i = 0; i < lp_count.num_rast_threads; i++) {
+         int64_t busy = lp_count.rast_busy_time[i];
+         int64_t idle = lp_count.rast_idle_time[i];
+
+         if (busy + idle == 0)
+            continue;
+
+         debug_printf("llvmpipe: thread %2u busy/idle:         %.3f / %.3f sec (%3.0f%% busy)\n",
+                      i, busy / 1000000.0, idle / 1000000.0,
+                      100.0 * busy / (busy + idle));
+      }
 
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
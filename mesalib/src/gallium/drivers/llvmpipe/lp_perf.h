@@ -34,6 +34,7 @@
 #define LP_PERF_H
 
 #include "pipe/p_compiler.h"
+#include "lp_limits.h"
 
 /**
  * Various counters
@@ -68,6 +69,26 @@ struct lp_counters
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
    unsigned nr_color_tile_store;
+   unsigned nr_color_tile_clear_elided;
+   unsigned nr_hiz_culled;
+
+   /** Scenes binned, and how often setup had to wait for one to be
+    * rasterized before it could bin the next.  Times are totals, in
+    * microseconds.
+    */
+   unsigned nr_scenes;
+   unsigned nr_scene_waits;
+   int64_t setup_bin_time;
+   int64_t setup_wait_time;
+   int64_t rast_scene_time;
+
+   /** Per rasterizer thread, in microseconds: time spent rasterizing
+    * bins, and time spent waiting for the other threads to finish the
+    * scene.  num_rast_threads entries each, see lp_init_rast_counters().
+    */
+   int64_t *rast_busy_time;
+   int64_t *rast_idle_time;
+   unsigned num_rast_threads;
 };
 
 
@@ -90,6 +111,10 @@ extern void
 lp_reset_counters(void);
 
 
+extern void
+lp_init_rast_counters(unsigned num_threads);
+
+
 extern void
 lp_print_counters(void);
 
@@ -32,6 +32,7 @@
 
 #include "draw/draw_context.h"
 #include "pipe/p_defines.h"
+#include "util/u_atomic.h"
 #include "util/u_memory.h"
 #include "util/os_time.h"
 #include "lp_context.h"
@@ -53,13 +54,21 @@ llvmpipe_create_query(struct pipe_context *pipe,
                       unsigned type,
                       unsigned index)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
+   unsigned num_threads = MAX2(1, screen->num_threads);
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          type == LP_QUERY_DISK_SHADER_CACHE_HITS ||
+          type == LP_QUERY_DISK_SHADER_CACHE_MISSES);
 
-   pq = CALLOC_STRUCT( llvmpipe_query );
+   /* the per-thread counts follow the query in the same allocation */
+   pq = CALLOC(1, sizeof(*pq) + 2 * num_threads * sizeof(uint64_t));
 
    if (pq) {
+      pq->start = (uint64_t *)(pq + 1);
+      pq->end = pq->start + num_threads;
+      pq->num_threads = num_threads;
       pq->type = type;
       pq->index = index;
    }
@@ -120,6 +129,10 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
    *result = 0;
 
    switch (pq->type) {
+   case LP_QUERY_DISK_SHADER_CACHE_HITS:
+   case LP_QUERY_DISK_SHADER_CACHE_MISSES:
+      *result = pq->end[0] - pq->start[0];
+      break;
    case PIPE_QUERY_OCCLUSION_COUNTER:
       for (i = 0; i < num_threads; i++) {
          *result += pq->end[i];
@@ -379,12 +392,37 @@ llvmpipe_get_query_result_resource(struct pipe_context *pipe,
    }
 }
 
+/**
+ * Sample the screen-wide counter of a driver-specific query.
+ * These don't go through the scene, as they don't count rendering.
+ */
+static uint64_t
+get_driver_query_value(struct pipe_context *pipe, unsigned type)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
+
+   switch (type) {
+   case LP_QUERY_DISK_SHADER_CACHE_HITS:
+      return p_atomic_read(&screen->num_disk_shader_cache_hits);
+   case LP_QUERY_DISK_SHADER_CACHE_MISSES:
+      return p_atomic_read(&screen->num_disk_shader_cache_misses);
+   default:
+      unreachable("not a driver-specific query");
+   }
+}
+
+
 static bool
 llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (pq->type >= PIPE_QUERY_DRIVER_SPECIFIC) {
+      pq->start[0] = get_driver_query_value(pipe, pq->type);
+      return true;
+   }
+
    /* Check if the query is already in the scene.  If so, we need to
     * flush the scene now.  Real apps shouldn't re-use a query in a
     * frame of rendering.
@@ -394,8 +432,8 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    }
 
 
-   memset(pq->start, 0, sizeof(pq->start));
-   memset(pq->end, 0, sizeof(pq->end));
+   memset(pq->start, 0, pq->num_threads * sizeof(*pq->start));
+   memset(pq->end, 0, pq->num_threads * sizeof(*pq->end));
    lp_setup_begin_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
@@ -448,6 +486,11 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (pq->type >= PIPE_QUERY_DRIVER_SPECIFIC) {
+      pq->end[0] = get_driver_query_value(pipe, pq->type);
+      return true;
+   }
+
    lp_setup_end_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
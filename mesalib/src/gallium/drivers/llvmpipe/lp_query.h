@@ -41,9 +41,15 @@
 struct llvmpipe_context;
 
 
+/** Driver-specific queries, sampling screen-wide counters */
+#define LP_QUERY_DISK_SHADER_CACHE_HITS   (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define LP_QUERY_DISK_SHADER_CACHE_MISSES (PIPE_QUERY_DRIVER_SPECIFIC + 1)
+
+
 struct llvmpipe_query {
-   uint64_t start[LP_MAX_THREADS];  /* start count value for each thread */
-   uint64_t end[LP_MAX_THREADS];    /* end count value for each thread */
+   uint64_t *start;                 /* start count value for each thread */
+   uint64_t *end;                   /* end count value for each thread */
+   unsigned num_threads;            /* size of start[] and end[] */
    struct lp_fence *fence;          /* fence from last scene this was binned in */
    unsigned type;                   /* PIPE_QUERY_* */
    unsigned index;
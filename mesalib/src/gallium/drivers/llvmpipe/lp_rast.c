@@ -25,6 +25,7 @@
  *
  **************************************************************************/
 
+#include <float.h>
 #include <limits.h>
 #include "util/u_memory.h"
 #include "util/u_math.h"
@@ -34,6 +35,7 @@
 #include "util/u_string.h"
 #include "util/u_thread.h"
 #include "util/u_memset.h"
+#include "util/u_cpu_detect.h"
 #include "util/os_time.h"
 
 #include "lp_scene_queue.h"
@@ -49,6 +51,7 @@
 #include "lp_scene.h"
 #include "lp_screen.h"
 #include "lp_tex_sample.h"
+#include "lp_trace.h"
 
 
 #ifdef DEBUG
@@ -72,16 +75,33 @@ lp_rast_begin(struct lp_rasterizer *rast,
 {
    rast->curr_scene = scene;
 
+   if ((LP_DEBUG & DEBUG_COUNTERS) || lp_trace_enabled)
+      rast->curr_scene_start = os_time_get();
+
+   /* The fence is signalled before lp_rast_end(), after which setup may
+    * reset the scene, so remember its id now.
+    */
+   rast->curr_scene_id = scene->fence ? scene->fence->id : 0;
+
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
    lp_scene_begin_rasterization(scene);
-   lp_scene_bin_iter_begin(scene);
+   lp_scene_bin_iter_begin(scene, MAX2(rast->num_threads, 1));
 }
 
 
 static void
 lp_rast_end(struct lp_rasterizer *rast)
 {
+   if (LP_DEBUG & DEBUG_COUNTERS)
+      lp_count.rast_scene_time += os_time_get() - rast->curr_scene_start;
+
+   if (lp_trace_enabled) {
+      lp_trace_event("rasterize scene", LP_TRACE_TID_SCENE,
+                     rast->curr_scene_start, os_time_get(),
+                     "\"scene\":%u", rast->curr_scene_id);
+   }
+
    rast->curr_scene = NULL;
 }
 
@@ -123,6 +143,13 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
                          scene->zsbuf.stride * task->y +
                          scene->zsbuf.format_bytes * task->x;
    }
+
+   task->hiz_enabled = scene->fb.zsbuf &&
+                       util_format_has_depth(
+                          util_format_description(scene->fb.zsbuf->format)) &&
+                       scene->fb_max_layer == 0 &&
+                       !(LP_PERF & PERF_NO_HIZ);
+   task->hiz_valid = FALSE;
 }
 
 
@@ -948,6 +975,182 @@ blit_rasterize_bin(struct lp_rasterizer_task *task,
 }
 
 
+/*
+ * Hierarchical Z.
+ *
+ * While the commands of a tile are executed, keep an upper bound of the
+ * depth values in it.  A depth clear sets the bound, and a primitive
+ * covering the whole tile with a LESS/LEQUAL test and depth writes lowers
+ * it to the primitive's maximum depth over the tile.  Other LESS/LEQUAL
+ * primitives can only lower depth values, while depth writes with any
+ * other test lose the bound.  A primitive whose minimum depth over the
+ * tile is beyond the bound fails the depth test everywhere in the tile,
+ * and is skipped if its shader has no other side effects.
+ *
+ * The separation required for culling is at least one step of a 16 bit
+ * depth buffer, so that quantized values compare the same way.
+ */
+#define HIZ_SEPARATION (1.0f / (1 << 15))
+
+
+static void
+hiz_clear(struct lp_rasterizer_task *task,
+          const union lp_rast_cmd_arg arg)
+{
+   const enum pipe_format format = task->scene->fb.zsbuf->format;
+   const uint64_t zbits = util_pack64_mask_z(format, ~0);
+   const uint64_t mask = arg.clear_zstencil.mask & zbits;
+   const uint64_t value = arg.clear_zstencil.value;
+
+   if (mask == zbits) {
+      union {
+         uint16_t u16;
+         uint32_t u32;
+         uint64_t u64;
+      } packed;
+
+      switch (util_format_get_blocksize(format)) {
+      case 2:
+         packed.u16 = (uint16_t) value;
+         break;
+      case 4:
+         packed.u32 = (uint32_t) value;
+         break;
+      default:
+         packed.u64 = value;
+         break;
+      }
+
+      util_format_unpack_z_float(format, &task->hiz_zmax, &packed, 1);
+      task->hiz_valid = TRUE;
+   } else if (mask) {
+      task->hiz_valid = FALSE;
+   }
+}
+
+
+/**
+ * Compute bounds of the depth values the fragment shader computes for the
+ * primitive within the current tile.  This mirrors the interpolation in
+ * lp_bld_interp.c, including the polygon offset stored in the X component
+ * of a0, and lp_build_depth_clamp().
+ */
+static void
+hiz_prim_bounds(const struct lp_rasterizer_task *task,
+                const struct lp_rast_shader_inputs *inputs,
+                const struct lp_fragment_shader_variant *variant,
+                float *zmin, float *zmax)
+{
+   float (*a0)[4] = GET_A0(inputs);
+   float (*dadx)[4] = GET_DADX(inputs);
+   float (*dady)[4] = GET_DADY(inputs);
+
+   /* Grow the tile by a pixel to cover pixel center and sample offsets. */
+   const double x0 = (double) task->x - 1.0;
+   const double x1 = (double) task->x + task->width + 1.0;
+   const double y0 = (double) task->y - 1.0;
+   const double y1 = (double) task->y + task->height + 1.0;
+
+   const double z0 = (double) a0[0][2] + a0[0][0];
+   const double dzdx = dadx[0][2];
+   const double dzdy = dady[0][2];
+
+   /* Allow for the rounding of the shader's single precision math. */
+   const double err = (fabs(a0[0][2]) + fabs(a0[0][0]) +
+                       fabs(dzdx) * MAX2(fabs(x0), fabs(x1)) +
+                       fabs(dzdy) * MAX2(fabs(y0), fabs(y1))) / (1 << 20);
+
+   double lo = z0 + MIN2(dzdx * x0, dzdx * x1) +
+                    MIN2(dzdy * y0, dzdy * y1) - err;
+   double hi = z0 + MAX2(dzdx * x0, dzdx * x1) +
+                    MAX2(dzdy * y0, dzdy * y1) + err;
+
+   if (variant->key.restrict_depth_values) {
+      lo = MIN2(MAX2(lo, 0.0), 1.0);
+      hi = MIN2(MAX2(hi, 0.0), 1.0);
+   }
+
+   if (variant->key.depth_clamp) {
+      const struct lp_jit_viewport *vp =
+         &task->state->jit_context.viewports[inputs->viewport_index];
+      lo = MIN2(MAX2(lo, vp->min_depth), vp->max_depth);
+      hi = MIN2(MAX2(hi, vp->min_depth), vp->max_depth);
+   }
+
+   *zmin = lo;
+   *zmax = hi;
+}
+
+
+/**
+ * Update the hierarchical Z state of the current tile for the given
+ * command, and return TRUE if the command can be skipped as all its
+ * fragments are known to fail the depth test.
+ */
+static boolean
+lp_rast_hiz_cull(struct lp_rasterizer_task *task,
+                 unsigned cmd,
+                 const union lp_rast_cmd_arg arg)
+{
+   const struct lp_rast_shader_inputs *inputs;
+   boolean whole_tile = FALSE;
+
+   switch (cmd) {
+   case LP_RAST_OP_CLEAR_ZSTENCIL:
+      hiz_clear(task, arg);
+      return FALSE;
+   case LP_RAST_OP_CLEAR_COLOR:
+   case LP_RAST_OP_BEGIN_QUERY:
+   case LP_RAST_OP_END_QUERY:
+   case LP_RAST_OP_SET_STATE:
+   case LP_RAST_OP_BLIT:
+      return FALSE;
+   case LP_RAST_OP_SHADE_TILE:
+   case LP_RAST_OP_SHADE_TILE_OPAQUE:
+      inputs = arg.shade_tile;
+      whole_tile = TRUE;
+      break;
+   case LP_RAST_OP_RECTANGLE:
+      inputs = &arg.rectangle->inputs;
+      break;
+   default:
+      inputs = &arg.triangle.tri->inputs;
+      break;
+   }
+
+   if (inputs->disable || !task->state)
+      return FALSE;
+
+   const struct lp_fragment_shader_variant *variant = task->state->variant;
+
+   if (variant->hiz_clobber) {
+      task->hiz_valid = FALSE;
+      return FALSE;
+   }
+
+   if (!variant->hiz_cull)
+      return FALSE;
+
+   float zmin, zmax;
+   hiz_prim_bounds(task, inputs, variant, &zmin, &zmax);
+
+   if (task->hiz_valid &&
+       task->hiz_zmax + HIZ_SEPARATION < 1.0f &&
+       zmin > task->hiz_zmax + HIZ_SEPARATION) {
+      LP_COUNT(nr_hiz_culled);
+      return TRUE;
+   }
+
+   if (whole_tile && variant->hiz_lower && zmax <= FLT_MAX) {
+      zmax = MAX2(zmax, 0.0f);
+      task->hiz_zmax = task->hiz_valid ? MIN2(task->hiz_zmax, zmax) : zmax;
+      task->hiz_valid = TRUE;
+   }
+
+   return FALSE;
+}
+
+
 static void
 tri_rasterize_bin(struct lp_rasterizer_task *task,
                   const struct cmd_bin *bin,
@@ -957,6 +1160,10 @@ tri_rasterize_bin(struct lp_rasterizer_task *task,
 
    for (const struct cmd_block *block = bin->head; block; block = block->next) {
       for (unsigned k = 0; k < block->count; k++) {
+         if (task->hiz_enabled &&
+             lp_rast_hiz_cull(task, block->cmd[k], block->arg[k]))
+            continue;
+
          dispatch_tri[block->cmd[k]](task, block->arg[k]);
       }
    }
@@ -977,6 +1184,46 @@ debug_rasterize_bin(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Record a trace event for a bin which took from start until now to
+ * rasterize, with its triangle count and the shader variants it used.
+ */
+static void
+trace_bin(const struct lp_rasterizer_task *task,
+          const struct cmd_bin *bin, int x, int y,
+          int64_t start)
+{
+   const struct lp_fragment_shader_variant *variant = NULL;
+   unsigned tris = 0, states = 0;
+
+   for (const struct cmd_block *block = bin->head; block; block = block->next) {
+      for (unsigned k = 0; k < block->count; k++) {
+         const unsigned cmd = block->cmd[k];
+
+         if (cmd == LP_RAST_OP_SET_STATE) {
+            /* Report the first variant, and how many states followed */
+            if (!variant)
+               variant = block->arg[k].set_state->variant;
+            states++;
+         } else if (cmd != LP_RAST_OP_CLEAR_COLOR &&
+                    cmd != LP_RAST_OP_CLEAR_ZSTENCIL &&
+                    cmd != LP_RAST_OP_BEGIN_QUERY &&
+                    cmd != LP_RAST_OP_END_QUERY) {
+            tris++;
+         }
+      }
+   }
+
+   lp_trace_event("bin", LP_TRACE_TID_RAST + task->thread_index,
+                  start, os_time_get(),
+                  "\"scene\":%u,\"x\":%d,\"y\":%d,\"prims\":%u,"
+                  "\"states\":%u,\"fs\":\"%u.%u\"",
+                  task->rast->curr_scene_id, x, y, tris, states,
+                  variant ? variant->shader->no : 0,
+                  variant ? variant->no : 0);
+}
+
+
 /**
  * Rasterize commands for a single bin.
  * \param x, y  position of the bin's tile in the framebuffer
@@ -988,6 +1235,7 @@ rasterize_bin(struct lp_rasterizer_task *task,
               const struct cmd_bin *bin, int x, int y)
 {
    struct lp_bin_info info = lp_characterize_bin(bin);
+   int64_t start = lp_trace_enabled ? os_time_get() : 0;
 
    lp_rast_tile_begin(task, bin, x, y);
 
@@ -1005,6 +1253,9 @@ rasterize_bin(struct lp_rasterizer_task *task,
 
    lp_rast_tile_end(task);
 
+   if (lp_trace_enabled)
+      trace_bin(task, bin, x, y, start);
+
 #ifdef DEBUG
    /* Debug/Perf flags:
     */
@@ -1020,20 +1271,6 @@ rasterize_bin(struct lp_rasterizer_task *task,
 }
 
 
-/* An empty bin is one that just loads the contents of the tile and
- * stores them again unchanged.  This typically happens when bins have
- * been flushed for some reason in the middle of a frame, or when
- * incremental updates are being made to a render target.
- *
- * Try to avoid doing pointless work in this case.
- */
-static boolean
-is_empty_bin(const struct cmd_bin *bin)
-{
-   return bin->head == NULL;
-}
-
-
 /**
  * Rasterize/execute all bins within a scene.
  * Called per thread.
@@ -1056,15 +1293,19 @@ rasterize_scene(struct lp_rasterizer_task *task,
 #endif
 
    if (!task->rast->no_rast) {
-      /* loop over scene bins, rasterize each */
+      /* loop over scene bins, rasterize each.  Empty bins, which
+       * would just load the contents of the tile and store them again
+       * unchanged, are skipped by the iterator.
+       */
       {
+         struct lp_scene_bin_iter iter;
          struct cmd_bin *bin;
          int i, j;
 
          assert(scene);
-         while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
-            if (!is_empty_bin(bin))
-               rasterize_bin(task, bin, i, j);
+         lp_scene_bin_iter_init(&iter, task->thread_index);
+         while ((bin = lp_scene_bin_iter_next(scene, &iter, &i, &j))) {
+            rasterize_bin(task, bin, i, j);
          }
       }
    }
@@ -1175,6 +1416,12 @@ thread_function(void *init_data)
    snprintf(thread_name, sizeof thread_name, "llvmpipe-%u", task->thread_index);
    u_thread_setname(thread_name);
 
+   /* Pin before touching any memory, so what this thread writes first
+    * is placed on its node.
+    */
+   if (task->cpu_mask)
+      util_set_current_thread_affinity(task->cpu_mask, NULL, UTIL_MAX_CPUS);
+
    /* Make sure that denorms are treated like zeros. This is
     * the behavior required by D3D10. OpenGL doesn't care.
     */
@@ -1207,10 +1454,26 @@ thread_function(void *init_data)
       if (debug)
          debug_printf("thread %d doing work\n", task->thread_index);
 
-      rasterize_scene(task, rast->curr_scene);
+      if (LP_DEBUG & DEBUG_COUNTERS) {
+         int64_t start = os_time_get(), end;
 
-      /* wait for all threads to finish with this scene */
-      util_barrier_wait(&rast->barrier);
+         rasterize_scene(task, rast->curr_scene);
+         end = os_time_get();
+
+         /* wait for all threads to finish with this scene */
+         util_barrier_wait(&rast->barrier);
+
+         if (task->thread_index < lp_count.num_rast_threads) {
+            lp_count.rast_busy_time[task->thread_index] += end - start;
+            lp_count.rast_idle_time[task->thread_index] += os_time_get() - end;
+         }
+      }
+      else {
+         rasterize_scene(task, rast->curr_scene);
+
+         /* wait for all threads to finish with this scene */
+         util_barrier_wait(&rast->barrier);
+      }
 
       /* XXX: shouldn't be necessary:
        */
@@ -1233,12 +1496,163 @@ thread_function(void *init_data)
 }
 
 
+#if DETECT_OS_LINUX && defined(HAVE_PTHREAD_SETAFFINITY)
+
+/**
+ * Parse a sysfs CPU list such as "0-15,32-47" into a mask.
+ */
+static void
+parse_cpu_list(const char *list, uint32_t *mask)
+{
+   while (*list) {
+      char *end;
+      unsigned first = strtoul(list, &end, 10), last = first;
+
+      if (end == list)
+         break;
+      if (*end == '-')
+         last = strtoul(end + 1, &end, 10);
+
+      for (unsigned cpu = first; cpu <= last && cpu < UTIL_MAX_CPUS; cpu++)
+         mask[cpu / 32] |= 1u << (cpu % 32);
+
+      list = *end == ',' ? end + 1 : "";
+   }
+}
+
+
+/**
+ * Get the CPUs of each NUMA node that this process may run on.
+ * Returns the number of such nodes.
+ */
+static unsigned
+get_numa_nodes(util_affinity_mask *masks, unsigned max_nodes)
+{
+   util_affinity_mask allowed, online;
+   cpu_set_t cpuset;
+   unsigned num_nodes = 0;
+   char list[4096];
+   FILE *f;
+
+   if (pthread_getaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0)
+      return 0;
+
+   /* The online nodes, as a list like the CPU lists */
+   if (!(f = fopen("/sys/devices/system/node/online", "r")))
+      return 0;
+
+   memset(online, 0, sizeof(online));
+   if (fgets(list, sizeof(list), f))
+      parse_cpu_list(list, online);
+   fclose(f);
+
+   memset(allowed, 0, sizeof(allowed));
+   for (unsigned cpu = 0; cpu < UTIL_MAX_CPUS && cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &cpuset))
+         allowed[cpu / 32] |= 1u << (cpu % 32);
+   }
+
+   for (unsigned node = 0; node < UTIL_MAX_CPUS && num_nodes < max_nodes; node++) {
+      char path[64];
+      bool empty = true;
+
+      if (!(online[node / 32] & (1u << (node % 32))))
+         continue;
+
+      snprintf(path, sizeof(path),
+               "/sys/devices/system/node/node%u/cpulist", node);
+      if (!(f = fopen(path, "r")))
+         continue;
+
+      if (fgets(list, sizeof(list), f)) {
+         memset(masks[num_nodes], 0, sizeof(util_affinity_mask));
+         parse_cpu_list(list, masks[num_nodes]);
+
+         for (unsigned i = 0; i < ARRAY_SIZE(allowed); i++) {
+            masks[num_nodes][i] &= allowed[i];
+            empty &= !masks[num_nodes][i];
+         }
+      }
+
+      fclose(f);
+
+      if (!empty)
+         num_nodes++;
+   }
+
+   return num_nodes;
+}
+
+#endif
+
+
+/**
+ * Get the groups of CPUs to spread the rasterizer threads over: the
+ * NUMA nodes where the topology is known, else the L3 cache domains.
+ * Returns the number of groups.
+ */
+static unsigned
+get_cpu_domains(util_affinity_mask *masks, unsigned max_domains)
+{
+   const struct util_cpu_caps_t *caps = util_get_cpu_caps();
+   unsigned num_domains = 0;
+
+#if DETECT_OS_LINUX && defined(HAVE_PTHREAD_SETAFFINITY)
+   num_domains = get_numa_nodes(masks, max_domains);
+#endif
+
+   if (num_domains <= 1 && caps->num_L3_caches > 1) {
+      num_domains = MIN2(caps->num_L3_caches, max_domains);
+      memcpy(masks, caps->L3_affinity_mask,
+             num_domains * sizeof(util_affinity_mask));
+   }
+
+   return num_domains;
+}
+
+
+/**
+ * Choose the NUMA node (or L3 cache domain) for each rasterizer thread
+ * to pin itself to when it starts.  Threads with neighbouring indices,
+ * which rasterize neighbouring bands of the framebuffer, share a node.
+ */
+static void
+assign_rast_cpus(struct lp_rasterizer *rast)
+{
+   util_affinity_mask *masks;
+   unsigned num_domains;
+
+   if (rast->num_threads < 2 || !debug_get_bool_option("LP_NUMA", TRUE))
+      return;
+
+   masks = MALLOC(rast->num_threads * sizeof(util_affinity_mask));
+   if (!masks)
+      return;
+
+   num_domains = get_cpu_domains(masks, rast->num_threads);
+
+   if (num_domains <= 1) {
+      FREE(masks);
+      return;
+   }
+
+   rast->cpu_domains = masks;
+   for (unsigned i = 0; i < rast->num_threads; i++) {
+      unsigned domain = i * num_domains / rast->num_threads;
+
+      rast->tasks[i].cpu_mask = masks[domain];
+   }
+}
+
+
 /**
  * Initialize semaphores and spawn the threads.
  */
 static void
 create_rast_threads(struct lp_rasterizer *rast)
 {
+   assign_rast_cpus(rast);
+
    /* NOTE: if num_threads is zero, we won't use any threads */
    for (unsigned i = 0; i < rast->num_threads; i++) {
       pipe_semaphore_init(&rast->tasks[i].work_ready, 0);
@@ -1268,9 +1682,15 @@ lp_rast_create(unsigned num_threads)
       goto no_rast;
    }
 
+   rast->tasks = CALLOC(MAX2(1, num_threads), sizeof(*rast->tasks));
+   rast->threads = CALLOC(MAX2(1, num_threads), sizeof(*rast->threads));
+   if (!rast->tasks || !rast->threads) {
+      goto no_tasks;
+   }
+
    rast->full_scenes = lp_scene_queue_create();
    if (!rast->full_scenes) {
-      goto no_full_scenes;
+      goto no_tasks;
    }
 
    for (i = 0; i < MAX2(1, num_threads); i++) {
@@ -1288,6 +1708,9 @@ lp_rast_create(unsigned num_threads)
 
    rast->no_rast = debug_get_bool_option("LP_NO_RAST", FALSE);
 
+   if (LP_DEBUG & DEBUG_COUNTERS)
+      lp_init_rast_counters(num_threads);
+
    create_rast_threads(rast);
 
    /* for synchronizing rasterization threads */
@@ -1300,14 +1723,16 @@ lp_rast_create(unsigned num_threads)
    return rast;
 
 no_thread_data_cache:
-   for (i = 0; i < MAX2(1, rast->num_threads); i++) {
+   for (i = 0; i < MAX2(1, num_threads); i++) {
       if (rast->tasks[i].thread_data.cache) {
          align_free(rast->tasks[i].thread_data.cache);
       }
    }
 
    lp_scene_queue_destroy(rast->full_scenes);
-no_full_scenes:
+no_tasks:
+   FREE(rast->tasks);
+   FREE(rast->threads);
    FREE(rast);
 no_rast:
    return NULL;
@@ -1354,6 +1779,7 @@ lp_rast_destroy(struct lp_rasterizer *rast)
    for (unsigned i = 0; i < MAX2(1, rast->num_threads); i++) {
       align_free(rast->tasks[i].thread_data.cache);
    }
+   FREE(rast->cpu_domains);
 
    lp_fence_reference(&rast->last_fence, NULL);
 
@@ -1364,6 +1790,8 @@ lp_rast_destroy(struct lp_rasterizer *rast)
 
    lp_scene_queue_destroy(rast->full_scenes);
 
+   FREE(rast->tasks);
+   FREE(rast->threads);
    FREE(rast);
 }
 
@@ -30,6 +30,7 @@
 
 #include "util/format/u_format.h"
 #include "util/u_thread.h"
+#include "util/u_cpu_detect.h"
 #include "gallivm/lp_bld_debug.h"
 #include "lp_memory.h"
 #include "lp_rast.h"
@@ -91,12 +92,22 @@ struct lp_rasterizer_task
    uint8_t *color_tiles[PIPE_MAX_COLOR_BUFS];
    uint8_t *depth_tile;
 
+   /** Hierarchical Z:  an upper bound of the depth values in the current
+    * tile, if hiz_valid.  See lp_rast_hiz_cull().
+    */
+   boolean hiz_enabled;
+   boolean hiz_valid;
+   float hiz_zmax;
+
    /** "back" pointer */
    struct lp_rasterizer *rast;
 
    /** "my" index */
    unsigned thread_index;
 
+   /** CPUs the thread pins itself to, or NULL, see assign_rast_cpus() */
+   const uint32_t *cpu_mask;
+
    /** Non-interpolated passthru state and occlude counter for visible pixels */
    struct lp_jit_thread_data thread_data;
 
@@ -120,12 +131,17 @@ struct lp_rasterizer
 
    /** The scene currently being rasterized by the threads */
    struct lp_scene *curr_scene;
+   int64_t curr_scene_start;  /**< for DEBUG_COUNTERS and LP_TRACE */
+   unsigned curr_scene_id;    /**< fence id, for LP_TRACE */
 
-   /** A task object for each rasterization thread */
-   struct lp_rasterizer_task tasks[LP_MAX_THREADS];
+   /** A task object for each rasterization thread, at least one */
+   struct lp_rasterizer_task *tasks;
 
    unsigned num_threads;
-   thrd_t threads[LP_MAX_THREADS];
+   /** CPU groups the threads are pinned to, see assign_rast_cpus() */
+   util_affinity_mask *cpu_domains;
+
+   thrd_t *threads;
 
    /** For synchronizing the rasterization threads */
    util_barrier barrier;
@@ -30,6 +30,7 @@
 #include "util/u_memory.h"
 #include "util/reallocarray.h"
 #include "util/u_inlines.h"
+#include "util/u_atomic.h"
 #include "util/format/u_format.h"
 #include "lp_scene.h"
 #include "lp_fence.h"
@@ -69,11 +70,19 @@ lp_scene_create(struct lp_setup_context *setup)
       return NULL;
 
    memset(scene, 0, sizeof(struct lp_scene));
+
+   scene->bin_ranges =
+      align_calloc(MAX2(1, setup->num_threads) *
+                   sizeof(struct lp_scene_bin_range), CACHE_LINE_SIZE);
+   if (!scene->bin_ranges) {
+      slab_free_st(&setup->scene_slab, scene);
+      return NULL;
+   }
+
    scene->pipe = setup->pipe;
    scene->setup = setup;
    scene->data.head = &scene->data.first;
-
-   (void) mtx_init(&scene->mutex, mtx_plain);
+   scene->max_size = LP_SCENE_MAX_SIZE;
 
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
@@ -101,9 +110,9 @@ void
 lp_scene_destroy(struct lp_scene *scene)
 {
    lp_scene_end_rasterization(scene);
-   mtx_destroy(&scene->mutex);
    free(scene->tiles);
    assert(scene->data.head == &scene->data.first);
+   align_free(scene->bin_ranges);
    slab_free_st(&scene->setup->scene_slab, scene);
 }
 
@@ -156,6 +165,55 @@ lp_scene_bin_reset(struct lp_scene *scene, unsigned x, unsigned y)
    }
 }
 
+/* Remove the color clears from a bin which holds nothing but clears,
+ * keeping any depth/stencil clears.  Used when the next command
+ * overwrites every color pixel of the tile, which makes the color clears
+ * redundant.  Returns FALSE, leaving the bin untouched, if it contains
+ * anything else.
+ */
+boolean
+lp_scene_bin_drop_color_clears(struct lp_scene *scene, unsigned x, unsigned y)
+{
+   struct cmd_bin *bin = lp_scene_get_bin(scene, x, y);
+   union lp_rast_cmd_arg zs_clears[CMD_BLOCK_MAX];
+   unsigned nr_zs_clears = 0;
+   boolean has_color_clear = FALSE;
+
+   for (struct cmd_block *block = bin->head; block; block = block->next) {
+      for (unsigned i = 0; i < block->count; i++) {
+         switch (block->cmd[i]) {
+         case LP_RAST_OP_CLEAR_COLOR:
+            has_color_clear = TRUE;
+            break;
+         case LP_RAST_OP_CLEAR_ZSTENCIL:
+            if (nr_zs_clears == CMD_BLOCK_MAX)
+               return FALSE;
+            zs_clears[nr_zs_clears++] = block->arg[i];
+            break;
+         default:
+            return FALSE;
+         }
+      }
+   }
+
+   if (!has_color_clear)
+      return FALSE;
+
+   /* The reset keeps the tail block, which has room for all the
+    * depth/stencil clears, so re-binning them can't fail.
+    */
+   lp_scene_bin_reset(scene, x, y);
+   for (unsigned i = 0; i < nr_zs_clears; i++) {
+      ASSERTED boolean ok =
+         lp_scene_bin_command(scene, x, y, LP_RAST_OP_CLEAR_ZSTENCIL,
+                              zs_clears[i]);
+      assert(ok);
+   }
+
+   return TRUE;
+}
+
+
 static void
 init_scene_texture(struct lp_scene_surface *ssurf, struct pipe_surface *psurf)
 {
@@ -360,7 +418,7 @@ lp_scene_new_cmd_block( struct lp_scene *scene,
 struct data_block *
 lp_scene_new_data_block( struct lp_scene *scene )
 {
-   if (scene->scene_size + DATA_BLOCK_SIZE > LP_SCENE_MAX_SIZE) {
+   if (scene->scene_size + DATA_BLOCK_SIZE > scene->max_size) {
       if (0) debug_printf("%s: failed\n", __FUNCTION__);
       scene->alloc_failed = TRUE;
       return NULL;
@@ -541,61 +599,109 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 
 
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
+/**
+ * Prepare the bins for rasterization by num_threads threads.
+ * The bins are grouped into BIN_GROUP_SIZE x BIN_GROUP_SIZE blocks and
+ * each thread gets a contiguous range of groups in raster order, so
+ * threads mostly work in separate bands of the framebuffer.
+ */
+void
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads )
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
-   }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
+   unsigned groups_y = DIV_ROUND_UP(scene->tiles_y, BIN_GROUP_SIZE);
+   unsigned num_groups;
+   unsigned i;
+
+   assert(num_threads >= 1 &&
+          num_threads <= MAX2(1, scene->setup->num_threads));
+
+   scene->groups_x = DIV_ROUND_UP(scene->tiles_x, BIN_GROUP_SIZE);
+   scene->num_bin_ranges = num_threads;
+
+   num_groups = scene->groups_x * groups_y;
+
+   for (i = 0; i < num_threads; i++) {
+      scene->bin_ranges[i].next = num_groups * i / num_threads;
+      scene->bin_ranges[i].end = num_groups * (i + 1) / num_threads;
    }
-   return TRUE;
 }
 
 
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene )
+lp_scene_bin_iter_init( struct lp_scene_bin_iter *iter, unsigned thread )
 {
-   scene->curr_x = scene->curr_y = -1;
+   iter->thread = thread;
+   iter->victim = thread;
+   iter->x = iter->x0 = iter->x1 = 0;
+   iter->y = iter->y1 = 0;
 }
 
 
 /**
- * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
- * Multiple rendering threads will call this function to get a chunk
- * of work (a bin) to work on.
+ * Claim the next bin group, from the thread's own range first and then
+ * from the other threads' ranges in turn.
  */
-struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
+static boolean
+next_group(struct lp_scene *scene, struct lp_scene_bin_iter *iter)
 {
-   struct cmd_bin *bin = NULL;
+   unsigned tried;
 
-   mtx_lock(&scene->mutex);
+   for (tried = 0; tried < scene->num_bin_ranges; tried++) {
+      struct lp_scene_bin_range *range = &scene->bin_ranges[iter->victim];
 
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
+      if (p_atomic_read_relaxed(&range->next) < range->end) {
+         int group = p_atomic_inc_return(&range->next) - 1;
+
+         if (group < range->end) {
+            iter->x0 = group % scene->groups_x * BIN_GROUP_SIZE;
+            iter->y = group / scene->groups_x * BIN_GROUP_SIZE;
+            iter->x1 = MIN2(iter->x0 + BIN_GROUP_SIZE, scene->tiles_x);
+            iter->y1 = MIN2(iter->y + BIN_GROUP_SIZE, scene->tiles_y);
+            iter->x = iter->x0;
+            return TRUE;
+         }
+      }
+
+      /* this range is used up, move on to the next one */
+      iter->victim = (iter->victim + 1) % scene->num_bin_ranges;
    }
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+   return FALSE;
+}
+
+
+/**
+ * Return pointer to next non-empty bin to be rendered by the thread
+ * the iterator belongs to, or NULL when all bins have been handed out.
+ * Multiple rendering threads call this function concurrently, each
+ * with its own iterator; bins within a group are returned in raster
+ * order without touching any shared state.
+ */
+struct cmd_bin *
+lp_scene_bin_iter_next( struct lp_scene *scene,
+                        struct lp_scene_bin_iter *iter,
+                        int *x, int *y)
+{
+   for (;;) {
+      while (iter->y < iter->y1) {
+         if (iter->x < iter->x1) {
+            struct cmd_bin *bin = lp_scene_get_bin(scene, iter->x, iter->y);
+
+            *x = iter->x++;
+            *y = iter->y;
 
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   mtx_unlock(&scene->mutex);
-   return bin;
+            if (bin->head)
+               return bin;
+         }
+         else {
+            iter->x = iter->x0;
+            iter->y++;
+         }
+      }
+
+      if (!next_group(scene, iter))
+         return NULL;
+   }
 }
 
 
@@ -36,6 +36,7 @@
 #define LP_SCENE_H
 
 #include "os/os_thread.h"
+#include "lp_limits.h"
 #include "lp_rast.h"
 #include "lp_debug.h"
 
@@ -59,10 +60,22 @@ struct lp_rast_state;
  */
 #define DATA_BLOCK_SIZE (64 * 1024)
 
+/* Bins are handed to the rasterizer threads in groups of
+ * BIN_GROUP_SIZE x BIN_GROUP_SIZE tiles, so that a thread renders
+ * neighbouring tiles and reuses the color/depth data they share in
+ * its caches.
+ */
+#define BIN_GROUP_SIZE 2
+
 /* Scene temporary storage is clamped to this size:
  */
 #define LP_SCENE_MAX_SIZE (36*1024*1024)
 
+/* Smallest scene size limit, used while the rasterizer is idle so that
+ * it gets work early.  See lp_setup_get_empty_scene().
+ */
+#define LP_SCENE_MIN_SIZE (2*1024*1024)
+
 /* The maximum amount of texture storage referenced by a scene is
  * clamped to this size:
  */
@@ -129,6 +142,30 @@ struct lp_scene_surface {
    unsigned nr_samples;
 };
 
+/**
+ * A range of bin groups [next, end) still to be rasterized.  The
+ * owning thread and, once their own ranges are used up, other threads
+ * claim groups with an atomic increment of 'next', so claiming never
+ * blocks.  Each range sits in its own cache line.
+ */
+struct lp_scene_bin_range {
+   alignas(CACHE_LINE_SIZE) int next;
+   int end;
+};
+
+
+/**
+ * Iteration state of a rasterizer thread: the group it is working on
+ * and the range it is stealing from.
+ */
+struct lp_scene_bin_iter {
+   unsigned thread;
+   unsigned victim;
+   int x, y;             /**< last bin returned */
+   int x0, x1, y1;       /**< bounds of the current group, in tiles */
+};
+
+
 /**
  * All bins and bin data are contained here.
  * Per-bin data goes into the 'tile' bins.
@@ -180,6 +217,14 @@ struct lp_scene {
     */
    unsigned scene_size;
 
+   /** Limit for scene_size, between LP_SCENE_MIN_SIZE and
+    * LP_SCENE_MAX_SIZE, see lp_setup_get_empty_scene().
+    */
+   unsigned max_size;
+
+   /** When binning started, for LP_DEBUG=counters */
+   int64_t bin_start_time;
+
    /** Sum of sizes of all resources referenced by the scene.  Sums
     * all the textures read by the scene:
     */
@@ -194,8 +239,13 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   mtx_t mutex;
+   /**
+    * Bin groups to rasterize, split into one contiguous range per
+    * thread, see lp_scene_bin_iter_next().
+    */
+   unsigned groups_x;
+   unsigned num_bin_ranges;
+   struct lp_scene_bin_range *bin_ranges;  /**< one per rasterizer thread */
 
    unsigned num_alloced_tiles;
    struct cmd_bin *tiles;
@@ -246,7 +296,7 @@ lp_scene_alloc(struct lp_scene *scene, unsigned size)
    if (LP_DEBUG & DEBUG_MEM)
       debug_printf("alloc %u block %u/%u tot %u/%u\n",
                    size, block->used, (unsigned)DATA_BLOCK_SIZE,
-                   scene->scene_size, LP_SCENE_MAX_SIZE);
+                   scene->scene_size, scene->max_size);
 
    if (block->used + size > DATA_BLOCK_SIZE) {
       block = lp_scene_new_data_block(scene);
@@ -280,7 +330,7 @@ lp_scene_alloc_aligned(struct lp_scene *scene, unsigned size,
       debug_printf("alloc %u block %u/%u tot %u/%u\n",
                    size + alignment - 1,
                    block->used, (unsigned)DATA_BLOCK_SIZE,
-                   scene->scene_size, LP_SCENE_MAX_SIZE);
+                   scene->scene_size, scene->max_size);
 
    if (block->used + size + alignment - 1 > DATA_BLOCK_SIZE) {
       block = lp_scene_new_data_block(scene);
@@ -310,6 +360,9 @@ lp_scene_get_bin(struct lp_scene *scene, unsigned x, unsigned y)
 void
 lp_scene_bin_reset(struct lp_scene *scene, unsigned x, unsigned y);
 
+boolean
+lp_scene_bin_drop_color_clears(struct lp_scene *scene, unsigned x, unsigned y);
+
 
 /* Add a command to bin[x][y].
  */
@@ -395,10 +448,15 @@ lp_scene_get_num_bins(const struct lp_scene *scene)
 
 
 void
-lp_scene_bin_iter_begin(struct lp_scene *scene);
+lp_scene_bin_iter_begin(struct lp_scene *scene, unsigned num_threads);
+
+void
+lp_scene_bin_iter_init(struct lp_scene_bin_iter *iter, unsigned thread);
 
 struct cmd_bin *
-lp_scene_bin_iter_next(struct lp_scene *scene, int *x, int *y);
+lp_scene_bin_iter_next(struct lp_scene *scene,
+                       struct lp_scene_bin_iter *iter,
+                       int *x, int *y);
 
 
 
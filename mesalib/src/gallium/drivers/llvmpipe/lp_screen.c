@@ -52,10 +52,14 @@
 #include "lp_rast.h"
 #include "lp_cs_tpool.h"
 #include "lp_flush.h"
+#include "lp_query.h"
+#include "lp_trace.h"
 
 #include "frontend/sw_winsys.h"
 
 #include "nir.h"
+#include "nir_serialize.h"
+#include "util/mesa-sha1.h"
 
 #ifdef DEBUG
 int LP_DEBUG = 0;
@@ -96,6 +100,7 @@ static const struct debug_named_value lp_perf_flags[] = {
    { "no_alphatest",   PERF_NO_ALPHATEST, NULL },
    { "no_rast_linear", PERF_NO_RAST_LINEAR, NULL },
    { "no_shade",       PERF_NO_SHADE, NULL },
+   { "no_hiz",         PERF_NO_HIZ, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -955,6 +960,28 @@ static void lp_disk_cache_create(struct llvmpipe_screen *screen)
    screen->disk_shader_cache = disk_cache_create("llvmpipe", cache_id, 0);
 }
 
+static int
+llvmpipe_get_driver_query_info(struct pipe_screen *_screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   static const struct pipe_driver_query_info queries[] = {
+      {"disk-shader-cache-hits", LP_QUERY_DISK_SHADER_CACHE_HITS, {0},
+       PIPE_DRIVER_QUERY_TYPE_UINT64, PIPE_DRIVER_QUERY_RESULT_TYPE_CUMULATIVE},
+      {"disk-shader-cache-misses", LP_QUERY_DISK_SHADER_CACHE_MISSES, {0},
+       PIPE_DRIVER_QUERY_TYPE_UINT64, PIPE_DRIVER_QUERY_RESULT_TYPE_CUMULATIVE},
+   };
+
+   if (!info)
+      return ARRAY_SIZE(queries);
+
+   if (index >= ARRAY_SIZE(queries))
+      return 0;
+
+   *info = queries[index];
+   return 1;
+}
+
 static struct disk_cache *lp_get_disk_shader_cache(struct pipe_screen *_screen)
 {
    struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
@@ -962,6 +989,26 @@ static struct disk_cache *lp_get_disk_shader_cache(struct pipe_screen *_screen)
    return screen->disk_shader_cache;
 }
 
+/**
+ * Hash the NIR of a shader for the disk cache keys of its variants.
+ * Done once per shader, as serializing the NIR again for every variant
+ * costs about as much as a cache hit saves for small variants.
+ */
+void lp_disk_cache_hash_nir(struct llvmpipe_screen *screen,
+                            struct nir_shader *nir,
+                            unsigned char nir_sha1[20])
+{
+   struct blob blob;
+
+   if (!screen->disk_shader_cache)
+      return;
+
+   blob_init(&blob);
+   nir_serialize(&blob, nir, true);
+   _mesa_sha1_compute(blob.data, blob.size, nir_sha1);
+   blob_finish(&blob);
+}
+
 void lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
                                struct lp_cached_code *cache,
                                unsigned char ir_sha1_cache_key[20])
@@ -1042,6 +1089,8 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
 
    LP_PERF = debug_get_flags_option("LP_PERF", lp_perf_flags, 0 );
 
+   lp_trace_init();
+
    screen = CALLOC_STRUCT(llvmpipe_screen);
    if (!screen)
       return NULL;
@@ -1078,6 +1127,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.finalize_nir = llvmpipe_finalize_nir;
 
    screen->base.get_disk_shader_cache = lp_get_disk_shader_cache;
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
    llvmpipe_init_screen_resource_funcs(&screen->base);
 
    screen->allow_cl = !!getenv("LP_CL");
@@ -1087,7 +1137,6 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->num_threads = MIN2(screen->num_threads, 2);
 #endif
    screen->num_threads = debug_get_num_option("LP_NUM_THREADS", screen->num_threads);
-   screen->num_threads = MIN2(screen->num_threads, LP_MAX_THREADS);
 
    lp_build_init(); /* get lp_native_vector_width initialised */
 
@@ -43,6 +43,7 @@
 
 struct sw_winsys;
 struct lp_cs_tpool;
+struct nir_shader;
 
 struct llvmpipe_screen
 {
@@ -78,6 +79,9 @@ struct llvmpipe_screen
    unsigned num_disk_shader_cache_misses;
 };
 
+void lp_disk_cache_hash_nir(struct llvmpipe_screen *screen,
+                            struct nir_shader *nir,
+                            unsigned char nir_sha1[20]);
 void lp_disk_cache_find_shader(struct llvmpipe_screen *screen,
                                struct lp_cached_code *cache,
                                unsigned char ir_sha1_cache_key[20]);
@@ -45,6 +45,7 @@
 #include "util/os_time.h"
 #include "lp_context.h"
 #include "lp_memory.h"
+#include "lp_perf.h"
 #include "lp_scene.h"
 #include "lp_texture.h"
 #include "lp_debug.h"
@@ -55,6 +56,7 @@
 #include "lp_screen.h"
 #include "lp_state.h"
 #include "lp_jit.h"
+#include "lp_trace.h"
 #include "frontend/sw_winsys.h"
 
 #include "draw/draw_context.h"
@@ -66,57 +68,120 @@ static boolean set_scene_state(struct lp_setup_context *, enum setup_state,
 static boolean try_update_scene_state(struct lp_setup_context *setup);
 
 
+/**
+ * Wait for the scene that was queued first to be rasterized, and
+ * return its index.
+ */
 static unsigned
 lp_setup_wait_empty_scene(struct lp_setup_context *setup)
 {
-   /* just use the first scene if we run out */
-   if (setup->scenes[0]->fence) {
-      debug_printf("%s: wait for scene %d\n",
-                   __FUNCTION__, setup->scenes[0]->fence->id);
-      lp_fence_wait(setup->scenes[0]->fence);
-      lp_scene_end_rasterization(setup->scenes[0]);
-   }
-   return 0;
+   int64_t start = 0;
+   int oldest = -1;
+
+   for (int i = 0; i < setup->num_active_scenes; i++) {
+      const struct lp_fence *fence = setup->scenes[i]->fence;
+
+      if (fence && (oldest < 0 ||
+                    (int)(fence->id - setup->scenes[oldest]->fence->id) < 0))
+         oldest = i;
+   }
+
+   if (oldest < 0)
+      return 0;
+
+   LP_DBG(DEBUG_SETUP, "%s: wait for scene %d\n",
+          __FUNCTION__, setup->scenes[oldest]->fence->id);
+
+   if ((LP_DEBUG & DEBUG_COUNTERS) || lp_trace_enabled)
+      start = os_time_get();
+
+   lp_fence_wait(setup->scenes[oldest]->fence);
+   lp_scene_end_rasterization(setup->scenes[oldest]);
+
+   if (LP_DEBUG & DEBUG_COUNTERS) {
+      lp_count.nr_scene_waits++;
+      lp_count.setup_wait_time += os_time_get() - start;
+   }
+
+   if (lp_trace_enabled) {
+      lp_trace_event("wait for scene", LP_TRACE_TID_SETUP,
+                     start, os_time_get(), NULL);
+   }
+
+   return oldest;
 }
 
 
+/**
+ * Get a scene to bin into.  Scenes are queued for rasterization as soon
+ * as they're flushed, so binning of the next scene overlaps with their
+ * rasterization.  A new scene is allocated while the scenes in flight
+ * stay within SCENE_MEMORY_BUDGET, otherwise setup waits for the oldest
+ * one.
+ *
+ * Scenes start small when the rasterizer is idle, so that it gets work
+ * early, and double in size limit for every scene queued behind another
+ * one, to amortize the per-scene costs when the rasterizer is busy.
+ */
 static void
 lp_setup_get_empty_scene(struct lp_setup_context *setup)
 {
    assert(setup->scene == NULL);
-   unsigned i;
+   unsigned in_flight = 0, in_flight_size = 0;
+   int i, free_scene = -1;
 
-   /* try and find a scene that isn't being used */
+   /* release the scenes that are done, and find one that isn't used */
    for (i = 0; i < setup->num_active_scenes; i++) {
-      if (setup->scenes[i]->fence) {
-         if (lp_fence_signalled(setup->scenes[i]->fence)) {
-            lp_scene_end_rasterization(setup->scenes[i]);
-            break;
+      struct lp_scene *scene = setup->scenes[i];
+
+      if (scene->fence) {
+         if (!lp_fence_signalled(scene->fence)) {
+            in_flight++;
+            in_flight_size += scene->scene_size;
+            continue;
          }
-      } else {
-         break;
+         lp_scene_end_rasterization(scene);
       }
+
+      if (free_scene < 0)
+         free_scene = i;
    }
 
-   if (setup->num_active_scenes + 1 > MAX_SCENES) {
-      i = lp_setup_wait_empty_scene(setup);
-   } else if (i == setup->num_active_scenes) {
-      /* allocate a new scene */
-      struct lp_scene *scene = lp_scene_create(setup);
-      if (!scene) {
-         /* block and reuse scenes */
-         i = lp_setup_wait_empty_scene(setup);
-      } else {
+   if (in_flight == 0)
+      setup->scene_max_size = LP_SCENE_MIN_SIZE;
+   else
+      setup->scene_max_size = MIN2(setup->scene_max_size * 2,
+                                   LP_SCENE_MAX_SIZE);
+
+   if (free_scene < 0) {
+      struct lp_scene *scene = NULL;
+
+      if (setup->num_active_scenes < MAX_SCENES &&
+          in_flight_size + setup->scene_max_size <= SCENE_MEMORY_BUDGET)
+         scene = lp_scene_create(setup);
+
+      if (scene) {
          LP_DBG(DEBUG_SETUP, "allocated scene: %d\n", setup->num_active_scenes);
-         setup->scenes[setup->num_active_scenes] = scene;
-         i = setup->num_active_scenes;
-         setup->num_active_scenes++;
+         free_scene = setup->num_active_scenes;
+         setup->scenes[setup->num_active_scenes++] = scene;
+      } else {
+         /* block and reuse scenes */
+         free_scene = lp_setup_wait_empty_scene(setup);
       }
    }
 
-   setup->scene = setup->scenes[i];
+   setup->scene = setup->scenes[free_scene];
    setup->scene->permit_linear_rasterizer = setup->permit_linear_rasterizer;
    lp_scene_begin_binning(setup->scene, &setup->fb);
+
+   /* Every bin needs at least one command block, e.g. for a clear */
+   setup->scene->max_size =
+      MAX2(setup->scene_max_size,
+           lp_scene_get_num_bins(setup->scene) * sizeof(struct cmd_block) +
+           2 * DATA_BLOCK_SIZE);
+
+   if ((LP_DEBUG & DEBUG_COUNTERS) || lp_trace_enabled)
+      setup->scene->bin_start_time = os_time_get();
 }
 
 
@@ -212,6 +277,19 @@ lp_setup_rasterize_scene(struct lp_setup_context *setup)
 
    lp_scene_end_binning(scene);
 
+   if (LP_DEBUG & DEBUG_COUNTERS) {
+      lp_count.nr_scenes++;
+      lp_count.setup_bin_time += os_time_get() - scene->bin_start_time;
+   }
+
+   if (lp_trace_enabled) {
+      lp_trace_event("bin scene", LP_TRACE_TID_SETUP,
+                     scene->bin_start_time, os_time_get(),
+                     "\"scene\":%u,\"tiles\":%u,\"size\":%u",
+                     scene->fence->id, lp_scene_get_num_bins(scene),
+                     scene->scene_size);
+   }
+
    mtx_lock(&screen->rast_mutex);
    lp_rast_queue_scene(screen->rast, scene);
    mtx_unlock(&screen->rast_mutex);
@@ -394,6 +472,32 @@ lp_setup_flush(struct lp_setup_context *setup,
 }
 
 
+/**
+ * Drop the pending clears of any framebuffer attachment backed by the
+ * given resource, whose contents the caller no longer needs.  Clears are
+ * only pending while the scene holds nothing else; once draws have been
+ * binned they stay, as fragment shaders may have other side effects.
+ */
+void
+lp_setup_invalidate_resource(struct lp_setup_context *setup,
+                             struct pipe_resource *resource)
+{
+   if (setup->state != SETUP_CLEARED)
+      return;
+
+   for (unsigned i = 0; i < setup->fb.nr_cbufs; i++) {
+      if (setup->fb.cbufs[i] && setup->fb.cbufs[i]->texture == resource)
+         setup->clear.flags &= ~(PIPE_CLEAR_COLOR0 << i);
+   }
+
+   if (setup->fb.zsbuf && setup->fb.zsbuf->texture == resource) {
+      setup->clear.flags &= ~PIPE_CLEAR_DEPTHSTENCIL;
+      setup->clear.zsmask = 0;
+      setup->clear.zsvalue = 0;
+   }
+}
+
+
 void
 lp_setup_bind_framebuffer(struct lp_setup_context *setup,
                           const struct pipe_framebuffer_state *fb)
@@ -1593,6 +1697,7 @@ lp_setup_create(struct pipe_context *pipe,
       goto no_scenes;
    }
    setup->num_active_scenes++;
+   setup->scene_max_size = LP_SCENE_MIN_SIZE;
 
    setup->triangle = first_triangle;
    setup->line     = first_line;
@@ -63,6 +63,10 @@ void
 lp_setup_flush(struct lp_setup_context *setup,
                const char *reason);
 
+void
+lp_setup_invalidate_resource(struct lp_setup_context *setup,
+                             struct pipe_resource *resource);
+
 void
 lp_setup_bind_framebuffer(struct lp_setup_context *setup,
                           const struct pipe_framebuffer_state *fb);
@@ -59,6 +59,11 @@ struct lp_setup_variant;
 #define INITIAL_SCENES 4
 #define MAX_SCENES 64
 
+/** Memory that scenes queued for rasterization may use, beyond which
+ * setup waits for the rasterizer instead of starting another scene.
+ */
+#define SCENE_MEMORY_BUDGET (256*1024*1024)
+
 
 
 /**
@@ -95,6 +100,7 @@ struct lp_setup_context
    int num_active_scenes;
    struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
    struct lp_scene *scene;               /**< current scene being built */
+   unsigned scene_max_size;              /**< size limit for the next scene */
 
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned active_binned_queries;
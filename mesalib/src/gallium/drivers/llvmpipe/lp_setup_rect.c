@@ -104,12 +104,19 @@ lp_setup_whole_tile(struct lp_setup_context *setup,
        * accurate query results we unfortunately need to execute the rendering
        * commands.
        */
-      if (!scene->fb.zsbuf && scene->fb_max_layer == 0 &&
-          !scene->had_queries) {
-         /*
-          * All previous rendering will be overwritten so reset the bin.
-          */
-         lp_scene_bin_reset(scene, tx, ty);
+      if (scene->fb_max_layer == 0 && !scene->had_queries) {
+         if (!scene->fb.zsbuf) {
+            /*
+             * All previous rendering will be overwritten so reset the bin.
+             */
+            lp_scene_bin_reset(scene, tx, ty);
+         } else if (lp_scene_bin_drop_color_clears(scene, tx, ty)) {
+            /*
+             * Depth/stencil must be kept, but if the tile was only
+             * cleared so far the color clear is overwritten anyway.
+             */
+            LP_COUNT(nr_color_tile_clear_elided);
+         }
       }
 
       if (inputs->is_blit) {
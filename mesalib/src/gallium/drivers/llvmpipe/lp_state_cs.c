@@ -44,6 +44,7 @@
 #include "lp_memory.h"
 #include "lp_query.h"
 #include "lp_cs_tpool.h"
+#include "lp_trace.h"
 #include "frontend/sw_winsys.h"
 #include "nir/nir_to_tgsi_info.h"
 #include "util/mesa-sha1.h"
@@ -510,6 +511,8 @@ llvmpipe_create_compute_state(struct pipe_context *pipe,
       shader->base.tokens = tgsi_dup_tokens(templ->prog);
    } else {
       nir_tgsi_scan_shader(shader->base.ir.nir, &shader->info.base, false);
+      lp_disk_cache_hash_nir(llvmpipe_screen(pipe->screen),
+                             shader->base.ir.nir, shader->nir_sha1);
    }
 
    list_inithead(&shader->variants.list);
@@ -736,22 +739,12 @@ static void
 lp_cs_get_ir_cache_key(struct lp_compute_shader_variant *variant,
                        unsigned char ir_sha1_cache_key[20])
 {
-   struct blob blob = { 0 };
-   unsigned ir_size;
-   void *ir_binary;
-
-   blob_init(&blob);
-   nir_serialize(&blob, variant->shader->base.ir.nir, true);
-   ir_binary = blob.data;
-   ir_size = blob.size;
-
    struct mesa_sha1 ctx;
    _mesa_sha1_init(&ctx);
    _mesa_sha1_update(&ctx, &variant->key, variant->shader->variant_key_size);
-   _mesa_sha1_update(&ctx, ir_binary, ir_size);
+   _mesa_sha1_update(&ctx, variant->shader->nir_sha1,
+                     sizeof(variant->shader->nir_sha1));
    _mesa_sha1_final(&ctx, ir_sha1_cache_key);
-
-   blob_finish(&blob);
 }
 
 static struct lp_compute_shader_variant *
@@ -906,6 +899,12 @@ llvmpipe_update_cs(struct llvmpipe_context *lp)
       LP_COUNT_ADD(llvm_compile_time, dt);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
 
+      if (lp_trace_enabled && variant) {
+         lp_trace_event("cs variant miss", LP_TRACE_TID_SETUP, t0, t1,
+                        "\"cs\":\"%u.%u\",\"instrs\":%u",
+                        shader->no, variant->no, variant->nr_instrs);
+      }
+
       /* Put the new variant into the list */
       if (variant) {
          list_add(&variant->list_item_local.list, &shader->variants.list);
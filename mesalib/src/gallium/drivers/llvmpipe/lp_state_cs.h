@@ -109,6 +109,9 @@ struct lp_compute_shader {
 
    uint32_t req_local_mem;
 
+   /** Hash of the NIR, for the disk cache keys of the variants */
+   unsigned char nir_sha1[20];
+
    /* For debugging/profiling purposes */
    unsigned variant_key_size;
    unsigned no;
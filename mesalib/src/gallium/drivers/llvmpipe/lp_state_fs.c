@@ -104,10 +104,10 @@
 #include "lp_flush.h"
 #include "lp_state_fs.h"
 #include "lp_rast.h"
+#include "lp_trace.h"
 #include "nir/nir_to_tgsi_info.h"
 
 #include "lp_screen.h"
-#include "compiler/nir/nir_serialize.h"
 #include "util/mesa-sha1.h"
 
 
@@ -3614,6 +3614,8 @@ lp_debug_fs_kind(enum lp_fs_kind kind)
       return "BLIT_RGBA";
    case LP_FS_KIND_BLIT_RGB1:
       return "BLIT_RGB1";
+   case LP_FS_KIND_CONST_COLOR:
+      return "CONST_COLOR";
    case LP_FS_KIND_AERO_MINIFICATION:
       return "AERO_MINIFICATION";
    case LP_FS_KIND_LLVM_LINEAR:
@@ -3646,33 +3648,22 @@ static void
 lp_fs_get_ir_cache_key(struct lp_fragment_shader_variant *variant,
                        unsigned char ir_sha1_cache_key[20])
 {
-   struct blob blob = { 0 };
-   unsigned ir_size;
-   void *ir_binary;
-
-   blob_init(&blob);
-   nir_serialize(&blob, variant->shader->base.ir.nir, true);
-   ir_binary = blob.data;
-   ir_size = blob.size;
-
    struct mesa_sha1 ctx;
    _mesa_sha1_init(&ctx);
    _mesa_sha1_update(&ctx, &variant->key, variant->shader->variant_key_size);
-   _mesa_sha1_update(&ctx, ir_binary, ir_size);
+   _mesa_sha1_update(&ctx, variant->shader->nir_sha1,
+                     sizeof(variant->shader->nir_sha1));
    _mesa_sha1_final(&ctx, ir_sha1_cache_key);
-
-   blob_finish(&blob);
 }
 
 
 /**
- * Generate a new fragment shader variant from the shader code and
- * other state indicated by the key.
+ * Allocate a fragment shader variant for the given key, without any code.
  */
 static struct lp_fragment_shader_variant *
-generate_variant(struct llvmpipe_context *lp,
-                 struct lp_fragment_shader *shader,
-                 const struct lp_fragment_shader_variant_key *key)
+alloc_variant(struct llvmpipe_context *lp,
+              struct lp_fragment_shader *shader,
+              const struct lp_fragment_shader_variant_key *key)
 {
    struct lp_fragment_shader_variant *variant =
       MALLOC(sizeof *variant + shader->variant_key_size - sizeof variant->key);
@@ -3686,30 +3677,41 @@ generate_variant(struct llvmpipe_context *lp,
 
    memcpy(&variant->key, key, shader->variant_key_size);
 
-   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
-   struct lp_cached_code cached = { 0 };
-   unsigned char ir_sha1_cache_key[20];
-   bool needs_caching = false;
-   if (shader->base.ir.nir) {
-      lp_fs_get_ir_cache_key(variant, ir_sha1_cache_key);
+   variant->list_item_global.base = variant;
+   variant->list_item_local.base = variant;
+   variant->no = shader->variants_created++;
+
+   return variant;
+}
 
-      lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
-      if (!cached.data_size)
-         needs_caching = true;
-   }
+
+/**
+ * Build and compile the code of a fragment shader variant.
+ *
+ * \param shader  the shader to build the IR from: variant->shader, or a
+ *                copy of it with its own NIR when compiling in the
+ *                background, as building the IR modifies the NIR.
+ * \param generic  skip the code that is only an optimization, i.e. the
+ *                 opaque whole-tile function and the linear path, and
+ *                 set *deferred if there was any.
+ */
+static boolean
+compile_variant(struct llvmpipe_context *lp,
+                LLVMContextRef context,
+                struct lp_fragment_shader *shader,
+                struct lp_fragment_shader_variant *variant,
+                struct lp_cached_code *cached,
+                boolean generic,
+                boolean *deferred)
+{
+   const struct lp_fragment_shader_variant_key *key = &variant->key;
 
    char module_name[64];
    snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
-            shader->no, shader->variants_created);
-   variant->gallivm = gallivm_create(module_name, lp->context, &cached);
-   if (!variant->gallivm) {
-      FREE(variant);
-      return NULL;
-   }
-
-   variant->list_item_global.base = variant;
-   variant->list_item_local.base = variant;
-   variant->no = shader->variants_created++;
+            shader->no, variant->no);
+   variant->gallivm = gallivm_create(module_name, context, cached);
+   if (!variant->gallivm)
+      return FALSE;
 
    /*
     * Determine whether we are touching all channels in the color buffer.
@@ -3742,6 +3744,36 @@ generate_variant(struct llvmpipe_context *lp,
          !key->blend.rt[0].blend_enable
          ? TRUE : FALSE;
 
+   const boolean depth_less =
+         key->depth.enabled &&
+         (key->depth.func == PIPE_FUNC_LESS ||
+          key->depth.func == PIPE_FUNC_LEQUAL);
+
+   variant->hiz_cull =
+         depth_less &&
+         !key->stencil[0].enabled &&
+         !shader->info.base.writes_z &&
+         !shader->info.base.writes_memory
+         ? TRUE : FALSE;
+
+   variant->hiz_lower =
+         variant->hiz_cull &&
+         key->depth.writemask &&
+         !key->alpha.enabled &&
+         !key->multisample &&
+         !key->blend.alpha_to_coverage &&
+         !shader->info.base.uses_kill &&
+         !shader->info.base.writes_samplemask
+         ? TRUE : FALSE;
+
+   variant->hiz_clobber =
+         key->depth.enabled &&
+         key->depth.writemask &&
+         !depth_less &&
+         key->depth.func != PIPE_FUNC_EQUAL &&
+         key->depth.func != PIPE_FUNC_NEVER
+         ? TRUE : FALSE;
+
    variant->potentially_opaque =
          no_kill &&
          !key->blend.logicop_enable &&
@@ -3807,8 +3839,6 @@ generate_variant(struct llvmpipe_context *lp,
          (key->cbuf_format[0] == PIPE_FORMAT_B8G8R8A8_UNORM ||
           key->cbuf_format[0] == PIPE_FORMAT_B8G8R8X8_UNORM);
 
-   memcpy(&variant->key, key, sizeof *key);
-
    if ((LP_DEBUG & DEBUG_FS) || (gallivm_debug & GALLIVM_DEBUG_IR)) {
       lp_debug_fs_variant(variant);
    }
@@ -3823,7 +3853,10 @@ generate_variant(struct llvmpipe_context *lp,
    if (variant->jit_function[RAST_WHOLE] == NULL) {
       if (variant->opaque) {
          /* Specialized shader, which doesn't need to read the color buffer. */
-         generate_fragment(lp, shader, variant, RAST_WHOLE);
+         if (generic)
+            *deferred = TRUE;
+         else
+            generate_fragment(lp, shader, variant, RAST_WHOLE);
       }
    }
 
@@ -3846,8 +3879,12 @@ generate_variant(struct llvmpipe_context *lp,
       if (variant->jit_linear == NULL) {
          if (shader->kind == LP_FS_KIND_BLIT_RGBA ||
              shader->kind == LP_FS_KIND_BLIT_RGB1 ||
+             shader->kind == LP_FS_KIND_CONST_COLOR ||
              shader->kind == LP_FS_KIND_LLVM_LINEAR) {
-            llvmpipe_fs_variant_linear_llvm(lp, shader, variant);
+            if (generic)
+               *deferred = TRUE;
+            else
+               llvmpipe_fs_variant_linear_llvm(lp, shader, variant);
          }
       }
    } else {
@@ -3893,11 +3930,220 @@ generate_variant(struct llvmpipe_context *lp,
       lp_linear_check_variant(variant);
    }
 
-   if (needs_caching) {
-      lp_disk_cache_insert_shader(screen, &cached, ir_sha1_cache_key);
+   gallivm_free_ir(variant->gallivm);
+
+   return TRUE;
+}
+
+
+/**
+ * Background compilation of the fully specialized version of a variant
+ * that was compiled generic, see LP_ASYNC_COMPILE.
+ */
+struct lp_fs_async_job
+{
+   struct util_queue_fence fence;
+   struct llvmpipe_context *lp;
+
+   /** Set when the generic variant went away before the job finished,
+    * the job is then on lp->fs_async_orphans until it's done.
+    */
+   boolean abandoned;
+   struct list_head orphan_link;
+
+   /** Copy of the shader with its own NIR */
+   struct lp_fragment_shader ir_shader;
+
+   /** The specialized variant, compiled by the job */
+   struct lp_fragment_shader_variant *variant;
+   boolean compiled;
+
+   struct lp_cached_code cached;
+   unsigned char ir_sha1_cache_key[20];
+   boolean needs_caching;
+};
+
+
+static void
+async_compile_execute(void *data, void *gdata, int thread_index)
+{
+   struct lp_fs_async_job *job = data;
+   struct lp_fragment_shader_variant *variant = job->variant;
+   boolean deferred = FALSE;
+
+   if (p_atomic_read(&job->abandoned))
+      return;
+
+   job->compiled = compile_variant(job->lp, variant->context, &job->ir_shader,
+                                   variant, &job->cached, FALSE, &deferred);
+
+   if (job->compiled && job->needs_caching) {
+      lp_disk_cache_insert_shader(llvmpipe_screen(job->lp->pipe.screen),
+                                  &job->cached, job->ir_sha1_cache_key);
    }
+}
 
-   gallivm_free_ir(variant->gallivm);
+
+/**
+ * Runs after the job's fence is signalled, so once a draw sees the
+ * count change, finish_async_variant() will find the job done.  The job
+ * may already be freed here, so only the context is touched.
+ */
+static void
+async_compile_cleanup(void *data, void *gdata, int thread_index)
+{
+   struct llvmpipe_context *lp = gdata;
+
+   p_atomic_inc(&lp->fs_async_done);
+}
+
+
+/**
+ * Queue the compilation of the specialized version of a generic variant.
+ * It gets its own LLVM context, as those can't be shared across threads.
+ */
+static void
+queue_async_variant(struct llvmpipe_context *lp,
+                    struct lp_fragment_shader_variant *generic,
+                    const unsigned char ir_sha1_cache_key[20],
+                    boolean needs_caching)
+{
+   struct lp_fragment_shader *shader = generic->shader;
+   struct lp_fs_async_job *job = CALLOC_STRUCT(lp_fs_async_job);
+   if (!job)
+      return;
+
+   job->variant = alloc_variant(lp, shader, &generic->key);
+   if (!job->variant) {
+      FREE(job);
+      return;
+   }
+
+   job->variant->context = LLVMContextCreate();
+   if (!job->variant->context) {
+      llvmpipe_destroy_shader_variant(lp, job->variant);
+      FREE(job);
+      return;
+   }
+#if LLVM_VERSION_MAJOR >= 15
+   LLVMContextSetOpaquePointers(job->variant->context, false);
+#endif
+
+   job->lp = lp;
+   job->ir_shader = *shader;
+   if (shader->base.ir.nir)
+      job->ir_shader.base.ir.nir = nir_shader_clone(NULL, shader->base.ir.nir);
+   memcpy(job->ir_sha1_cache_key, ir_sha1_cache_key,
+          sizeof(job->ir_sha1_cache_key));
+   job->needs_caching = needs_caching;
+
+   util_queue_fence_init(&job->fence);
+   generic->async_job = job;
+
+   util_queue_add_job(&lp->fs_compile_queue, job, &job->fence,
+                      async_compile_execute, async_compile_cleanup, 0);
+}
+
+
+/**
+ * Free a background compilation job and the variant it compiled, unless
+ * that was taken over.  A job that is still queued or running is not
+ * waited for, but put on the orphan list and freed once it's done.
+ */
+static void
+free_async_job(struct llvmpipe_context *lp, struct lp_fs_async_job *job)
+{
+   if (!util_queue_fence_is_signalled(&job->fence)) {
+      p_atomic_set(&job->abandoned, TRUE);
+      list_addtail(&job->orphan_link, &lp->fs_async_orphans);
+      return;
+   }
+
+   util_queue_fence_destroy(&job->fence);
+
+   if (job->variant)
+      llvmpipe_destroy_shader_variant(lp, job->variant);
+   ralloc_free(job->ir_shader.base.ir.nir);
+   FREE(job);
+}
+
+
+/**
+ * Free the orphaned jobs which have finished.
+ */
+static void
+reap_async_jobs(struct llvmpipe_context *lp)
+{
+   list_for_each_entry_safe(struct lp_fs_async_job, job,
+                            &lp->fs_async_orphans, orphan_link) {
+      if (util_queue_fence_is_signalled(&job->fence)) {
+         list_del(&job->orphan_link);
+         free_async_job(lp, job);
+      }
+   }
+}
+
+
+/**
+ * Stop background compilation and free all outstanding jobs.
+ */
+void
+llvmpipe_fs_async_fini(struct llvmpipe_context *lp)
+{
+   if (!lp->fs_async)
+      return;
+
+   /* This signals the fences of jobs that never got to run */
+   util_queue_destroy(&lp->fs_compile_queue);
+   reap_async_jobs(lp);
+   assert(list_is_empty(&lp->fs_async_orphans));
+}
+
+
+/**
+ * Generate a new fragment shader variant from the shader code and
+ * other state indicated by the key.
+ *
+ * With LP_ASYNC_COMPILE, variants that aren't in the disk cache are
+ * compiled generic first, and specialized in the background.
+ */
+static struct lp_fragment_shader_variant *
+generate_variant(struct llvmpipe_context *lp,
+                 struct lp_fragment_shader *shader,
+                 const struct lp_fragment_shader_variant_key *key)
+{
+   struct lp_fragment_shader_variant *variant = alloc_variant(lp, shader, key);
+   if (!variant)
+      return NULL;
+
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+   struct lp_cached_code cached = { 0 };
+   unsigned char ir_sha1_cache_key[20];
+   bool needs_caching = false;
+   if (shader->base.ir.nir) {
+      lp_fs_get_ir_cache_key(variant, ir_sha1_cache_key);
+
+      lp_disk_cache_find_shader(screen, &cached, ir_sha1_cache_key);
+      if (!cached.data_size)
+         needs_caching = true;
+   }
+
+   const boolean generic = lp->fs_async && !cached.data_size;
+   boolean deferred = FALSE;
+
+   if (!compile_variant(lp, lp->context, shader, variant, &cached,
+                        generic, &deferred)) {
+      lp_fs_reference(lp, &variant->shader, NULL);
+      FREE(variant);
+      return NULL;
+   }
+
+   if (deferred) {
+      /* The generic code must not end up in the disk cache */
+      queue_async_variant(lp, variant, ir_sha1_cache_key, needs_caching);
+   } else if (needs_caching) {
+      lp_disk_cache_insert_shader(screen, &cached, ir_sha1_cache_key);
+   }
 
    return variant;
 }
@@ -3927,6 +4173,8 @@ llvmpipe_create_fs_state(struct pipe_context *pipe,
    } else {
       shader->base.ir.nir = templ->ir.nir;
       nir_tgsi_scan_shader(templ->ir.nir, &shader->info.base, true);
+      lp_disk_cache_hash_nir(llvmpipe_screen(pipe->screen),
+                             shader->base.ir.nir, shader->nir_sha1);
    }
 
    shader->draw_data = draw_create_fragment_shader(llvmpipe->draw, templ);
@@ -4061,7 +4309,13 @@ void
 llvmpipe_destroy_shader_variant(struct llvmpipe_context *lp,
                                 struct lp_fragment_shader_variant *variant)
 {
-   gallivm_destroy(variant->gallivm);
+   if (variant->async_job)
+      free_async_job(lp, variant->async_job);
+
+   if (variant->gallivm)
+      gallivm_destroy(variant->gallivm);
+   if (variant->context)
+      LLVMContextDispose(variant->context);
    lp_fs_reference(lp, &variant->shader, NULL);
    FREE(variant);
 }
@@ -4529,6 +4783,45 @@ make_variant_key(struct llvmpipe_context *lp,
 }
 
 
+/**
+ * Replace a generic variant by its specialized version once the latter
+ * has been compiled.  Returns the variant to use.
+ */
+static struct lp_fragment_shader_variant *
+finish_async_variant(struct llvmpipe_context *lp,
+                     struct lp_fragment_shader_variant *generic)
+{
+   struct lp_fs_async_job *job = generic->async_job;
+   struct lp_fragment_shader *shader = generic->shader;
+
+   if (!util_queue_fence_is_signalled(&job->fence))
+      return generic;
+
+   generic->async_job = NULL;
+
+   if (!job->compiled) {
+      /* keep drawing with the generic variant */
+      free_async_job(lp, job);
+      return generic;
+   }
+
+   struct lp_fragment_shader_variant *variant = job->variant;
+   job->variant = NULL;
+   free_async_job(lp, job);
+
+   list_add(&variant->list_item_local.list, &generic->list_item_local.list);
+   list_add(&variant->list_item_global.list, &generic->list_item_global.list);
+   lp->nr_fs_variants++;
+   lp->nr_fs_instrs += variant->nr_instrs;
+   shader->variants_cached++;
+
+   llvmpipe_remove_shader_variant(lp, generic);
+   lp_fs_variant_reference(lp, &generic, NULL);
+
+   return variant;
+}
+
+
 /**
  * Update fragment shader state.  This is called just prior to drawing
  * something when some fragment-related state has changed.
@@ -4538,6 +4831,9 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
 {
    struct lp_fragment_shader *shader = lp->fs;
 
+   if (lp->fs_async)
+      reap_async_jobs(lp);
+
    char store[LP_FS_MAX_VARIANT_KEY_SIZE];
    const struct lp_fragment_shader_variant_key *key =
       make_variant_key(lp, shader, store);
@@ -4553,6 +4849,9 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
    }
 
    if (variant) {
+      if (variant->async_job)
+         variant = finish_async_variant(lp, variant);
+
       /* Move this variant to the head of the list to implement LRU
        * deletion of shader's when we have too many.
        */
@@ -4618,6 +4917,12 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       LP_COUNT_ADD(llvm_compile_time, dt);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
 
+      if (lp_trace_enabled && variant) {
+         lp_trace_event("fs variant miss", LP_TRACE_TID_SETUP, t0, t1,
+                        "\"fs\":\"%u.%u\",\"instrs\":%u",
+                        shader->no, variant->no, variant->nr_instrs);
+      }
+
       /* Put the new variant into the list */
       if (variant) {
          list_add(&variant->list_item_local.list, &shader->variants.list);
@@ -42,6 +42,7 @@
 
 struct tgsi_token;
 struct lp_fragment_shader;
+struct lp_fs_async_job;
 
 
 /** Indexes into jit_function[] array */
@@ -54,6 +55,7 @@ enum lp_fs_kind
    LP_FS_KIND_GENERAL = 0,
    LP_FS_KIND_BLIT_RGBA,
    LP_FS_KIND_BLIT_RGB1,
+   LP_FS_KIND_CONST_COLOR,
    LP_FS_KIND_AERO_MINIFICATION,
    LP_FS_KIND_LLVM_LINEAR
 };
@@ -168,11 +170,31 @@ struct lp_fragment_shader_variant
 
    unsigned opaque:1;
    unsigned blit:1;
+
+   /* Hierarchical Z, see lp_rast_hiz_cull():  whether fragments which are
+    * known to fail the depth test can be skipped without other effects,
+    * whether a tile fully covered by a primitive is left with depth no
+    * greater than the primitive's, and whether depth may be written with
+    * values greater than the previous ones.
+    */
+   unsigned hiz_cull:1;
+   unsigned hiz_lower:1;
+   unsigned hiz_clobber:1;
    unsigned linear_input_mask:16;
    struct pipe_reference reference;
 
    struct gallivm_state *gallivm;
 
+   /* LLVM context owned by the variant, if it was compiled in the
+    * background rather than in the llvmpipe context's.
+    */
+   LLVMContextRef context;
+
+   /* Pending background compilation of the fully specialized version of
+    * this variant, which replaces it once done (LP_ASYNC_COMPILE).
+    */
+   struct lp_fs_async_job *async_job;
+
    LLVMTypeRef jit_context_ptr_type;
    LLVMTypeRef jit_thread_data_ptr_type;
    LLVMTypeRef jit_linear_context_ptr_type;
@@ -217,10 +239,19 @@ struct lp_fragment_shader
    /* Analysis results */
    enum lp_fs_kind kind;
 
+   /* LP_FS_KIND_CONST_COLOR: the color, or if const_color_offset isn't
+    * negative, where it is in constant buffer 0, in floats.
+    */
+   float const_color[4];
+   int const_color_offset;
+
    struct lp_fs_variant_list_item variants;
 
    struct draw_fragment_shader *draw_data;
 
+   /** Hash of the NIR, for the disk cache keys of the variants */
+   unsigned char nir_sha1[20];
+
    /* For debugging/profiling purposes */
    unsigned variant_key_size;
    unsigned no;
@@ -174,6 +174,268 @@ finished:
 }
 
 
+/*
+ * Check that the shader does exactly one 2D texture fetch, with the
+ * coordinates taken unmodified from its only input.
+ */
+static boolean
+is_blit_texture(const struct lp_tgsi_info *info)
+{
+   const struct lp_tgsi_texture_info *tex = &info->tex[0];
+
+   return info->base.num_inputs == 1 &&
+          info->num_texs == 1 &&
+          tex->target == TGSI_TEXTURE_2D &&
+          tex->modifier == LP_BLD_TEX_MODIFIER_NONE &&
+          tex->sampler_unit == 0 &&
+          tex->texture_unit == 0 &&
+          tex->coord[0].file == TGSI_FILE_INPUT &&
+          tex->coord[0].u.index == 0 &&
+          tex->coord[0].swizzle == 0 &&
+          tex->coord[1].file == TGSI_FILE_INPUT &&
+          tex->coord[1].u.index == 0 &&
+          tex->coord[1].swizzle == 1;
+}
+
+
+/*
+ * Detect blit shaders, ie. a single 2D texture fetch with the coordinates
+ * of the only input written straight to the color output:
+ *
+ *   FRAG
+ *   DCL IN[0], GENERIC[0], LINEAR
+ *   DCL OUT[0], COLOR
+ *   DCL SAMP[0]
+ *   DCL SVIEW[0], 2D, FLOAT
+ *   TEX OUT[0], IN[0], SAMP[0], 2D
+ *   END
+ *
+ * or the variation which forces alpha to one, as used to present XRGB
+ * surfaces:
+ *
+ *   IMM[0] FLT32 {    1.0000,    0.0000,    0.0000,    0.0000 }
+ *   TEX OUT[0].xyz, IN[0], SAMP[0], 2D
+ *   MOV OUT[0].w, IMM[0].xxxx
+ *   END
+ *
+ * These are what compositors use for most of their draws, and the blit
+ * kinds enable the copy and premultiplied blend fastpaths in
+ * lp_state_fs_linear.c and lp_linear_fastpath.c.
+ */
+static enum lp_fs_kind
+match_blit_shader(const struct tgsi_token *tokens,
+                  const struct lp_tgsi_info *info)
+{
+   struct tgsi_parse_context parse;
+   float imm[8][4] = {{0}};
+   unsigned num_imms = 0;
+   unsigned tex_mask = 0;
+   boolean alpha_one = FALSE;
+   boolean ok = TRUE;
+
+   if (!is_blit_texture(info) ||
+       info->base.opcode_count[TGSI_OPCODE_TEX] != 1)
+      return LP_FS_KIND_GENERAL;
+
+   tgsi_parse_init(&parse, tokens);
+
+   while (ok && !tgsi_parse_end_of_tokens(&parse)) {
+      tgsi_parse_token(&parse);
+
+      switch (parse.FullToken.Token.Type) {
+      case TGSI_TOKEN_TYPE_DECLARATION:
+      case TGSI_TOKEN_TYPE_PROPERTY:
+         break;
+
+      case TGSI_TOKEN_TYPE_IMMEDIATE:
+         {
+            const unsigned size =
+                  parse.FullToken.FullImmediate.Immediate.NrTokens - 1;
+            if (num_imms >= ARRAY_SIZE(imm)) {
+               ok = FALSE;
+               break;
+            }
+            for (unsigned chan = 0; chan < size; ++chan)
+               imm[num_imms][chan] = parse.FullToken.FullImmediate.u[chan].Float;
+            num_imms++;
+         }
+         break;
+
+      case TGSI_TOKEN_TYPE_INSTRUCTION:
+         {
+            const struct tgsi_full_instruction *inst =
+               &parse.FullToken.FullInstruction;
+            const struct tgsi_full_dst_register *dst = &inst->Dst[0];
+            const struct tgsi_full_src_register *src = &inst->Src[0];
+
+            switch (inst->Instruction.Opcode) {
+            case TGSI_OPCODE_TEX:
+               if (inst->Instruction.Saturate ||
+                   dst->Register.File != TGSI_FILE_OUTPUT ||
+                   dst->Register.Index != 0 ||
+                   (dst->Register.WriteMask != TGSI_WRITEMASK_XYZW &&
+                    dst->Register.WriteMask != TGSI_WRITEMASK_XYZ) ||
+                   src->Register.Absolute ||
+                   src->Register.Negate)
+                  ok = FALSE;
+               tex_mask = dst->Register.WriteMask;
+               break;
+            case TGSI_OPCODE_MOV:
+               if (inst->Instruction.Saturate ||
+                   dst->Register.File != TGSI_FILE_OUTPUT ||
+                   dst->Register.Index != 0 ||
+                   dst->Register.WriteMask != TGSI_WRITEMASK_W ||
+                   src->Register.File != TGSI_FILE_IMMEDIATE ||
+                   src->Register.Indirect ||
+                   src->Register.Index >= num_imms ||
+                   src->Register.Absolute ||
+                   src->Register.Negate ||
+                   imm[src->Register.Index][src->Register.SwizzleW] != 1.0f)
+                  ok = FALSE;
+               alpha_one = TRUE;
+               break;
+            case TGSI_OPCODE_RET:
+            case TGSI_OPCODE_END:
+               break;
+            default:
+               ok = FALSE;
+               break;
+            }
+         }
+         break;
+
+      default:
+         ok = FALSE;
+         break;
+      }
+   }
+
+   tgsi_parse_free(&parse);
+
+   if (!ok)
+      return LP_FS_KIND_GENERAL;
+
+   if (tex_mask == TGSI_WRITEMASK_XYZW && !alpha_one)
+      return LP_FS_KIND_BLIT_RGBA;
+
+   if (tex_mask == TGSI_WRITEMASK_XYZ && alpha_one)
+      return LP_FS_KIND_BLIT_RGB1;
+
+   return LP_FS_KIND_GENERAL;
+}
+
+
+/*
+ * Detect shaders which write a constant color, either an immediate or a
+ * vec4 of the first constant buffer, straight to the color output:
+ *
+ *   FRAG
+ *   DCL OUT[0], COLOR
+ *   DCL CONST[0][0]
+ *   MOV OUT[0], CONST[0][0]
+ *   END
+ *
+ * Compositors draw solid fills, shadows and dimming this way, mostly
+ * with premultiplied alpha blending.  Where the color comes from is
+ * recorded in the shader for the fill and blend fastpaths in
+ * lp_state_fs_linear.c.
+ */
+static boolean
+match_const_color_shader(const struct tgsi_token *tokens,
+                         struct lp_fragment_shader *shader)
+{
+   const struct lp_tgsi_info *info = &shader->info;
+   struct tgsi_parse_context parse;
+   float imm[8][4] = {{0}};
+   unsigned num_imms = 0;
+   boolean ok = TRUE;
+
+   if (info->num_texs != 0 ||
+       info->base.output_semantic_name[0] != TGSI_SEMANTIC_COLOR ||
+       info->base.opcode_count[TGSI_OPCODE_MOV] != 1)
+      return FALSE;
+
+   tgsi_parse_init(&parse, tokens);
+
+   while (ok && !tgsi_parse_end_of_tokens(&parse)) {
+      tgsi_parse_token(&parse);
+
+      switch (parse.FullToken.Token.Type) {
+      case TGSI_TOKEN_TYPE_DECLARATION:
+      case TGSI_TOKEN_TYPE_PROPERTY:
+         break;
+
+      case TGSI_TOKEN_TYPE_IMMEDIATE:
+         {
+            const unsigned size =
+                  parse.FullToken.FullImmediate.Immediate.NrTokens - 1;
+            if (num_imms >= ARRAY_SIZE(imm)) {
+               ok = FALSE;
+               break;
+            }
+            for (unsigned chan = 0; chan < size; ++chan)
+               imm[num_imms][chan] = parse.FullToken.FullImmediate.u[chan].Float;
+            num_imms++;
+         }
+         break;
+
+      case TGSI_TOKEN_TYPE_INSTRUCTION:
+         {
+            const struct tgsi_full_instruction *inst =
+               &parse.FullToken.FullInstruction;
+            const struct tgsi_full_dst_register *dst = &inst->Dst[0];
+            const struct tgsi_full_src_register *src = &inst->Src[0];
+
+            switch (inst->Instruction.Opcode) {
+            case TGSI_OPCODE_MOV:
+               if (inst->Instruction.Saturate ||
+                   dst->Register.File != TGSI_FILE_OUTPUT ||
+                   dst->Register.Index != 0 ||
+                   dst->Register.WriteMask != TGSI_WRITEMASK_XYZW ||
+                   src->Register.Indirect ||
+                   src->Register.Absolute ||
+                   src->Register.Negate ||
+                   src->Register.SwizzleX != TGSI_SWIZZLE_X ||
+                   src->Register.SwizzleY != TGSI_SWIZZLE_Y ||
+                   src->Register.SwizzleZ != TGSI_SWIZZLE_Z ||
+                   src->Register.SwizzleW != TGSI_SWIZZLE_W) {
+                  ok = FALSE;
+               } else if (src->Register.File == TGSI_FILE_IMMEDIATE &&
+                          src->Register.Index < num_imms) {
+                  memcpy(shader->const_color, imm[src->Register.Index],
+                         sizeof shader->const_color);
+                  shader->const_color_offset = -1;
+               } else if (src->Register.File == TGSI_FILE_CONSTANT &&
+                          (!src->Register.Dimension ||
+                           (!src->Dimension.Indirect &&
+                            src->Dimension.Index == 0))) {
+                  shader->const_color_offset = src->Register.Index * 4;
+               } else {
+                  ok = FALSE;
+               }
+               break;
+            case TGSI_OPCODE_RET:
+            case TGSI_OPCODE_END:
+               break;
+            default:
+               ok = FALSE;
+               break;
+            }
+         }
+         break;
+
+      default:
+         ok = FALSE;
+         break;
+      }
+   }
+
+   tgsi_parse_free(&parse);
+
+   return ok;
+}
+
+
 /*
  * Determine whether the given alu src comes directly from an input
  * register.  If so, return true and the input register index and
@@ -431,6 +693,152 @@ llvmpipe_nir_fn_is_linear_compat(const struct nir_shader *shader,
 }
 
 
+/*
+ * Return the only store of a NIR fragment shader, if it writes all of the
+ * color output with an SSA value, or NULL otherwise.
+ */
+static const nir_intrinsic_instr *
+get_nir_color_store(struct nir_shader *shader)
+{
+   const nir_intrinsic_instr *store = NULL;
+
+   nir_foreach_function(function, shader) {
+      if (!function->impl)
+         continue;
+      nir_foreach_block(block, function->impl) {
+         nir_foreach_instr(instr, block) {
+            if (instr->type != nir_instr_type_intrinsic)
+               continue;
+            nir_intrinsic_instr *intrin = nir_instr_as_intrinsic(instr);
+            if (intrin->intrinsic != nir_intrinsic_store_deref)
+               continue;
+            if (store)
+               return NULL;
+            store = intrin;
+         }
+      }
+   }
+
+   if (!store ||
+       !store->src[0].is_ssa ||
+       !store->src[1].is_ssa ||
+       nir_intrinsic_write_mask(store) != 0xf)
+      return NULL;
+
+   const nir_deref_instr *deref = nir_src_as_deref(store->src[0]);
+   if (!deref ||
+       deref->deref_type != nir_deref_type_var ||
+       deref->var->data.mode != nir_var_shader_out ||
+       (deref->var->data.location != FRAG_RESULT_COLOR &&
+        deref->var->data.location != FRAG_RESULT_DATA0))
+      return NULL;
+
+   return store;
+}
+
+
+/*
+ * NIR counterpart of match_blit_shader(): the color output store writes
+ * either the texture fetch itself, or vec4(tex.x, tex.y, tex.z, 1.0) of
+ * a single fetch with no source modifiers or saturate.
+ * Must be called after llvmpipe_nir_is_linear_compat() has filled in
+ * the texture info.
+ */
+static enum lp_fs_kind
+match_blit_shader_nir(struct nir_shader *shader,
+                      const struct lp_tgsi_info *info)
+{
+   if (!is_blit_texture(info))
+      return LP_FS_KIND_GENERAL;
+
+   const nir_intrinsic_instr *store = get_nir_color_store(shader);
+   if (!store)
+      return LP_FS_KIND_GENERAL;
+
+   const nir_instr *value = store->src[1].ssa->parent_instr;
+   if (value->type == nir_instr_type_tex)
+      return LP_FS_KIND_BLIT_RGBA;
+
+   if (value->type != nir_instr_type_alu)
+      return LP_FS_KIND_GENERAL;
+
+   const nir_alu_instr *alu = nir_instr_as_alu(value);
+   if (alu->op != nir_op_vec4 || alu->dest.saturate)
+      return LP_FS_KIND_GENERAL;
+
+   for (unsigned c = 0; c < 4; c++) {
+      if (alu->src[c].negate || alu->src[c].abs)
+         return LP_FS_KIND_GENERAL;
+   }
+
+   /* x, y and z must be the matching channels of one texture fetch. */
+   if (!alu->src[0].src.is_ssa ||
+       alu->src[0].src.ssa->parent_instr->type != nir_instr_type_tex)
+      return LP_FS_KIND_GENERAL;
+
+   const nir_ssa_def *texel = alu->src[0].src.ssa;
+
+   for (unsigned c = 0; c < 3; c++) {
+      if (!alu->src[c].src.is_ssa ||
+          alu->src[c].src.ssa != texel ||
+          alu->src[c].swizzle[0] != c)
+         return LP_FS_KIND_GENERAL;
+   }
+
+   if (!nir_src_is_const(alu->src[3].src) ||
+       nir_src_comp_as_float(alu->src[3].src, alu->src[3].swizzle[0]) != 1.0)
+      return LP_FS_KIND_GENERAL;
+
+   return LP_FS_KIND_BLIT_RGB1;
+}
+
+
+/*
+ * NIR counterpart of match_const_color_shader(): the color output store
+ * writes a vec4 immediate, or a vec4 loaded from a constant offset of
+ * the first constant buffer.
+ */
+static boolean
+match_const_color_shader_nir(struct nir_shader *nir,
+                             struct lp_fragment_shader *shader)
+{
+   if (shader->info.num_texs != 0)
+      return FALSE;
+
+   const nir_intrinsic_instr *store = get_nir_color_store(nir);
+   if (!store)
+      return FALSE;
+
+   const nir_ssa_def *value = store->src[1].ssa;
+   if (value->num_components != 4 || value->bit_size != 32)
+      return FALSE;
+
+   if (value->parent_instr->type == nir_instr_type_load_const) {
+      const nir_load_const_instr *load =
+         nir_instr_as_load_const(value->parent_instr);
+      for (unsigned c = 0; c < 4; c++)
+         shader->const_color[c] = load->value[c].f32;
+      shader->const_color_offset = -1;
+      return TRUE;
+   }
+
+   if (value->parent_instr->type != nir_instr_type_intrinsic)
+      return FALSE;
+
+   const nir_intrinsic_instr *load =
+      nir_instr_as_intrinsic(value->parent_instr);
+   if (load->intrinsic != nir_intrinsic_load_ubo ||
+       !nir_src_is_const(load->src[0]) ||
+       nir_src_as_uint(load->src[0]) != 0 ||
+       !nir_src_is_const(load->src[1]) ||
+       nir_src_as_uint(load->src[1]) % 4 != 0)
+      return FALSE;
+
+   shader->const_color_offset = nir_src_as_uint(load->src[1]) / 4;
+   return TRUE;
+}
+
+
 static bool
 llvmpipe_nir_is_linear_compat(struct nir_shader *shader,
                               struct lp_tgsi_info *info)
@@ -462,6 +870,15 @@ llvmpipe_fs_analyse_nir(struct lp_fragment_shader *shader)
    } else {
       shader->kind = LP_FS_KIND_GENERAL;
    }
+
+   if (shader->kind == LP_FS_KIND_LLVM_LINEAR) {
+      enum lp_fs_kind blit = match_blit_shader_nir(shader->base.ir.nir,
+                                                   &shader->info);
+      if (blit != LP_FS_KIND_GENERAL)
+         shader->kind = blit;
+      else if (match_const_color_shader_nir(shader->base.ir.nir, shader))
+         shader->kind = LP_FS_KIND_CONST_COLOR;
+   }
 }
 
 
@@ -491,6 +908,14 @@ llvmpipe_fs_analyse(struct lp_fragment_shader *shader,
       shader->kind = LP_FS_KIND_GENERAL;
    }
 
+   if (shader->kind == LP_FS_KIND_LLVM_LINEAR) {
+      enum lp_fs_kind blit = match_blit_shader(tokens, &shader->info);
+      if (blit != LP_FS_KIND_GENERAL)
+         shader->kind = blit;
+      else if (match_const_color_shader(tokens, shader))
+         shader->kind = LP_FS_KIND_CONST_COLOR;
+   }
+
    if (shader->kind == LP_FS_KIND_GENERAL &&
        match_aero_minification_shader(tokens, &shader->info)) {
       shader->kind = LP_FS_KIND_AERO_MINIFICATION;
@@ -252,6 +252,93 @@ fetch_row_xy_clamped(struct nearest_sampler *samp)
 }
 
 
+/* Bilinear filtered lookup of a row of texels with clamp to edge
+ * wrapping, for axis aligned lookups with arbitrary scaling.
+ *
+ * Like fetch_row(), texture coordinates are stepped in fixed point,
+ * here 16.16 so that the weights can be taken to 8 bits as in the LLVM
+ * linear path.  Four texels are filtered at a time, so up to three
+ * texels past the end of the row are written.
+ */
+static const uint32_t *
+fetch_row_bilinear(struct nearest_sampler *samp)
+{
+   const int y = samp->y++;
+   uint32_t *row = samp->out;
+   const struct lp_jit_texture *texture = samp->texture;
+   const int max_x = texture->width - 1;
+   const int max_y = texture->height - 1;
+   const float fy = samp->fsrc_y + samp->fdtdy * y;
+   const int iy = util_ifloor(fy);
+   const uint32_t *src_row0 =
+      (const uint32_t *)((const uint8_t *)texture->base +
+                         CLAMP(iy, 0, max_y) * texture->row_stride[0]);
+   const uint32_t *src_row1 =
+      (const uint32_t *)((const uint8_t *)texture->base +
+                         CLAMP(iy + 1, 0, max_y) * texture->row_stride[0]);
+   const __m128i wy = _mm_set1_epi16((int)((fy - iy) * 256.0f));
+   const __m128i mask = _mm_set1_epi16(0xff);
+   const __m128i zero = _mm_setzero_si128();
+   const int iscale_x = samp->fdsdx * 65536;
+   const int width = samp->width;
+   int acc = samp->fsrc_x * 65536;
+
+   for (int i = 0; i < width; i += 4) {
+      alignas(16) uint32_t tl[4], tr[4], bl[4], br[4];
+      int wx[4];
+
+      for (int j = 0; j < 4; j++) {
+         const int x0 = CLAMP(acc >> 16, 0, max_x);
+         const int x1 = CLAMP((acc >> 16) + 1, 0, max_x);
+
+         tl[j] = src_row0[x0];
+         tr[j] = src_row0[x1];
+         bl[j] = src_row1[x0];
+         br[j] = src_row1[x1];
+         wx[j] = (acc >> 8) & 0xff;
+         acc += iscale_x;
+      }
+
+      const __m128i t0 = *(const __m128i *)tl;
+      const __m128i t1 = *(const __m128i *)tr;
+      const __m128i b0 = *(const __m128i *)bl;
+      const __m128i b1 = *(const __m128i *)br;
+      const __m128i wx_lo = _mm_setr_epi16(wx[0], wx[0], wx[0], wx[0],
+                                           wx[1], wx[1], wx[1], wx[1]);
+      const __m128i wx_hi = _mm_setr_epi16(wx[2], wx[2], wx[2], wx[2],
+                                           wx[3], wx[3], wx[3], wx[3]);
+      __m128i l, r, lo, hi;
+
+      /* util_sse2_lerp_epi16() leaves junk in the high bytes, which has
+       * to be cleared before the result is lerped again or packed.
+       */
+      l = _mm_and_si128(util_sse2_lerp_epi16(wy,
+                                             _mm_unpacklo_epi8(t0, zero),
+                                             _mm_unpacklo_epi8(b0, zero)),
+                        mask);
+      r = _mm_and_si128(util_sse2_lerp_epi16(wy,
+                                             _mm_unpacklo_epi8(t1, zero),
+                                             _mm_unpacklo_epi8(b1, zero)),
+                        mask);
+      lo = _mm_and_si128(util_sse2_lerp_epi16(wx_lo, l, r), mask);
+
+      l = _mm_and_si128(util_sse2_lerp_epi16(wy,
+                                             _mm_unpackhi_epi8(t0, zero),
+                                             _mm_unpackhi_epi8(b0, zero)),
+                        mask);
+      r = _mm_and_si128(util_sse2_lerp_epi16(wy,
+                                             _mm_unpackhi_epi8(t1, zero),
+                                             _mm_unpackhi_epi8(b1, zero)),
+                        mask);
+      hi = _mm_and_si128(util_sse2_lerp_epi16(wx_hi, l, r), mask);
+
+      *(__m128i *)&row[i] = _mm_packus_epi16(lo, hi);
+   }
+
+   return row;
+}
+
+
 static boolean
 init_nearest_sampler(struct nearest_sampler *samp,
                      const struct lp_jit_texture *texture,
@@ -321,6 +408,44 @@ init_nearest_sampler(struct nearest_sampler *samp,
 }
 
 
+/* Set up the sampler for the blit shaders, nearest or bilinear as the
+ * variant's sampler state says.  Bilinear filtering is only done for
+ * axis aligned lookups, and only while the 16.16 coordinates of
+ * fetch_row_bilinear() can't overflow.
+ */
+static boolean
+init_blit_sampler(struct nearest_sampler *samp,
+                  const struct lp_rast_state *state,
+                  int x0, int y0,
+                  int width, int height,
+                  const float (*a0)[4],
+                  const float (*dadx)[4],
+                  const float (*dady)[4])
+{
+   const struct lp_sampler_static_state *samp0 =
+      lp_fs_variant_key_sampler_idx(&state->variant->key, 0);
+
+   if (!init_nearest_sampler(samp,
+                             &state->jit_context.textures[0],
+                             x0, y0, width, height,
+                             a0[1][0], dadx[1][0], dady[1][0],
+                             a0[1][1], dadx[1][1], dady[1][1],
+                             a0[0][3], dadx[0][3], dady[0][3]))
+      return FALSE;
+
+   if (!is_linear_sampler(samp0))
+      return TRUE;
+
+   if (samp->fetch == fetch_row_xy_clamped ||
+       fabsf(samp->fsrc_x) >= 32768.0f ||
+       fabsf(samp->fsrc_x + (width + 4) * samp->fdsdx) >= 32768.0f)
+      return FALSE;
+
+   samp->fetch = fetch_row_bilinear;
+   return TRUE;
+}
+
+
 static const uint32_t *
 shade_rgb1(struct shader *shader)
 {
@@ -472,18 +597,13 @@ blit_rgba(const struct lp_rast_state *state,
           uint8_t *color,
           unsigned stride)
 {
-   const struct lp_jit_context *context = &state->jit_context;
    struct nearest_sampler samp;
    struct color_blend blend;
 
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
-   if (!init_nearest_sampler(&samp,
-                             &context->textures[0],
-                             x, y, width, height,
-                             a0[1][0], dadx[1][0], dady[1][0],
-                             a0[1][1], dadx[1][1], dady[1][1],
-                             a0[0][3], dadx[0][3], dady[0][3]))
+   if (!init_blit_sampler(&samp, state, x, y, width, height,
+                          a0, dadx, dady))
       return FALSE;
 
    init_blend(&blend,
@@ -511,19 +631,14 @@ blit_rgb1(const struct lp_rast_state *state,
           uint8_t *color,
           unsigned stride)
 {
-   const struct lp_jit_context *context = &state->jit_context;
    struct nearest_sampler samp;
    struct color_blend blend;
    struct shader shader;
 
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
-   if (!init_nearest_sampler(&samp,
-                             &context->textures[0],
-                             x, y, width, height,
-                             a0[1][0], dadx[1][0], dady[1][0],
-                             a0[1][1], dadx[1][1], dady[1][1],
-                             a0[0][3], dadx[0][3], dady[0][3]))
+   if (!init_blit_sampler(&samp, state, x, y, width, height,
+                          a0, dadx, dady))
       return FALSE;
 
    init_blend(&blend, x, y, width, height, color, stride);
@@ -555,18 +670,13 @@ blit_rgba_blend_premul(const struct lp_rast_state *state,
                        uint8_t *color,
                        unsigned stride)
 {
-   const struct lp_jit_context *context = &state->jit_context;
    struct nearest_sampler samp;
    struct color_blend blend;
 
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
-   if (!init_nearest_sampler(&samp,
-                             &context->textures[0],
-                             x, y, width, height,
-                             a0[1][0], dadx[1][0], dady[1][0],
-                             a0[1][1], dadx[1][1], dady[1][1],
-                             a0[0][3], dadx[0][3], dady[0][3]))
+   if (!init_blit_sampler(&samp, state, x, y, width, height,
+                          a0, dadx, dady))
       return FALSE;
 
    init_blend(&blend, x, y, width, height, color, stride);
@@ -582,6 +692,99 @@ blit_rgba_blend_premul(const struct lp_rast_state *state,
 }
 
 
+/* Fetch the color of a CONST_COLOR shader as a BGRA8 pixel.  Returns
+ * false if it is in a constant buffer too small to hold it.
+ */
+static boolean
+get_const_color(const struct lp_rast_state *state, uint32_t *pixel)
+{
+   const struct lp_fragment_shader *shader = state->variant->shader;
+   const float *rgba = shader->const_color;
+
+   if (shader->const_color_offset >= 0) {
+      const struct lp_jit_buffer *constants = &state->jit_context.constants[0];
+      if (!constants->f ||
+          shader->const_color_offset + 4 > constants->num_elements)
+         return FALSE;
+      rgba = constants->f + shader->const_color_offset;
+   }
+
+   *pixel = (float_to_ubyte(rgba[2]) |
+             float_to_ubyte(rgba[1]) << 8 |
+             float_to_ubyte(rgba[0]) << 16 |
+             (uint32_t)float_to_ubyte(rgba[3]) << 24);
+   return TRUE;
+}
+
+
+/* Linear shader variant implementing the CONST_COLOR shader without
+ * blending.
+ */
+static boolean
+const_color(const struct lp_rast_state *state,
+            unsigned x, unsigned y,
+            unsigned width, unsigned height,
+            const float (*a0)[4],
+            const float (*dadx)[4],
+            const float (*dady)[4],
+            uint8_t *color,
+            unsigned stride)
+{
+   union util_color uc;
+
+   LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
+
+   if (!get_const_color(state, &uc.ui[0]))
+      return FALSE;
+
+   util_fill_rect(color, PIPE_FORMAT_B8G8R8A8_UNORM, stride,
+                  x, y, width, height, &uc);
+
+   return TRUE;
+}
+
+
+/* Linear shader variant implementing the CONST_COLOR shader with
+ * one/inv_src_alpha blending.
+ */
+static boolean
+const_color_blend_premul(const struct lp_rast_state *state,
+                         unsigned x, unsigned y,
+                         unsigned width, unsigned height,
+                         const float (*a0)[4],
+                         const float (*dadx)[4],
+                         const float (*dady)[4],
+                         uint8_t *color,
+                         unsigned stride)
+{
+   alignas(16) uint32_t src[64];
+   struct color_blend blend;
+   uint32_t pixel;
+
+   LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
+
+   if (!get_const_color(state, &pixel))
+      return FALSE;
+
+   /* Opaque, nothing of the destination shows through:
+    */
+   if ((pixel >> 24) == 0xff)
+      return const_color(state, x, y, width, height, a0, dadx, dady,
+                         color, stride);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(src); i++)
+      src[i] = pixel;
+
+   init_blend(&blend, x, y, width, height, color, stride);
+   blend.src = src;
+
+   for (y = 0; y < height; y++)
+      blend_premul(&blend);
+
+   return TRUE;
+}
+
+
 /* Linear shader which always emits red.  Used for debugging.
  */
 static boolean
@@ -657,17 +860,35 @@ llvmpipe_fs_variant_linear_fastpath(struct lp_fragment_shader_variant *variant)
       return;
    }
 
+   if (variant->shader->kind == LP_FS_KIND_CONST_COLOR) {
+      if (variant->opaque) {
+         variant->jit_linear = const_color;
+      } else if (is_one_inv_src_alpha_blend(variant) &&
+                 util_get_cpu_caps()->has_sse2) {
+         variant->jit_linear = const_color_blend_premul;
+      }
+      return;
+   }
+
    struct lp_sampler_static_state *samp0 =
       lp_fs_variant_key_sampler_idx(&variant->key, 0);
    if (!samp0)
       return;
 
+   /* The exact copies of jit_linear_blit only do unscaled nearest
+    * lookups, the others also do scaled bilinear ones.
+    */
+   const boolean nearest = is_nearest_clamp_sampler(samp0);
+   const boolean bilinear = is_linear_clamp_sampler(samp0) &&
+                            util_get_cpu_caps()->has_sse2;
+
    enum pipe_format tex_format = samp0->texture_state.format;
    if (variant->shader->kind == LP_FS_KIND_BLIT_RGBA &&
        tex_format == PIPE_FORMAT_B8G8R8A8_UNORM &&
-       is_nearest_clamp_sampler(samp0)) {
+       (nearest || bilinear)) {
       if (variant->opaque) {
-         variant->jit_linear_blit = blit_rgba_blit;
+         if (nearest)
+            variant->jit_linear_blit = blit_rgba_blit;
          variant->jit_linear = blit_rgba;
       } else if (is_one_inv_src_alpha_blend(variant) &&
                  util_get_cpu_caps()->has_sse2) {
@@ -677,12 +898,19 @@ llvmpipe_fs_variant_linear_fastpath(struct lp_fragment_shader_variant *variant)
    }
 
    if (variant->shader->kind == LP_FS_KIND_BLIT_RGB1 &&
-       variant->opaque &&
        (tex_format == PIPE_FORMAT_B8G8R8A8_UNORM ||
         tex_format == PIPE_FORMAT_B8G8R8X8_UNORM) &&
-       is_nearest_clamp_sampler(samp0)) {
-      variant->jit_linear_blit = blit_rgb1_blit;
-      variant->jit_linear = blit_rgb1;
+       (nearest || bilinear)) {
+      if (variant->opaque) {
+         if (nearest)
+            variant->jit_linear_blit = blit_rgb1_blit;
+         variant->jit_linear = blit_rgb1;
+      } else if (is_one_inv_src_alpha_blend(variant)) {
+         /* Source alpha is one, so premultiplied blending leaves just
+          * the source color.
+          */
+         variant->jit_linear = blit_rgb1;
+      }
       return;
    }
 
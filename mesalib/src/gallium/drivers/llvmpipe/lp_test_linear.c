@@ -0,0 +1,417 @@
+/**************************************************************************
+ *
+ * Copyright 2010-2021 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Unit tests for the linear path fastpaths of lp_state_fs_linear.c.
+ *
+ * Compositor-like draws, ie. opaque and premultiplied alpha blended blits
+ * with nearest and bilinear filtering and constant color fills, are run
+ * through the fastpath picked for their variant, and compared against
+ * what the general path computes: clamp to edge lookups, filtered with
+ * 8 bit weights, and one/inv_src_alpha blending.  The fastpaths
+ * truncate after each of the two lerps of bilinear filtering, and divide
+ * by 256 rather than 255 when blending, so each of those may be off by
+ * up to two.
+ *
+ * With -o, the cycles per pixel of each case are written out as well.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "util/u_memory.h"
+#include "util/u_math.h"
+#include "util/u_cpu_detect.h"
+
+#include "lp_rast.h"
+#include "lp_state_fs.h"
+#include "lp_test.h"
+
+
+#define TEX_SIZE 64   /* a power of two, so texcoords are exact */
+#define DST_SIZE 128
+#define NUM_CONSTS 8
+
+
+struct linear_test_case
+{
+   const char *name;
+   enum lp_fs_kind kind;
+   unsigned filter;      /* PIPE_TEX_FILTER_x */
+   boolean blend;        /* one/inv_src_alpha, otherwise opaque */
+   float scale;          /* texels per pixel */
+   boolean ubo;          /* const color from constant buffer 0 */
+};
+
+
+static const struct linear_test_case test_cases[] = {
+   { "copy",           LP_FS_KIND_BLIT_RGBA,  PIPE_TEX_FILTER_NEAREST, FALSE, 1.0f  },
+   { "copy_xrgb",      LP_FS_KIND_BLIT_RGB1,  PIPE_TEX_FILTER_NEAREST, FALSE, 1.0f  },
+   { "over",           LP_FS_KIND_BLIT_RGBA,  PIPE_TEX_FILTER_NEAREST, TRUE,  1.0f  },
+   { "over_xrgb",      LP_FS_KIND_BLIT_RGB1,  PIPE_TEX_FILTER_NEAREST, TRUE,  1.0f  },
+   { "zoom",           LP_FS_KIND_BLIT_RGBA,  PIPE_TEX_FILTER_NEAREST, FALSE, 0.5f  },
+   { "shrink_over",    LP_FS_KIND_BLIT_RGBA,  PIPE_TEX_FILTER_NEAREST, TRUE,  1.25f },
+   { "zoom_bilinear",  LP_FS_KIND_BLIT_RGBA,  PIPE_TEX_FILTER_LINEAR,  FALSE, 0.75f },
+   { "shrink_bilinear_over", LP_FS_KIND_BLIT_RGBA, PIPE_TEX_FILTER_LINEAR, TRUE, 1.25f },
+   { "zoom_bilinear_xrgb", LP_FS_KIND_BLIT_RGB1, PIPE_TEX_FILTER_LINEAR, FALSE, 0.5f },
+   { "copy_bilinear",  LP_FS_KIND_BLIT_RGB1,  PIPE_TEX_FILTER_LINEAR,  TRUE,  1.0f  },
+   { "fill",           LP_FS_KIND_CONST_COLOR, 0, FALSE, 0.0f, FALSE },
+   { "fill_ubo",       LP_FS_KIND_CONST_COLOR, 0, FALSE, 0.0f, TRUE  },
+   { "dim",            LP_FS_KIND_CONST_COLOR, 0, TRUE,  0.0f, FALSE },
+   { "dim_ubo",        LP_FS_KIND_CONST_COLOR, 0, TRUE,  0.0f, TRUE  },
+};
+
+
+void
+write_tsv_header(FILE *fp)
+{
+   fprintf(fp,
+           "result\t"
+           "cycles_per_pixel\t"
+           "case\n");
+
+   fflush(fp);
+}
+
+
+static void
+write_tsv_row(FILE *fp,
+              const struct linear_test_case *test,
+              double cycles,
+              boolean success)
+{
+   fprintf(fp, "%s\t", success ? "pass" : "fail");
+   fprintf(fp, "%.1f\t", cycles);
+   fprintf(fp, "%s\n", test->name);
+
+   fflush(fp);
+}
+
+
+static uint32_t
+random_pixel(boolean premultiplied)
+{
+   const unsigned a = rand() & 0xff;
+   uint32_t pixel = a << 24;
+
+   for (unsigned chan = 0; chan < 3; chan++) {
+      unsigned c = rand() & 0xff;
+      if (premultiplied)
+         c = c * a / 255;
+      pixel |= c << (chan * 8);
+   }
+
+   return pixel;
+}
+
+
+static unsigned
+get_chan(uint32_t pixel, unsigned chan)
+{
+   return (pixel >> (chan * 8)) & 0xff;
+}
+
+
+/* Texel lookup with clamp to edge wrapping.
+ */
+static uint32_t
+ref_texel(const uint32_t *tex, int x, int y, boolean rgb1)
+{
+   x = CLAMP(x, 0, TEX_SIZE - 1);
+   y = CLAMP(y, 0, TEX_SIZE - 1);
+   return tex[y * TEX_SIZE + x] | (rgb1 ? 0xff000000 : 0);
+}
+
+
+/* Compute one channel of the shader output at texel coordinates u, v,
+ * which include the -0.5 of the texel centers.
+ */
+static double
+ref_sample(const struct linear_test_case *test, const uint32_t *tex,
+           double u, double v, unsigned chan)
+{
+   const boolean rgb1 = test->kind == LP_FS_KIND_BLIT_RGB1;
+
+   if (test->filter == PIPE_TEX_FILTER_NEAREST) {
+      return get_chan(ref_texel(tex, (int)floor(u + 0.5),
+                                (int)floor(v + 0.5), rgb1), chan);
+   } else {
+      const int x0 = (int)floor(u);
+      const int y0 = (int)floor(v);
+      const double wx = u - x0;
+      const double wy = v - y0;
+      const double t = (get_chan(ref_texel(tex, x0, y0, rgb1), chan) * (1 - wx) +
+                        get_chan(ref_texel(tex, x0 + 1, y0, rgb1), chan) * wx);
+      const double b = (get_chan(ref_texel(tex, x0, y0 + 1, rgb1), chan) * (1 - wx) +
+                        get_chan(ref_texel(tex, x0 + 1, y0 + 1, rgb1), chan) * wx);
+      return t * (1 - wy) + b * wy;
+   }
+}
+
+
+PIPE_ALIGN_STACK
+static boolean
+test_linear(unsigned verbose, FILE *fp,
+            const struct linear_test_case *test)
+{
+   struct lp_fragment_shader shader;
+   struct lp_fragment_shader_variant *variant;
+   struct lp_rast_state state;
+   uint32_t *tex, *dst, *ref;
+   float consts[NUM_CONSTS * 4];
+   float a0[2][4], dadx[2][4], dady[2][4];
+   const boolean has_tex = test->kind != LP_FS_KIND_CONST_COLOR;
+   const unsigned tolerance =
+      (test->filter == PIPE_TEX_FILTER_LINEAR ? 2 : 0) + (test->blend ? 2 : 0);
+   int64_t cycles = 0;
+   unsigned num_pixels = 0;
+   boolean success = TRUE;
+
+   if (!util_get_cpu_caps()->has_sse2)
+      return TRUE;
+
+   memset(&shader, 0, sizeof shader);
+   shader.kind = test->kind;
+   shader.const_color_offset = -1;
+
+   variant = CALLOC(1, sizeof *variant + sizeof(struct lp_sampler_static_state));
+   tex = align_malloc(TEX_SIZE * TEX_SIZE * 4, 16);
+   dst = align_malloc(DST_SIZE * DST_SIZE * 4, 16);
+   ref = align_malloc(DST_SIZE * DST_SIZE * 4, 16);
+   if (!variant || !tex || !dst || !ref) {
+      success = FALSE;
+      goto out;
+   }
+
+   variant->shader = &shader;
+   variant->opaque = !test->blend;
+   variant->key.cbuf_format[0] = PIPE_FORMAT_B8G8R8A8_UNORM;
+   variant->key.blend.rt[0].colormask = 0xf;
+   if (test->blend) {
+      variant->key.blend.rt[0].blend_enable = 1;
+      variant->key.blend.rt[0].rgb_func = PIPE_BLEND_ADD;
+      variant->key.blend.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_ONE;
+      variant->key.blend.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+      variant->key.blend.rt[0].alpha_func = PIPE_BLEND_ADD;
+      variant->key.blend.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+      variant->key.blend.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+   }
+
+   if (has_tex) {
+      struct lp_sampler_static_state *samp =
+         lp_fs_variant_key_samplers(&variant->key);
+
+      variant->key.nr_samplers = 1;
+      variant->key.nr_sampler_views = 1;
+      samp->texture_state.format = test->kind == LP_FS_KIND_BLIT_RGB1 ?
+         PIPE_FORMAT_B8G8R8X8_UNORM : PIPE_FORMAT_B8G8R8A8_UNORM;
+      samp->texture_state.target = PIPE_TEXTURE_2D;
+      samp->texture_state.level_zero_only = 1;
+      samp->sampler_state.min_img_filter = test->filter;
+      samp->sampler_state.mag_img_filter = test->filter;
+      samp->sampler_state.min_mip_filter = PIPE_TEX_MIPFILTER_NONE;
+      samp->sampler_state.wrap_s = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+      samp->sampler_state.wrap_t = PIPE_TEX_WRAP_CLAMP_TO_EDGE;
+      samp->sampler_state.normalized_coords = 1;
+   }
+
+   llvmpipe_fs_variant_linear_fastpath(variant);
+
+   if (!variant->jit_linear) {
+      if (verbose || !fp)
+         printf("%s: no fastpath\n", test->name);
+      success = FALSE;
+      goto out;
+   }
+
+   memset(&state, 0, sizeof state);
+   state.variant = variant;
+   state.jit_context.textures[0].width = TEX_SIZE;
+   state.jit_context.textures[0].height = TEX_SIZE;
+   state.jit_context.textures[0].depth = 1;
+   state.jit_context.textures[0].base = tex;
+   state.jit_context.textures[0].row_stride[0] = TEX_SIZE * 4;
+   state.jit_context.constants[0].f = consts;
+   state.jit_context.constants[0].num_elements = ARRAY_SIZE(consts);
+
+   for (unsigned i = 0; i < ARRAY_SIZE(consts); i++)
+      consts[i] = (rand() & 0xff) / 255.0f;
+
+   for (unsigned n = 0; n < LP_TEST_NUM_SAMPLES && success; n++) {
+      const unsigned x = rand() % DST_SIZE;
+      const unsigned y = rand() % DST_SIZE;
+      const unsigned w = 1 + rand() % 64;
+      const unsigned h = 1 + rand() % 64;
+      const unsigned width = MIN2(w, DST_SIZE - x);
+      const unsigned height = MIN2(h, DST_SIZE - y);
+      /* Texel offsets reaching over the edges for clamping, in odd
+       * 1/16ths so that nearest lookups never fall halfway between two
+       * texels at the scales above.
+       */
+      const float off_x = (2 * (rand() % (48 * 8)) + 1) / 16.0f - 8.0f;
+      const float off_y = (2 * (rand() % (48 * 8)) + 1) / 16.0f - 8.0f;
+      uint32_t color = 0;
+
+      for (unsigned i = 0; i < TEX_SIZE * TEX_SIZE; i++)
+         tex[i] = random_pixel(TRUE);
+      for (unsigned i = 0; i < DST_SIZE * DST_SIZE; i++)
+         ref[i] = dst[i] = random_pixel(TRUE);
+
+      if (!has_tex) {
+         color = random_pixel(TRUE);
+         for (unsigned chan = 0; chan < 4; chan++) {
+            /* RGBA floats for BGRA pixels */
+            const unsigned c = chan == 3 ? 3 : 2 - chan;
+            shader.const_color[chan] = get_chan(color, c) / 255.0f;
+         }
+         if (test->ubo) {
+            shader.const_color_offset = 4 * (rand() % NUM_CONSTS);
+            memcpy(&consts[shader.const_color_offset], shader.const_color,
+                   sizeof shader.const_color);
+         }
+      }
+
+      /* Position w, and texcoords with s * TEX_SIZE = off + scale * x
+       */
+      memset(a0, 0, sizeof a0);
+      memset(dadx, 0, sizeof dadx);
+      memset(dady, 0, sizeof dady);
+      a0[0][3] = 1.0f;
+      a0[1][0] = off_x / TEX_SIZE;
+      a0[1][1] = off_y / TEX_SIZE;
+      dadx[1][0] = test->scale / TEX_SIZE;
+      dady[1][1] = test->scale / TEX_SIZE;
+
+      const int64_t start = rdtsc();
+      boolean ok = FALSE;
+      if (variant->jit_linear_blit)
+         ok = variant->jit_linear_blit(&state, x, y, width, height,
+                                       (const float (*)[4])a0,
+                                       (const float (*)[4])dadx,
+                                       (const float (*)[4])dady,
+                                       (uint8_t *)dst, DST_SIZE * 4);
+      if (!ok)
+         ok = variant->jit_linear(&state, x, y, width, height,
+                                  (const float (*)[4])a0,
+                                  (const float (*)[4])dadx,
+                                  (const float (*)[4])dady,
+                                  (uint8_t *)dst, DST_SIZE * 4);
+      cycles += rdtsc() - start;
+      num_pixels += width * height;
+
+      if (!ok) {
+         if (verbose || !fp)
+            printf("%s: fastpath fell back\n", test->name);
+         success = FALSE;
+         break;
+      }
+
+      for (unsigned j = 0; j < height; j++) {
+         for (unsigned i = 0; i < width; i++) {
+            const unsigned px = x + i, py = y + j;
+            const double u = off_x + test->scale * px - 0.5;
+            const double v = off_y + test->scale * py - 0.5;
+            uint32_t *d = &ref[py * DST_SIZE + px];
+            double src[4];
+
+            for (unsigned chan = 0; chan < 4; chan++)
+               src[chan] = has_tex ? ref_sample(test, tex, u, v, chan)
+                                   : get_chan(color, chan);
+
+            uint32_t pixel = 0;
+            for (unsigned chan = 0; chan < 4; chan++) {
+               double c = src[chan];
+               if (test->blend)
+                  c += get_chan(*d, chan) * (255.0 - src[3]) / 255.0;
+               pixel |= (uint32_t)util_iround(MIN2(c, 255.0)) << (chan * 8);
+            }
+            *d = pixel;
+         }
+      }
+
+      for (unsigned i = 0; i < DST_SIZE * DST_SIZE && success; i++) {
+         for (unsigned chan = 0; chan < 4; chan++) {
+            const int diff = (int)get_chan(dst[i], chan) -
+                             (int)get_chan(ref[i], chan);
+            if (abs(diff) > tolerance) {
+               if (verbose || !fp)
+                  printf("%s: pixel %u,%u is %08x, expected %08x\n",
+                         test->name, i % DST_SIZE, i / DST_SIZE,
+                         dst[i], ref[i]);
+               success = FALSE;
+               break;
+            }
+         }
+      }
+   }
+
+   if (fp)
+      write_tsv_row(fp, test, num_pixels ? (double)cycles / num_pixels : 0.0,
+                    success);
+   else if (verbose)
+      printf("%s: %s\n", test->name, success ? "pass" : "fail");
+
+out:
+   align_free(ref);
+   align_free(dst);
+   align_free(tex);
+   FREE(variant);
+
+   return success;
+}
+
+
+boolean
+test_all(unsigned verbose, FILE *fp)
+{
+   boolean success = TRUE;
+
+   for (unsigned i = 0; i < ARRAY_SIZE(test_cases); i++) {
+      if (!test_linear(verbose, fp, &test_cases[i]))
+         success = FALSE;
+   }
+
+   return success;
+}
+
+
+boolean
+test_some(unsigned verbose, FILE *fp,
+          unsigned long n)
+{
+   return test_all(verbose, fp);
+}
+
+
+boolean
+test_single(unsigned verbose, FILE *fp)
+{
+   return test_linear(verbose, fp, &test_cases[0]);
+}
@@ -1176,6 +1176,20 @@ llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen)
 }
 
 
+/**
+ * The contents of the resource are no longer needed.  Clears of it which
+ * haven't been binned yet are dropped.
+ */
+static void
+llvmpipe_invalidate_resource(struct pipe_context *pipe,
+                             struct pipe_resource *resource)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+
+   lp_setup_invalidate_resource(llvmpipe->setup, resource);
+}
+
+
 void
 llvmpipe_init_context_resource_funcs(struct pipe_context *pipe)
 {
@@ -1189,4 +1203,5 @@ llvmpipe_init_context_resource_funcs(struct pipe_context *pipe)
    pipe->texture_subdata = u_default_texture_subdata;
 
    pipe->memory_barrier = llvmpipe_memory_barrier;
+   pipe->invalidate_resource = llvmpipe_invalidate_resource;
 }
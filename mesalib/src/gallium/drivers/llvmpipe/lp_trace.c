@@ -0,0 +1,92 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "util/simple_mtx.h"
+#include "util/u_debug.h"
+#include "lp_trace.h"
+
+
+boolean lp_trace_enabled = FALSE;
+
+static simple_mtx_t trace_mutex = _SIMPLE_MTX_INITIALIZER_NP;
+static boolean trace_initialized = FALSE;
+static boolean trace_first_event = TRUE;
+static FILE *trace_file = NULL;
+
+
+static void
+lp_trace_close(void)
+{
+   simple_mtx_lock(&trace_mutex);
+   lp_trace_enabled = FALSE;
+   fprintf(trace_file, "\n]\n");
+   fclose(trace_file);
+   trace_file = NULL;
+   simple_mtx_unlock(&trace_mutex);
+}
+
+
+/**
+ * Open the LP_TRACE file, if set.  Safe to call for every screen; only
+ * the first call does anything.
+ */
+void
+lp_trace_init(void)
+{
+   simple_mtx_lock(&trace_mutex);
+
+   if (!trace_initialized) {
+      const char *filename = debug_get_option("LP_TRACE", NULL);
+
+      trace_initialized = TRUE;
+
+      if (filename) {
+         trace_file = fopen(filename, "w");
+         if (trace_file) {
+            fprintf(trace_file, "[\n");
+            atexit(lp_trace_close);
+            lp_trace_enabled = TRUE;
+         } else {
+            debug_printf("llvmpipe: failed to open trace file %s\n",
+                         filename);
+         }
+      }
+   }
+
+   simple_mtx_unlock(&trace_mutex);
+}
+
+
+void
+lp_trace_event(const char *name, unsigned tid,
+               int64_t start, int64_t end,
+               const char *args_fmt, ...)
+{
+   simple_mtx_lock(&trace_mutex);
+
+   if (trace_file) {
+      fprintf(trace_file,
+              "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+              "\"ts\":%" PRId64 ",\"dur\":%" PRId64 ",\"args\":{",
+              trace_first_event ? "" : ",\n",
+              name, tid, start, end - start);
+
+      if (args_fmt) {
+         va_list ap;
+         va_start(ap, args_fmt);
+         vfprintf(trace_file, args_fmt, ap);
+         va_end(ap);
+      }
+
+      fprintf(trace_file, "}}");
+      trace_first_event = FALSE;
+   }
+
+   simple_mtx_unlock(&trace_mutex);
+}
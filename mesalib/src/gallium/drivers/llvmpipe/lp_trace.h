@@ -0,0 +1,45 @@
+/*
+ * SPDX-License-Identifier: MIT
+ */
+
+/**
+ * Timeline trace of scene binning, bin rasterization and shader
+ * compiles, written as Chrome trace event JSON to the file named by
+ * LP_TRACE.  Load it in chrome://tracing or ui.perfetto.dev.
+ */
+
+
+#ifndef LP_TRACE_H
+#define LP_TRACE_H
+
+#include "pipe/p_compiler.h"
+#include "util/macros.h"
+
+/** Thread id used for events from the context's (binning) thread.
+ * Whole scene rasterization, which spans all the rasterizer threads,
+ * gets its own track, and rasterizer thread N uses LP_TRACE_TID_RAST + N.
+ */
+#define LP_TRACE_TID_SETUP 0
+#define LP_TRACE_TID_SCENE (LP_TRACE_TID_SETUP + 1)
+#define LP_TRACE_TID_RAST  (LP_TRACE_TID_SCENE + 1)
+
+
+extern boolean lp_trace_enabled;
+
+
+extern void
+lp_trace_init(void);
+
+
+/**
+ * Record a complete event spanning [start, end], in os_time_get()
+ * microseconds.  args_fmt, if not NULL, is the printf-style body of the
+ * event's JSON args object, e.g. "\"scene\":%u".
+ */
+extern void
+lp_trace_event(const char *name, unsigned tid,
+               int64_t start, int64_t end,
+               const char *args_fmt, ...) PRINTFLIKE(5, 6);
+
+
+#endif /* LP_TRACE_H */
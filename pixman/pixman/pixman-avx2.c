@@ -0,0 +1,1143 @@
+/*
+ * Copyright © 2008 Rodrigo Kumpera
+ * Copyright © 2008 André Tupinambá
+ * Copyright © 2013 Soren Sandmann Pedersen
+ *
+ * Permission to use, copy, modify, distribute, and sell this software and its
+ * documentation for any purpose is hereby granted without fee, provided that
+ * the above copyright notice appear in all copies and that both that
+ * copyright notice and this permission notice appear in supporting
+ * documentation, and that the name of Red Hat not be used in advertising or
+ * publicity pertaining to distribution of the software without specific,
+ * written prior permission.  Red Hat makes no representations about the
+ * suitability of this software for any purpose.  It is provided "as is"
+ * without express or implied warranty.
+ *
+ * THE COPYRIGHT HOLDERS DISCLAIM ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS, IN NO EVENT SHALL THE COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN
+ * AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING
+ * OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ *
+ * Based on pixman-sse2.c and pixman-ssse3.c; the arithmetic is the same,
+ * eight pixels at a time.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <immintrin.h>
+#include "pixman-private.h"
+#include "pixman-combine32.h"
+#include "pixman-inlines.h"
+
+/* ---------------------------------------------------------------------
+ * Single pixel helpers, used for heads and tails
+ */
+
+static force_inline __m128i
+unpack_32_1x128 (uint32_t data)
+{
+    return _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (data), _mm_setzero_si128 ());
+}
+
+static force_inline uint32_t
+pack_1x128_32 (__m128i data)
+{
+    return _mm_cvtsi128_si32 (_mm_packus_epi16 (data, _mm_setzero_si128 ()));
+}
+
+static force_inline __m128i
+expand_alpha_1x128 (__m128i data)
+{
+    return _mm_shufflelo_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3));
+}
+
+static force_inline __m128i
+expand_alpha_rev_1x128 (__m128i data)
+{
+    return _mm_shufflelo_epi16 (data, _MM_SHUFFLE (0, 0, 0, 0));
+}
+
+static force_inline __m128i
+pix_multiply_1x128 (__m128i data, __m128i alpha)
+{
+    return _mm_mulhi_epu16 (_mm_adds_epu16 (_mm_mullo_epi16 (data, alpha),
+					    _mm_set1_epi16 (0x0080)),
+			    _mm_set1_epi16 (0x0101));
+}
+
+static force_inline __m128i
+over_1x128 (__m128i src, __m128i alpha, __m128i dst)
+{
+    __m128i ialpha = _mm_xor_si128 (alpha, _mm_set1_epi16 (0x00ff));
+
+    return _mm_adds_epu8 (src, pix_multiply_1x128 (dst, ialpha));
+}
+
+static force_inline uint32_t
+over_pixel (uint32_t src, uint32_t dst)
+{
+    uint8_t a = src >> 24;
+
+    if (a == 0xff)
+    {
+	return src;
+    }
+    else if (src)
+    {
+	__m128i s = unpack_32_1x128 (src);
+
+	return pack_1x128_32 (
+	    over_1x128 (s, expand_alpha_1x128 (s), unpack_32_1x128 (dst)));
+    }
+
+    return dst;
+}
+
+static force_inline uint32_t
+combine1 (const uint32_t *ps, const uint32_t *pm)
+{
+    uint32_t s;
+    memcpy (&s, ps, sizeof (uint32_t));
+
+    if (pm)
+    {
+	__m128i mm = expand_alpha_1x128 (unpack_32_1x128 (*pm));
+
+	s = pack_1x128_32 (pix_multiply_1x128 (unpack_32_1x128 (s), mm));
+    }
+
+    return s;
+}
+
+/* ---------------------------------------------------------------------
+ * Eight pixel helpers
+ *
+ * The unpack and pack instructions work within each 128 bit lane, so
+ * "lo" holds pixels 0, 1, 4, 5 and "hi" holds 2, 3, 6, 7.  Since
+ * everything in between is per-channel, packing puts them back in order.
+ */
+
+static force_inline __m256i
+load_256_unaligned (const uint32_t *p)
+{
+    return _mm256_loadu_si256 ((const __m256i *)p);
+}
+
+static force_inline __m256i
+load_256_aligned (const uint32_t *p)
+{
+    return _mm256_load_si256 ((const __m256i *)p);
+}
+
+static force_inline void
+save_256_aligned (uint32_t *p, __m256i data)
+{
+    _mm256_store_si256 ((__m256i *)p, data);
+}
+
+static force_inline void
+save_256_unaligned (uint32_t *p, __m256i data)
+{
+    _mm256_storeu_si256 ((__m256i *)p, data);
+}
+
+static force_inline void
+unpack_256_2x256 (__m256i data, __m256i *lo, __m256i *hi)
+{
+    *lo = _mm256_unpacklo_epi8 (data, _mm256_setzero_si256 ());
+    *hi = _mm256_unpackhi_epi8 (data, _mm256_setzero_si256 ());
+}
+
+static force_inline __m256i
+pack_2x256_256 (__m256i lo, __m256i hi)
+{
+    return _mm256_packus_epi16 (lo, hi);
+}
+
+static force_inline int
+is_opaque_256 (__m256i x)
+{
+    __m256i ffs = _mm256_cmpeq_epi8 (x, x);
+
+    return ((uint32_t)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (x, ffs)) &
+	    0x88888888) == 0x88888888;
+}
+
+static force_inline int
+is_zero_256 (__m256i x)
+{
+    return _mm256_testz_si256 (x, x);
+}
+
+static force_inline int
+is_transparent_256 (__m256i x)
+{
+    return _mm256_testz_si256 (x, _mm256_set1_epi32 (0xff000000));
+}
+
+static force_inline __m256i
+expand_alpha_256 (__m256i data)
+{
+    return _mm256_shufflehi_epi16 (
+	_mm256_shufflelo_epi16 (data, _MM_SHUFFLE (3, 3, 3, 3)),
+	_MM_SHUFFLE (3, 3, 3, 3));
+}
+
+static force_inline __m256i
+expand_alpha_rev_256 (__m256i data)
+{
+    return _mm256_shufflehi_epi16 (
+	_mm256_shufflelo_epi16 (data, _MM_SHUFFLE (0, 0, 0, 0)),
+	_MM_SHUFFLE (0, 0, 0, 0));
+}
+
+static force_inline __m256i
+pix_multiply_256 (__m256i data, __m256i alpha)
+{
+    return _mm256_mulhi_epu16 (
+	_mm256_adds_epu16 (_mm256_mullo_epi16 (data, alpha),
+			   _mm256_set1_epi16 (0x0080)),
+	_mm256_set1_epi16 (0x0101));
+}
+
+static force_inline __m256i
+over_256 (__m256i src, __m256i alpha, __m256i dst)
+{
+    __m256i ialpha = _mm256_xor_si256 (alpha, _mm256_set1_epi16 (0x00ff));
+
+    return _mm256_adds_epu8 (src, pix_multiply_256 (dst, ialpha));
+}
+
+/* src OVER dst, for eight packed pixels */
+static force_inline __m256i
+over_8x32 (__m256i src, __m256i dst)
+{
+    __m256i src_lo, src_hi, dst_lo, dst_hi;
+
+    unpack_256_2x256 (src, &src_lo, &src_hi);
+    unpack_256_2x256 (dst, &dst_lo, &dst_hi);
+
+    dst_lo = over_256 (src_lo, expand_alpha_256 (src_lo), dst_lo);
+    dst_hi = over_256 (src_hi, expand_alpha_256 (src_hi), dst_hi);
+
+    return pack_2x256_256 (dst_lo, dst_hi);
+}
+
+/* src IN alpha (mask), for eight packed pixels */
+static force_inline __m256i
+in_alpha_8x32 (__m256i src, __m256i mask)
+{
+    __m256i src_lo, src_hi, msk_lo, msk_hi;
+
+    unpack_256_2x256 (src, &src_lo, &src_hi);
+    unpack_256_2x256 (mask, &msk_lo, &msk_hi);
+
+    src_lo = pix_multiply_256 (src_lo, expand_alpha_256 (msk_lo));
+    src_hi = pix_multiply_256 (src_hi, expand_alpha_256 (msk_hi));
+
+    return pack_2x256_256 (src_lo, src_hi);
+}
+
+static force_inline __m256i
+combine8 (const uint32_t *ps, const uint32_t *pm)
+{
+    __m256i s, m;
+
+    if (pm)
+    {
+	m = load_256_unaligned (pm);
+
+	if (is_transparent_256 (m))
+	    return _mm256_setzero_si256 ();
+    }
+
+    s = load_256_unaligned (ps);
+
+    if (pm)
+	s = in_alpha_8x32 (s, m);
+
+    return s;
+}
+
+/* ---------------------------------------------------------------------
+ * Combiners
+ */
+
+static void
+avx2_combine_over_u (pixman_implementation_t *imp,
+                     pixman_op_t              op,
+                     uint32_t *               pd,
+                     const uint32_t *         ps,
+                     const uint32_t *         pm,
+                     int                      w)
+{
+    uint32_t s;
+
+    /* Align dst on a 32-byte boundary */
+    while (w && ((uintptr_t)pd & 31))
+    {
+	s = combine1 (ps, pm);
+
+	if (s)
+	    *pd = over_pixel (s, *pd);
+	pd++;
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	__m256i src = combine8 (ps, pm);
+
+	if (is_opaque_256 (src))
+	    save_256_aligned (pd, src);
+	else if (!is_zero_256 (src))
+	    save_256_aligned (pd, over_8x32 (src, load_256_aligned (pd)));
+
+	pd += 8;
+	ps += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w)
+    {
+	s = combine1 (ps, pm);
+
+	if (s)
+	    *pd = over_pixel (s, *pd);
+	pd++;
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+}
+
+static void
+avx2_combine_over_reverse_u (pixman_implementation_t *imp,
+                             pixman_op_t              op,
+                             uint32_t *               pd,
+                             const uint32_t *         ps,
+                             const uint32_t *         pm,
+                             int                      w)
+{
+    uint32_t s, d;
+
+    while (w && ((uintptr_t)pd & 31))
+    {
+	d = *pd;
+	s = combine1 (ps, pm);
+
+	*pd++ = over_pixel (d, s);
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	__m256i src = combine8 (ps, pm);
+	__m256i dst = load_256_aligned (pd);
+
+	if (!is_opaque_256 (dst))
+	    save_256_aligned (pd, over_8x32 (dst, src));
+
+	pd += 8;
+	ps += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w)
+    {
+	d = *pd;
+	s = combine1 (ps, pm);
+
+	*pd++ = over_pixel (d, s);
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+}
+
+static void
+avx2_combine_add_u (pixman_implementation_t *imp,
+                    pixman_op_t              op,
+                    uint32_t *               pd,
+                    const uint32_t *         ps,
+                    const uint32_t *         pm,
+                    int                      w)
+{
+    uint32_t s;
+
+    while (w && ((uintptr_t)pd & 31))
+    {
+	s = combine1 (ps, pm);
+
+	*pd = _mm_cvtsi128_si32 (
+	    _mm_adds_epu8 (_mm_cvtsi32_si128 (s), _mm_cvtsi32_si128 (*pd)));
+	pd++;
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	__m256i src = combine8 (ps, pm);
+
+	save_256_aligned (pd, _mm256_adds_epu8 (src, load_256_aligned (pd)));
+
+	pd += 8;
+	ps += 8;
+	if (pm)
+	    pm += 8;
+	w -= 8;
+    }
+
+    while (w)
+    {
+	s = combine1 (ps, pm);
+
+	*pd = _mm_cvtsi128_si32 (
+	    _mm_adds_epu8 (_mm_cvtsi32_si128 (s), _mm_cvtsi32_si128 (*pd)));
+	pd++;
+	ps++;
+	if (pm)
+	    pm++;
+	w--;
+    }
+}
+
+/* ---------------------------------------------------------------------
+ * Fast paths
+ */
+
+static void
+avx2_composite_over_8888_8888 (pixman_implementation_t *imp,
+                               pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    int dst_stride, src_stride;
+    uint32_t    *dst_line;
+    uint32_t    *src_line;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	avx2_combine_over_u (imp, op, dst_line, src_line, NULL, width);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+avx2_composite_over_n_8_8888 (pixman_implementation_t *imp,
+                              pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src, srca;
+    uint32_t *dst_line, *dst;
+    uint8_t *mask_line, *mask;
+    int dst_stride, mask_stride;
+    int32_t w;
+
+    __m128i mmx_src, mmx_alpha;
+    __m256i ymm_def, ymm_src, ymm_alpha;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    srca = src >> 24;
+    if (src == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    mmx_src = unpack_32_1x128 (src);
+    mmx_alpha = expand_alpha_1x128 (mmx_src);
+
+    ymm_def = _mm256_set1_epi32 (src);
+    ymm_src = _mm256_broadcastq_epi64 (mmx_src);
+    ymm_alpha = _mm256_broadcastq_epi64 (mmx_alpha);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	mask = mask_line;
+	mask_line += mask_stride;
+	w = width;
+
+	/* No alignment head: glyphs are composited a few pixels per
+	 * row, and aligning those one pixel at a time would leave
+	 * nothing for the vector loop.
+	 */
+	while (w >= 8)
+	{
+	    __m128i m = _mm_loadl_epi64 ((__m128i *)mask);
+	    int bits = _mm_movemask_epi8 (_mm_cmpeq_epi8 (m, _mm_setzero_si128 ()));
+
+	    if (srca == 0xff &&
+		(_mm_movemask_epi8 (_mm_cmpeq_epi8 (m, _mm_set1_epi8 (-1))) & 0xff) == 0xff)
+	    {
+		save_256_unaligned (dst, ymm_def);
+	    }
+	    else if ((bits & 0xff) != 0xff)
+	    {
+		__m256i ymm_mask, ymm_mask_lo, ymm_mask_hi;
+		__m256i ymm_dst_lo, ymm_dst_hi;
+
+		ymm_mask = _mm256_cvtepu8_epi32 (m);
+
+		unpack_256_2x256 (load_256_unaligned (dst), &ymm_dst_lo, &ymm_dst_hi);
+		unpack_256_2x256 (ymm_mask, &ymm_mask_lo, &ymm_mask_hi);
+
+		ymm_mask_lo = expand_alpha_rev_256 (ymm_mask_lo);
+		ymm_mask_hi = expand_alpha_rev_256 (ymm_mask_hi);
+
+		ymm_dst_lo = over_256 (pix_multiply_256 (ymm_src, ymm_mask_lo),
+				       pix_multiply_256 (ymm_alpha, ymm_mask_lo),
+				       ymm_dst_lo);
+		ymm_dst_hi = over_256 (pix_multiply_256 (ymm_src, ymm_mask_hi),
+				       pix_multiply_256 (ymm_alpha, ymm_mask_hi),
+				       ymm_dst_hi);
+
+		save_256_unaligned (dst, pack_2x256_256 (ymm_dst_lo, ymm_dst_hi));
+	    }
+
+	    w -= 8;
+	    dst += 8;
+	    mask += 8;
+	}
+
+	while (w)
+	{
+	    uint8_t m = *mask++;
+
+	    if (m)
+	    {
+		__m128i mm = expand_alpha_rev_1x128 (unpack_32_1x128 (m));
+
+		*dst = pack_1x128_32 (
+		    over_1x128 (pix_multiply_1x128 (mmx_src, mm),
+				pix_multiply_1x128 (mmx_alpha, mm),
+				unpack_32_1x128 (*dst)));
+	    }
+
+	    w--;
+	    dst++;
+	}
+    }
+}
+
+static void
+avx2_composite_add_8_8 (pixman_implementation_t *imp,
+			pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t     *dst_line, *dst;
+    uint8_t     *src_line, *src;
+    int dst_stride, src_stride;
+    int32_t w;
+    uint16_t t;
+
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint8_t, src_stride, src_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	src = src_line;
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+	w = width;
+
+	/* Glyph masks are accumulated with many narrow ADDs, so
+	 * rather than aligning the destination byte by byte, use
+	 * unaligned accesses and finish with 16, 8 and 4 byte steps.
+	 */
+	while (w >= 32)
+	{
+	    __m256i s = _mm256_loadu_si256 ((const __m256i *)src);
+
+	    _mm256_storeu_si256 (
+		(__m256i *)dst,
+		_mm256_adds_epu8 (s, _mm256_loadu_si256 ((__m256i *)dst)));
+
+	    dst += 32;
+	    src += 32;
+	    w -= 32;
+	}
+
+	if (w >= 16)
+	{
+	    __m128i s = _mm_loadu_si128 ((const __m128i *)src);
+
+	    _mm_storeu_si128 (
+		(__m128i *)dst,
+		_mm_adds_epu8 (s, _mm_loadu_si128 ((__m128i *)dst)));
+
+	    dst += 16;
+	    src += 16;
+	    w -= 16;
+	}
+
+	if (w >= 8)
+	{
+	    __m128i s = _mm_loadl_epi64 ((const __m128i *)src);
+
+	    _mm_storel_epi64 (
+		(__m128i *)dst,
+		_mm_adds_epu8 (s, _mm_loadl_epi64 ((__m128i *)dst)));
+
+	    dst += 8;
+	    src += 8;
+	    w -= 8;
+	}
+
+	if (w >= 4)
+	{
+	    uint32_t s, d;
+
+	    memcpy (&s, src, sizeof (uint32_t));
+	    memcpy (&d, dst, sizeof (uint32_t));
+	    d = _mm_cvtsi128_si32 (
+		_mm_adds_epu8 (_mm_cvtsi32_si128 (s), _mm_cvtsi32_si128 (d)));
+	    memcpy (dst, &d, sizeof (uint32_t));
+
+	    dst += 4;
+	    src += 4;
+	    w -= 4;
+	}
+
+	while (w)
+	{
+	    t = (*dst) + (*src++);
+	    *dst++ = t | (0 - (t >> 8));
+	    w--;
+	}
+    }
+}
+
+static void
+avx2_composite_src_x888_8888 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t    *dst_line, *dst;
+    uint32_t    *src_line, *src;
+    int32_t w;
+    int dst_stride, src_stride;
+    __m256i ff000000 = _mm256_set1_epi32 (0xff000000);
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	src = src_line;
+	src_line += src_stride;
+	w = width;
+
+	while (w && (uintptr_t)dst & 31)
+	{
+	    *dst++ = *src++ | 0xff000000;
+	    w--;
+	}
+
+	while (w >= 32)
+	{
+	    __m256i s1 = load_256_unaligned (src + 0);
+	    __m256i s2 = load_256_unaligned (src + 8);
+	    __m256i s3 = load_256_unaligned (src + 16);
+	    __m256i s4 = load_256_unaligned (src + 24);
+
+	    save_256_aligned (dst + 0, _mm256_or_si256 (s1, ff000000));
+	    save_256_aligned (dst + 8, _mm256_or_si256 (s2, ff000000));
+	    save_256_aligned (dst + 16, _mm256_or_si256 (s3, ff000000));
+	    save_256_aligned (dst + 24, _mm256_or_si256 (s4, ff000000));
+
+	    dst += 32;
+	    src += 32;
+	    w -= 32;
+	}
+
+	while (w >= 8)
+	{
+	    save_256_aligned (
+		dst, _mm256_or_si256 (load_256_unaligned (src), ff000000));
+
+	    dst += 8;
+	    src += 8;
+	    w -= 8;
+	}
+
+	while (w)
+	{
+	    *dst++ = *src++ | 0xff000000;
+	    w--;
+	}
+    }
+}
+
+static force_inline void
+scaled_nearest_scanline_avx2_8888_8888_OVER (uint32_t*       pd,
+                                             const uint32_t* ps,
+                                             int32_t         w,
+                                             pixman_fixed_t  vx,
+                                             pixman_fixed_t  unit_x,
+                                             pixman_fixed_t  src_width_fixed,
+                                             pixman_bool_t   fully_transparent_src)
+{
+    uint32_t s;
+
+    if (fully_transparent_src)
+	return;
+
+    while (w && ((uintptr_t)pd & 31))
+    {
+	s = *(ps + pixman_fixed_to_int (vx));
+	vx += unit_x;
+	while (vx >= 0)
+	    vx -= src_width_fixed;
+
+	*pd = over_pixel (s, *pd);
+	pd++;
+	w--;
+    }
+
+    while (w >= 8)
+    {
+	__m128i lo, hi;
+	__m256i src;
+
+	/* Insert the pixels one at a time; going through a uint32_t[8]
+	 * and loading that as one 256 bit value defeats store forwarding.
+	 */
+#define FETCH_NEAREST(v, i)						\
+	do {								\
+	    v = _mm_insert_epi32 (v, *(ps + pixman_fixed_to_int (vx)), i); \
+	    vx += unit_x;						\
+	    while (vx >= 0)						\
+		vx -= src_width_fixed;					\
+	} while (0)
+
+	lo = _mm_setzero_si128 ();
+	hi = _mm_setzero_si128 ();
+	FETCH_NEAREST (lo, 0);
+	FETCH_NEAREST (lo, 1);
+	FETCH_NEAREST (lo, 2);
+	FETCH_NEAREST (lo, 3);
+	FETCH_NEAREST (hi, 0);
+	FETCH_NEAREST (hi, 1);
+	FETCH_NEAREST (hi, 2);
+	FETCH_NEAREST (hi, 3);
+
+#undef FETCH_NEAREST
+
+	src = _mm256_inserti128_si256 (_mm256_castsi128_si256 (lo), hi, 1);
+
+	if (is_opaque_256 (src))
+	    save_256_aligned (pd, src);
+	else if (!is_zero_256 (src))
+	    save_256_aligned (pd, over_8x32 (src, load_256_aligned (pd)));
+
+	w -= 8;
+	pd += 8;
+    }
+
+    while (w)
+    {
+	s = *(ps + pixman_fixed_to_int (vx));
+	vx += unit_x;
+	while (vx >= 0)
+	    vx -= src_width_fixed;
+
+	*pd = over_pixel (s, *pd);
+	pd++;
+	w--;
+    }
+}
+
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_cover_OVER,
+		       scaled_nearest_scanline_avx2_8888_8888_OVER,
+		       uint32_t, uint32_t, COVER)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_none_OVER,
+		       scaled_nearest_scanline_avx2_8888_8888_OVER,
+		       uint32_t, uint32_t, NONE)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_pad_OVER,
+		       scaled_nearest_scanline_avx2_8888_8888_OVER,
+		       uint32_t, uint32_t, PAD)
+FAST_NEAREST_MAINLOOP (avx2_8888_8888_normal_OVER,
+		       scaled_nearest_scanline_avx2_8888_8888_OVER,
+		       uint32_t, uint32_t, NORMAL)
+
+static const pixman_fast_path_t avx2_fast_paths[] =
+{
+    /* PIXMAN_OP_OVER */
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, x8b8g8r8, avx2_composite_over_8888_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8r8g8b8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8r8g8b8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, a8b8g8r8, avx2_composite_over_n_8_8888),
+    PIXMAN_STD_FAST_PATH (OVER, solid, a8, x8b8g8r8, avx2_composite_over_n_8_8888),
+
+    /* PIXMAN_OP_ADD */
+    PIXMAN_STD_FAST_PATH (ADD, a8, null, a8, avx2_composite_add_8_8),
+
+    /* PIXMAN_OP_SRC */
+    PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, a8r8g8b8, avx2_composite_src_x888_8888),
+    PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, a8b8g8r8, avx2_composite_src_x888_8888),
+
+    SIMPLE_NEAREST_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, avx2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, avx2_8888_8888),
+
+    { PIXMAN_OP_NONE },
+};
+
+/* ---------------------------------------------------------------------
+ * Bilinear cover iterator
+ *
+ * Same scheme as the SSSE3 one: each source line is interpolated
+ * horizontally once into a buffer of 16 bit channels, and the output
+ * scanline is the vertical interpolation of two such lines.  Here the
+ * horizontal pass does four pixels and the vertical pass eight per step.
+ */
+
+typedef struct
+{
+    int		y;
+    uint64_t *	buffer;
+} line_t;
+
+typedef struct
+{
+    line_t		lines[2];
+    pixman_fixed_t	y;
+    pixman_fixed_t	x;
+    uint64_t		data[1];
+} bilinear_info_t;
+
+/* Interpolate two pixel pairs held in the low 64 bits of each lane of
+ * vrl0 (left pixels) and vrl1 (right pixels), with weights from vx.
+ * See ssse3_fetch_horizontal() for the layout of the intermediates.
+ */
+static force_inline __m128i
+bilinear_horizontal_2 (__m128i vrl0, __m128i vrl1, __m128i vx)
+{
+    __m128i vw, vr, s;
+
+    vw = _mm_add_epi16 (_mm_set_epi16 (1, 0, 1, 0, 1, 0, 1, 0),
+			_mm_srli_epi16 (vx, 16 - BILINEAR_INTERPOLATION_BITS));
+    vw = _mm_packus_epi16 (vw, vw);
+
+    vr = _mm_unpacklo_epi16 (vrl1, vrl0);
+    s = _mm_shuffle_epi32 (vr, _MM_SHUFFLE (1, 0, 3, 2));
+    vr = _mm_unpackhi_epi8 (vr, s);
+
+    return _mm_abs_epi16 (_mm_maddubs_epi16 (vr, vw));
+}
+
+static void
+avx2_fetch_horizontal (bits_image_t *image, line_t *line,
+		       int y, pixman_fixed_t x, pixman_fixed_t ux, int n)
+{
+    uint32_t *bits = image->bits + y * image->rowstride;
+    __m256i vx = _mm256_set_epi16 (
+	- (x + 2 * ux + 1), x + 2 * ux, - (x + 2 * ux + 1), x + 2 * ux,
+	- (x + 3 * ux + 1), x + 3 * ux, - (x + 3 * ux + 1), x + 3 * ux,
+	- (x + 1), x, - (x + 1), x,
+	- (x + ux + 1), x + ux,  - (x + ux + 1), x + ux);
+    __m256i vux = _mm256_set1_epi32 (
+	(uint32_t)(uint16_t)(4 * ux) | ((uint32_t)(uint16_t)(- 4 * ux) << 16));
+    __m256i vaddc = _mm256_set1_epi32 (0x00010000);
+    __m256i *b = (__m256i *)line->buffer;
+
+    while (n >= 4)
+    {
+	__m256i vw, vr, s, vrl0, vrl1;
+
+	/* lane 0 gets pixels 0 and 1, lane 1 pixels 2 and 3; see
+	 * bilinear_horizontal_2() for what happens within a lane.
+	 */
+	vrl1 = _mm256_inserti128_si256 (
+	    _mm256_castsi128_si256 (_mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x + ux)))),
+	    _mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x + 3 * ux))), 1);
+	vrl0 = _mm256_inserti128_si256 (
+	    _mm256_castsi128_si256 (_mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x)))),
+	    _mm_loadl_epi64 (
+		(__m128i *)(bits + pixman_fixed_to_int (x + 2 * ux))), 1);
+
+	vw = _mm256_add_epi16 (
+	    vaddc, _mm256_srli_epi16 (vx, 16 - BILINEAR_INTERPOLATION_BITS));
+	vw = _mm256_packus_epi16 (vw, vw);
+	vx = _mm256_add_epi16 (vx, vux);
+
+	x += 4 * ux;
+
+	vr = _mm256_unpacklo_epi16 (vrl1, vrl0);
+	s = _mm256_shuffle_epi32 (vr, _MM_SHUFFLE (1, 0, 3, 2));
+	vr = _mm256_unpackhi_epi8 (vr, s);
+
+	/* See ssse3_fetch_horizontal() for why abs is needed */
+	vr = _mm256_abs_epi16 (_mm256_maddubs_epi16 (vr, vw));
+
+	_mm256_store_si256 (b++, vr);
+	n -= 4;
+    }
+
+    if (n)
+    {
+	__m128i *b2 = (__m128i *)b;
+	__m128i vx2 = _mm256_castsi256_si128 (vx);
+	__m128i vux2 = _mm_set1_epi32 (
+	    (uint32_t)(uint16_t)(2 * ux) | ((uint32_t)(uint16_t)(- 2 * ux) << 16));
+
+	while (n >= 2)
+	{
+	    _mm_store_si128 (b2++, bilinear_horizontal_2 (
+				 _mm_loadl_epi64 ((__m128i *)(bits + pixman_fixed_to_int (x))),
+				 _mm_loadl_epi64 ((__m128i *)(bits + pixman_fixed_to_int (x + ux))),
+				 vx2));
+	    vx2 = _mm_add_epi16 (vx2, vux2);
+	    x += 2 * ux;
+	    n -= 2;
+	}
+
+	if (n)
+	{
+	    _mm_store_si128 (b2, bilinear_horizontal_2 (
+				 _mm_loadl_epi64 ((__m128i *)(bits + pixman_fixed_to_int (x))),
+				 _mm_setzero_si128 (),
+				 vx2));
+	}
+    }
+
+    line->y = y;
+}
+
+static force_inline __m256i
+bilinear_vertical_4 (const uint64_t *top, const uint64_t *bot, __m256i vw)
+{
+    __m256i t = _mm256_load_si256 ((const __m256i *)top);
+    __m256i b = _mm256_load_si256 ((const __m256i *)bot);
+    __m256i r, tmp;
+
+    r = _mm256_mulhi_epu16 (_mm256_sub_epi16 (b, t), vw);
+    tmp = _mm256_and_si256 (_mm256_cmpgt_epi16 (t, b), vw);
+    r = _mm256_sub_epi16 (r, tmp);
+    r = _mm256_add_epi16 (r, t);
+    r = _mm256_srli_epi16 (r, BILINEAR_INTERPOLATION_BITS);
+
+    return _mm256_shuffle_epi32 (r, _MM_SHUFFLE (2, 0, 3, 1));
+}
+
+static uint32_t *
+avx2_fetch_bilinear_cover (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_fixed_t fx, ux;
+    bilinear_info_t *info = iter->data;
+    line_t *line0, *line1;
+    int y0, y1;
+    int32_t dist_y;
+    __m256i vw;
+    int i;
+
+    fx = info->x;
+    ux = iter->image->common.transform->matrix[0][0];
+
+    y0 = pixman_fixed_to_int (info->y);
+    y1 = y0 + 1;
+
+    line0 = &info->lines[y0 & 0x01];
+    line1 = &info->lines[y1 & 0x01];
+
+    if (line0->y != y0)
+    {
+	avx2_fetch_horizontal (
+	    &iter->image->bits, line0, y0, fx, ux, iter->width);
+    }
+
+    if (line1->y != y1)
+    {
+	avx2_fetch_horizontal (
+	    &iter->image->bits, line1, y1, fx, ux, iter->width);
+    }
+
+    dist_y = pixman_fixed_to_bilinear_weight (info->y);
+    dist_y <<= (16 - BILINEAR_INTERPOLATION_BITS);
+
+    vw = _mm256_set1_epi16 (dist_y);
+
+    for (i = 0; i + 7 < iter->width; i += 8)
+    {
+	__m256i r0 = bilinear_vertical_4 (line0->buffer + i,
+					  line1->buffer + i, vw);
+	__m256i r1 = bilinear_vertical_4 (line0->buffer + i + 4,
+					  line1->buffer + i + 4, vw);
+
+	/* The pack interleaves the lanes: 0 1 4 5 2 3 6 7 */
+	_mm256_storeu_si256 (
+	    (__m256i *)(iter->buffer + i),
+	    _mm256_permute4x64_epi64 (_mm256_packus_epi16 (r0, r1),
+				      _MM_SHUFFLE (3, 1, 2, 0)));
+    }
+
+    while (i < iter->width)
+    {
+	__m128i top0 = _mm_load_si128 ((__m128i *)(line0->buffer + i));
+	__m128i bot0 = _mm_load_si128 ((__m128i *)(line1->buffer + i));
+	__m128i vw1 = _mm256_castsi256_si128 (vw);
+	__m128i r0, tmp, p;
+
+	r0 = _mm_mulhi_epu16 (_mm_sub_epi16 (bot0, top0), vw1);
+	tmp = _mm_and_si128 (_mm_cmplt_epi16 (bot0, top0), vw1);
+	r0 = _mm_sub_epi16 (r0, tmp);
+	r0 = _mm_add_epi16 (r0, top0);
+	r0 = _mm_srli_epi16 (r0, BILINEAR_INTERPOLATION_BITS);
+	r0 = _mm_shuffle_epi32 (r0, _MM_SHUFFLE (2, 0, 3, 1));
+
+	p = _mm_packus_epi16 (r0, r0);
+
+	if (iter->width - i == 1)
+	{
+	    *(uint32_t *)(iter->buffer + i) = _mm_cvtsi128_si32 (p);
+	    i++;
+	}
+	else
+	{
+	    _mm_storel_epi64 ((__m128i *)(iter->buffer + i), p);
+	    i += 2;
+	}
+    }
+
+    info->y += iter->image->common.transform->matrix[1][1];
+
+    return iter->buffer;
+}
+
+static void
+avx2_bilinear_cover_iter_fini (pixman_iter_t *iter)
+{
+    free (iter->data);
+}
+
+static void
+avx2_bilinear_cover_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *iter_info)
+{
+    int width = iter->width;
+    bilinear_info_t *info;
+    pixman_vector_t v;
+
+    /* Reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (iter->image->common.transform, &v))
+	goto fail;
+
+    /* Each line is padded to a multiple of four entries and aligned
+     * on 32 bytes, for the 256 bit loads and stores.
+     */
+    info = malloc (sizeof (*info) + (2 * ((width + 3) & ~3)) * sizeof (uint64_t) + 64);
+    if (!info)
+	goto fail;
+
+    info->x = v.vector[0] - pixman_fixed_1 / 2;
+    info->y = v.vector[1] - pixman_fixed_1 / 2;
+
+#define ALIGN(addr)							\
+    ((void *)((((uintptr_t)(addr)) + 31) & (~31)))
+
+    /* It is safe to set the y coordinates to -1 initially
+     * because COVER_CLIP_BILINEAR ensures that we will only
+     * be asked to fetch lines in the [0, height) interval
+     */
+    info->lines[0].y = -1;
+    info->lines[0].buffer = ALIGN (&(info->data[0]));
+    info->lines[1].y = -1;
+    info->lines[1].buffer = info->lines[0].buffer + ((width + 3) & ~3);
+
+    iter->get_scanline = avx2_fetch_bilinear_cover;
+    iter->fini = avx2_bilinear_cover_iter_fini;
+
+    iter->data = info;
+    return;
+
+fail:
+    /* Something went wrong, either a bad matrix or OOM; in such cases,
+     * we don't guarantee any particular rendering.
+     */
+    _pixman_log_error (
+	FUNC, "Allocation failure or bad matrix, skipping rendering\n");
+
+    iter->get_scanline = _pixman_iter_get_scanline_noop;
+    iter->fini = NULL;
+}
+
+static const pixman_iter_info_t avx2_iters[] =
+{
+    { PIXMAN_a8r8g8b8,
+      (FAST_PATH_STANDARD_FLAGS			|
+       FAST_PATH_SCALE_TRANSFORM		|
+       FAST_PATH_BILINEAR_FILTER		|
+       FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR),
+      ITER_NARROW | ITER_SRC,
+      avx2_bilinear_cover_iter_init,
+      NULL, NULL
+    },
+
+    { PIXMAN_null },
+};
+
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback)
+{
+    pixman_implementation_t *imp =
+	_pixman_implementation_create (fallback, avx2_fast_paths);
+
+    imp->combine_32[PIXMAN_OP_OVER] = avx2_combine_over_u;
+    imp->combine_32[PIXMAN_OP_OVER_REVERSE] = avx2_combine_over_reverse_u;
+    imp->combine_32[PIXMAN_OP_ADD] = avx2_combine_add_u;
+
+    imp->iter_info = avx2_iters;
+
+    return imp;
+}
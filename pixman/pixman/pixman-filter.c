@@ -322,6 +322,89 @@ filter_width (pixman_kernel_t reconstruct, pixman_kernel_t sample, double size)
     return ceil (filters[reconstruct].width + size * filters[sample].width);
 }
 
+/* Applications that scale many images with the same settings, such as
+ * thumbnailers, ask for the same kernels over and over, and sampling
+ * them is far from free, so the most recently created 1D kernels are
+ * kept in a small per-thread cache. Two entries hold the x and y
+ * kernels of one filter, and are kept to 2 kB in all as every thread
+ * gets its own copy. Kernels with more values than fit in an entry,
+ * such as those for large downscales, are always created from scratch.
+ */
+#define N_KERNEL_CACHE_ENTRIES		2
+#define KERNEL_CACHE_MAX_VALUES		256
+
+typedef struct
+{
+    pixman_kernel_t	reconstruct;
+    pixman_kernel_t	sample;
+    pixman_fixed_t	scale;
+    int			subsample_bits;
+    int			n_values;	/* 0 if the entry is unused */
+    pixman_fixed_t	values[KERNEL_CACHE_MAX_VALUES];
+} kernel_cache_entry_t;
+
+typedef struct
+{
+    kernel_cache_entry_t	entries[N_KERNEL_CACHE_ENTRIES];
+    int				next;
+} kernel_cache_t;
+
+PIXMAN_DEFINE_THREAD_LOCAL (kernel_cache_t, kernel_cache)
+
+static void
+get_1d_filter (int              width,
+	       pixman_kernel_t  reconstruct,
+	       pixman_kernel_t  sample,
+	       pixman_fixed_t   scale,
+	       int              subsample_bits,
+	       pixman_fixed_t  *pstart,
+	       pixman_fixed_t  *pend)
+{
+    int n_values = width << subsample_bits;
+    kernel_cache_t *cache;
+    kernel_cache_entry_t *entry;
+    int i;
+
+    if (n_values <= 0 || n_values > KERNEL_CACHE_MAX_VALUES)
+    {
+	create_1d_filter (width, reconstruct, sample,
+			  pixman_fixed_to_double (scale),
+			  1 << subsample_bits, pstart, pend);
+	return;
+    }
+
+    cache = PIXMAN_GET_THREAD_LOCAL (kernel_cache);
+
+    for (i = 0; i < N_KERNEL_CACHE_ENTRIES; ++i)
+    {
+	entry = &cache->entries[i];
+
+	if (entry->n_values == n_values		&&
+	    entry->scale == scale		&&
+	    entry->reconstruct == reconstruct	&&
+	    entry->sample == sample		&&
+	    entry->subsample_bits == subsample_bits)
+	{
+	    memcpy (pstart, entry->values, n_values * sizeof (pixman_fixed_t));
+	    return;
+	}
+    }
+
+    create_1d_filter (width, reconstruct, sample,
+		      pixman_fixed_to_double (scale),
+		      1 << subsample_bits, pstart, pend);
+
+    entry = &cache->entries[cache->next];
+    cache->next = (cache->next + 1) % N_KERNEL_CACHE_ENTRIES;
+
+    entry->reconstruct = reconstruct;
+    entry->sample = sample;
+    entry->scale = scale;
+    entry->subsample_bits = subsample_bits;
+    entry->n_values = n_values;
+    memcpy (entry->values, pstart, n_values * sizeof (pixman_fixed_t));
+}
+
 #ifdef PIXMAN_GNUPLOT
 
 /* If enable-gnuplot is configured, then you can pipe the output of a
@@ -477,10 +560,10 @@ pixman_filter_create_separable_convolution (int             *n_values,
             *xparams = params+4,
             *yparams = xparams + width*subsample_x,
             *endparams = params + *n_values;
-        create_1d_filter(width, reconstruct_x, sample_x, sx, subsample_x,
-                         xparams, yparams);
-        create_1d_filter(height, reconstruct_y, sample_y, sy, subsample_y,
-                         yparams, endparams);
+        get_1d_filter (width, reconstruct_x, sample_x,
+		       abs (scale_x), subsample_bits_x, xparams, yparams);
+        get_1d_filter (height, reconstruct_y, sample_y,
+		       abs (scale_y), subsample_bits_y, yparams, endparams);
     }
 
 #ifdef PIXMAN_GNUPLOT
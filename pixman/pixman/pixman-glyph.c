@@ -391,20 +391,27 @@ box32_intersect (pixman_box32_t *dest,
     return dest->x2 > dest->x1 && dest->y2 > dest->y1;
 }
 
-#if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
-__attribute__((__force_align_arg_pointer__))
-#endif
-PIXMAN_EXPORT void
-pixman_composite_glyphs_no_mask (pixman_op_t            op,
-				 pixman_image_t        *src,
-				 pixman_image_t        *dest,
-				 int32_t                src_x,
-				 int32_t                src_y,
-				 int32_t                dest_x,
-				 int32_t                dest_y,
-				 pixman_glyph_cache_t  *cache,
-				 int                    n_glyphs,
-				 const pixman_glyph_t  *glyphs)
+/* Composites each glyph directly onto @dest. The source and
+ * destination are aligned by (src_x, src_y) and (dest_x, dest_y), the
+ * composite is restricted to the (dest_x, dest_y, width, height)
+ * rectangle, and the glyph origins are at (glyph_x, glyph_y) in the
+ * destination.
+ */
+static void
+composite_glyphs_direct (pixman_op_t            op,
+			 pixman_image_t        *src,
+			 pixman_image_t        *dest,
+			 int32_t                src_x,
+			 int32_t                src_y,
+			 int32_t                dest_x,
+			 int32_t                dest_y,
+			 int32_t                width,
+			 int32_t                height,
+			 int32_t                glyph_x,
+			 int32_t                glyph_y,
+			 pixman_glyph_cache_t  *cache,
+			 int                    n_glyphs,
+			 const pixman_glyph_t  *glyphs)
 {
     pixman_region32_t region;
     pixman_format_code_t glyph_format = PIXMAN_null;
@@ -426,8 +433,8 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
     if (!_pixman_compute_composite_region32 (
 	    &region,
 	    src, NULL, dest,
-	    src_x - dest_x, src_y - dest_y, 0, 0, 0, 0,
-	    dest->bits.width, dest->bits.height))
+	    src_x, src_y, 0, 0, dest_x, dest_y,
+	    width, height))
     {
 	goto out;
     }
@@ -448,8 +455,8 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
 	pixman_box32_t composite_box;
 	int n;
 
-	glyph_box.x1 = dest_x + glyphs[i].x - glyph->origin_x;
-	glyph_box.y1 = dest_y + glyphs[i].y - glyph->origin_y;
+	glyph_box.x1 = glyph_x + glyphs[i].x - glyph->origin_x;
+	glyph_box.y1 = glyph_y + glyphs[i].y - glyph->origin_y;
 	glyph_box.x2 = glyph_box.x1 + glyph->image->bits.width;
 	glyph_box.y2 = glyph_box.y1 + glyph->image->bits.height;
 	
@@ -477,8 +484,8 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
 
 		info.src_x = src_x + composite_box.x1 - dest_x;
 		info.src_y = src_y + composite_box.y1 - dest_y;
-		info.mask_x = composite_box.x1 - (dest_x + glyphs[i].x - glyph->origin_x);
-		info.mask_y = composite_box.y1 - (dest_y + glyphs[i].y - glyph->origin_y);
+		info.mask_x = composite_box.x1 - glyph_box.x1;
+		info.mask_y = composite_box.y1 - glyph_box.y1;
 		info.dest_x = composite_box.x1;
 		info.dest_y = composite_box.y1;
 		info.width = composite_box.x2 - composite_box.x1;
@@ -498,6 +505,97 @@ out:
     pixman_region32_fini (&region);
 }
 
+#if defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+PIXMAN_EXPORT void
+pixman_composite_glyphs_no_mask (pixman_op_t            op,
+				 pixman_image_t        *src,
+				 pixman_image_t        *dest,
+				 int32_t                src_x,
+				 int32_t                src_y,
+				 int32_t                dest_x,
+				 int32_t                dest_y,
+				 pixman_glyph_cache_t  *cache,
+				 int                    n_glyphs,
+				 const pixman_glyph_t  *glyphs)
+{
+    composite_glyphs_direct (op, src, dest,
+			     src_x - dest_x, src_y - dest_y, 0, 0,
+			     dest->bits.width, dest->bits.height,
+			     dest_x, dest_y,
+			     cache, n_glyphs, glyphs);
+}
+
+/* Whether the glyph run can be composited without an intermediate
+ * mask. That is the case for a8 glyphs that don't overlap each other,
+ * when a zero mask leaves the destination alone. Text usually comes
+ * in lines with increasing x, so the overlap check only accepts glyphs
+ * that lie to the right of the previous glyph in the current line, or
+ * below everything so far, which starts a new line.
+ */
+static pixman_bool_t
+can_composite_glyphs_direct (pixman_op_t            op,
+			     pixman_image_t        *src,
+			     pixman_image_t        *dest,
+			     pixman_format_code_t   mask_format,
+			     int                    n_glyphs,
+			     const pixman_glyph_t  *glyphs)
+{
+    int32_t line_y1, line_y2, above_y2, last_x2;
+    int i;
+
+    if ((op != PIXMAN_OP_OVER && op != PIXMAN_OP_ADD)	||
+	mask_format != PIXMAN_a8			||
+	src->type != SOLID				||
+	dest->type != BITS				||
+	dest->common.alpha_map				||
+	PIXMAN_FORMAT_BPP (dest->bits.format) != 32)
+    {
+	return FALSE;
+    }
+
+    line_y1 = line_y2 = above_y2 = INT32_MIN;
+    last_x2 = INT32_MIN;
+
+    for (i = 0; i < n_glyphs; ++i)
+    {
+	const glyph_t *glyph = glyphs[i].glyph;
+	pixman_image_t *glyph_img = glyph->image;
+	int32_t x1, y1, x2, y2;
+
+	if (glyph_img->bits.format != PIXMAN_a8)
+	    return FALSE;
+
+	x1 = glyphs[i].x - glyph->origin_x;
+	y1 = glyphs[i].y - glyph->origin_y;
+	x2 = x1 + glyph_img->bits.width;
+	y2 = y1 + glyph_img->bits.height;
+
+	if (x1 == x2 || y1 == y2)
+	    continue;
+
+	if (y1 >= line_y2 && y1 >= above_y2)
+	{
+	    above_y2 = MAX (above_y2, line_y2);
+	    line_y1 = y1;
+	    line_y2 = y2;
+	}
+	else if (x1 >= last_x2 && y1 >= above_y2 && y1 >= line_y1)
+	{
+	    line_y2 = MAX (line_y2, y2);
+	}
+	else
+	{
+	    return FALSE;
+	}
+
+	last_x2 = x2;
+    }
+
+    return TRUE;
+}
+
 static void
 add_glyphs (pixman_glyph_cache_t *cache,
 	    pixman_image_t *dest,
@@ -655,6 +753,17 @@ pixman_composite_glyphs (pixman_op_t            op,
 {
     pixman_image_t *mask;
 
+    if (can_composite_glyphs_direct (op, src, dest, mask_format,
+				     n_glyphs, glyphs))
+    {
+	composite_glyphs_direct (op, src, dest,
+				 src_x, src_y, dest_x, dest_y,
+				 width, height,
+				 dest_x - mask_x, dest_y - mask_y,
+				 cache, n_glyphs, glyphs);
+	return;
+    }
+
     if (!(mask = pixman_image_create_bits (mask_format, width, height, NULL, -1)))
 	return;
 
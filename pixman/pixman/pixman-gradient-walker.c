@@ -26,6 +26,7 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
+#include <stdlib.h>
 #include "pixman-private.h"
 
 void
@@ -46,6 +47,12 @@ _pixman_gradient_walker_init (pixman_gradient_walker_t *walker,
     walker->b_s       = 0.0f;
     walker->b_b       = 0.0f;
     walker->repeat    = repeat;
+    walker->ramp      = NULL;
+    walker->last_x    = 0;
+    walker->last_buffer = NULL;
+
+    if (gradient->ramp && gradient->ramp_repeat == repeat)
+	walker->ramp = gradient->ramp;
 
     walker->need_reset = TRUE;
 }
@@ -188,6 +195,31 @@ pixman_gradient_walker_pixel_float (pixman_gradient_walker_t *walker,
     return f;
 }
 
+static uint32_t
+pixman_gradient_walker_pixel_ramp (pixman_gradient_walker_t *walker,
+				   pixman_fixed_48_16_t      x)
+{
+    int32_t t = (int32_t)x & 0xffff;
+
+    if (walker->repeat == PIXMAN_REPEAT_NORMAL)
+	return walker->ramp[t >> (16 - GRADIENT_RAMP_BITS)];
+
+    if (walker->repeat == PIXMAN_REPEAT_REFLECT)
+    {
+	if ((int32_t)x & 0x10000)
+	    t = 0xffff - t;
+
+	return walker->ramp[t >> (16 - GRADIENT_RAMP_BITS)];
+    }
+
+    if (x < 0)
+	return walker->ramp[GRADIENT_RAMP_SIZE];
+    else if (x >= pixman_fixed_1)
+	return walker->ramp[GRADIENT_RAMP_SIZE + 1];
+    else
+	return walker->ramp[t >> (16 - GRADIENT_RAMP_BITS)];
+}
+
 static uint32_t
 pixman_gradient_walker_pixel_32 (pixman_gradient_walker_t *walker,
 				 pixman_fixed_48_16_t      x)
@@ -219,12 +251,35 @@ pixman_gradient_walker_pixel_32 (pixman_gradient_walker_t *walker,
            (((uint32_t)(f.b + .5f) >>  0) & 0x000000ff);
 }
 
+static force_inline pixman_bool_t
+ramp_step_ok (double step)
+{
+    return step >= (pixman_fixed_1 >> GRADIENT_RAMP_BITS) ||
+	   step <= -(pixman_fixed_1 >> GRADIENT_RAMP_BITS);
+}
+
 void
 _pixman_gradient_walker_write_narrow (pixman_gradient_walker_t *walker,
 				      pixman_fixed_48_16_t      x,
 				      uint32_t                 *buffer)
 {
-    *buffer = pixman_gradient_walker_pixel_32 (walker, x);
+    /* Radial and conical gradients come here one pixel at a time. As
+     * for narrow spans, the ramp is only used when the pixel is at
+     * least one entry away from the pixel to its left.
+     */
+    if (walker->ramp && walker->last_buffer &&
+	buffer == walker->last_buffer + 1 &&
+	ramp_step_ok (x - walker->last_x))
+    {
+	*buffer = pixman_gradient_walker_pixel_ramp (walker, x);
+    }
+    else
+    {
+	*buffer = pixman_gradient_walker_pixel_32 (walker, x);
+    }
+
+    walker->last_x = x;
+    walker->last_buffer = buffer;
 }
 
 void
@@ -235,6 +290,38 @@ _pixman_gradient_walker_write_wide (pixman_gradient_walker_t *walker,
     *(argb_t *)buffer = pixman_gradient_walker_pixel_float (walker, x);
 }
 
+void
+_pixman_gradient_walker_write_narrow_span (pixman_gradient_walker_t *walker,
+					   pixman_fixed_48_16_t      x,
+					   double                    inc,
+					   const uint32_t           *mask,
+					   uint32_t                 *buffer,
+					   uint32_t                 *end)
+{
+    int i;
+
+    /* The ramp is only used when every pixel steps over at least one
+     * of its entries, so that it is no coarser than the pixels.
+     */
+    if (walker->ramp && ramp_step_ok (inc))
+    {
+	for (i = 0; buffer < end; i++, buffer++)
+	{
+	    if (!mask || *mask++)
+		*buffer = pixman_gradient_walker_pixel_ramp (
+		    walker, x + (pixman_fixed_48_16_t)(inc * i));
+	}
+	return;
+    }
+
+    for (i = 0; buffer < end; i++, buffer++)
+    {
+	if (!mask || *mask++)
+	    *buffer = pixman_gradient_walker_pixel_32 (
+		walker, x + (pixman_fixed_48_16_t)(inc * i));
+    }
+}
+
 void
 _pixman_gradient_walker_fill_narrow (pixman_gradient_walker_t *walker,
 				     pixman_fixed_48_16_t      x,
@@ -262,3 +349,67 @@ _pixman_gradient_walker_fill_wide (pixman_gradient_walker_t *walker,
     while (buffer_wide < end_wide)
 	*buffer_wide++ = color;
 }
+
+/* Narrow pixels of gradients that move by at least 1/GRADIENT_RAMP_SIZE
+ * of a period from one pixel to the next, whether in linear spans or
+ * radial and conical scanlines, are looked up in a table of
+ * GRADIENT_RAMP_SIZE colors covering one period, [0, 1), each sampled
+ * at the center of its cell. That replaces the per-pixel interpolation
+ * with a single load, and positions are quantized to no more than a
+ * pixel. For the NONE and PAD repeat modes the color is constant
+ * outside [0, 1), and two extra entries hold the colors before and
+ * after the period.
+ *
+ * The stops of a gradient never change after creation, but the colors
+ * between the first and last stop depend on the repeat mode, so this
+ * is called whenever the image properties change and the table is
+ * rebuilt when the repeat mode differs. Gradients with stops outside
+ * [0, 1], or with stops closer together than a table entry, such as
+ * hard stops, don't get a table.
+ */
+void
+_pixman_gradient_update_ramp (gradient_t *gradient)
+{
+    pixman_repeat_t repeat = gradient->common.repeat;
+    pixman_gradient_walker_t walker;
+    int i;
+
+    if (gradient->ramp && gradient->ramp_repeat == repeat)
+	return;
+
+    for (i = 0; i < gradient->n_stops; ++i)
+    {
+	if (gradient->stops[i].x < 0 || gradient->stops[i].x > pixman_fixed_1 ||
+	    (i > 0 && gradient->stops[i].x - gradient->stops[i - 1].x <
+	     (pixman_fixed_1 >> GRADIENT_RAMP_BITS)))
+	{
+	    free (gradient->ramp);
+	    gradient->ramp = NULL;
+	    return;
+	}
+    }
+
+    if (!gradient->ramp)
+    {
+	gradient->ramp = malloc ((GRADIENT_RAMP_SIZE + 2) * sizeof (uint32_t));
+	if (!gradient->ramp)
+	    return;
+    }
+
+    _pixman_gradient_walker_init (&walker, gradient, repeat);
+
+    for (i = 0; i < GRADIENT_RAMP_SIZE; ++i)
+    {
+	pixman_fixed_48_16_t x = (i << (16 - GRADIENT_RAMP_BITS)) +
+	    (1 << (15 - GRADIENT_RAMP_BITS));
+
+	gradient->ramp[i] = pixman_gradient_walker_pixel_32 (&walker, x);
+    }
+
+    gradient->ramp[GRADIENT_RAMP_SIZE] =
+	pixman_gradient_walker_pixel_32 (&walker, -1);
+    gradient->ramp[GRADIENT_RAMP_SIZE + 1] =
+	pixman_gradient_walker_pixel_32 (&walker, pixman_fixed_1);
+
+    gradient->ramp_repeat = repeat;
+}
@@ -73,6 +73,8 @@ gradient_property_changed (pixman_image_t *image)
 	end->color = stops[n - 1].color;
 	break;
     }
+
+    _pixman_gradient_update_ramp (gradient);
 }
 
 pixman_bool_t
@@ -101,6 +103,8 @@ _pixman_init_gradient (gradient_t *                  gradient,
     memcpy (gradient->stops, stops, n_stops * sizeof (pixman_gradient_stop_t));
     gradient->n_stops = n_stops;
 
+    gradient->ramp = NULL;
+
     gradient->common.property_changed = gradient_property_changed;
 
     return TRUE;
@@ -161,6 +165,8 @@ _pixman_image_fini (pixman_image_t *image)
 		free (image->gradient.stops - 1);
 	    }
 
+	    free (image->gradient.ramp);
+
 	    /* This will trigger if someone adds a property_changed
 	     * method to the linear/radial/conical gradient overwriting
 	     * the general one.
@@ -430,7 +436,9 @@ compute_image_info (pixman_image_t *image)
     else
 	flags |= FAST_PATH_UNIFIED_ALPHA;
 
-    flags |= (FAST_PATH_NO_ACCESSORS | FAST_PATH_NARROW_FORMAT);
+    flags |= (FAST_PATH_NO_ACCESSORS		|
+	      FAST_PATH_NARROW_FORMAT		|
+	      FAST_PATH_NO_DITHER);
 
     /* Type specific checks */
     switch (image->type)
@@ -470,6 +478,9 @@ compute_image_info (pixman_image_t *image)
 
 	if (PIXMAN_FORMAT_IS_WIDE (image->bits.format))
 	    flags &= ~FAST_PATH_NARROW_FORMAT;
+
+	if (image->bits.dither != PIXMAN_DITHER_NONE)
+	    flags &= ~FAST_PATH_NO_DITHER;
 	break;
 
     case RADIAL:
@@ -52,19 +52,77 @@ _pixman_implementation_create (pixman_implementation_t *fallback,
     return imp;
 }
 
-#define N_CACHED_FAST_PATHS 8
+/* The composite dispatch cache is a per-thread, set associative hash
+ * table keyed on the full (op, formats, flags) tuple. Each set is kept
+ * in most-recently-used order, so a hit moves the entry to the front
+ * of its set and a miss evicts the last entry.
+ *
+ * Every thread that composites gets its own copy, so entries refer to
+ * the fast path by its position in the implementation chain instead
+ * of copying it, which keeps them at 32 bytes and the 1024 entries
+ * at 32 kB.
+ */
+#define N_CACHE_SET_BITS	8
+#define N_CACHE_SETS		(1 << N_CACHE_SET_BITS)
+#define N_CACHE_WAYS		4
 
 typedef struct
 {
-    struct
-    {
-	pixman_implementation_t *	imp;
-	pixman_fast_path_t		fast_path;
-    } cache [N_CACHED_FAST_PATHS];
+    pixman_format_code_t	src_format;
+    uint32_t			src_flags;
+    pixman_format_code_t	mask_format;
+    uint32_t			mask_flags;
+    pixman_format_code_t	dest_format;
+    uint32_t			dest_flags;
+    uint8_t			op;
+    uint8_t			imp_level;	/* fallbacks below toplevel */
+    uint16_t			path;		/* index + 1, 0 if unused */
+    uint32_t			n_hits;
+} cache_entry_t;
+
+typedef struct
+{
+    cache_entry_t		cache [N_CACHE_SETS][N_CACHE_WAYS];
+    uint64_t			n_hits;
+    uint64_t			n_misses;
 } cache_t;
 
 PIXMAN_DEFINE_THREAD_LOCAL (cache_t, fast_path_cache)
 
+static force_inline uint32_t
+hash_fast_path (pixman_op_t          op,
+		pixman_format_code_t src_format,
+		uint32_t             src_flags,
+		pixman_format_code_t mask_format,
+		uint32_t             mask_flags,
+		pixman_format_code_t dest_format,
+		uint32_t             dest_flags)
+{
+    uint32_t h;
+
+    h = (uint32_t)op;
+    h = (h ^ src_format) * 0x9e3779b1;
+    h = (h ^ src_flags) * 0x9e3779b1;
+    h = (h ^ mask_format) * 0x9e3779b1;
+    h = (h ^ mask_flags) * 0x9e3779b1;
+    h = (h ^ dest_format) * 0x9e3779b1;
+    h = (h ^ dest_flags) * 0x9e3779b1;
+
+    return h >> (32 - N_CACHE_SET_BITS);
+}
+
+static force_inline pixman_implementation_t *
+cache_entry_imp (pixman_implementation_t *toplevel, const cache_entry_t *entry)
+{
+    pixman_implementation_t *imp = toplevel;
+    int i;
+
+    for (i = 0; i < entry->imp_level; ++i)
+	imp = imp->fallback;
+
+    return imp;
+}
+
 static void
 dummy_composite_rect (pixman_implementation_t *imp,
 		      pixman_composite_info_t *info)
@@ -84,38 +142,58 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 					 pixman_composite_func_t  *out_func)
 {
     pixman_implementation_t *imp;
+    cache_entry_t *set;
+    cache_entry_t entry;
     cache_t *cache;
+    int level;
     int i;
 
     /* Check cache for fast paths */
     cache = PIXMAN_GET_THREAD_LOCAL (fast_path_cache);
 
-    for (i = 0; i < N_CACHED_FAST_PATHS; ++i)
+    set = cache->cache[hash_fast_path (op,
+				       src_format, src_flags,
+				       mask_format, mask_flags,
+				       dest_format, dest_flags)];
+
+    for (i = 0; i < N_CACHE_WAYS; ++i)
     {
-	const pixman_fast_path_t *info = &(cache->cache[i].fast_path);
+	const cache_entry_t *e = &set[i];
 
 	/* Note that we check for equality here, not whether
 	 * the cached fast path matches. This is to prevent
 	 * us from selecting an overly general fast path
 	 * when a more specific one would work.
 	 */
-	if (info->op == op			&&
-	    info->src_format == src_format	&&
-	    info->mask_format == mask_format	&&
-	    info->dest_format == dest_format	&&
-	    info->src_flags == src_flags	&&
-	    info->mask_flags == mask_flags	&&
-	    info->dest_flags == dest_flags	&&
-	    info->func)
+	if (e->op == op				&&
+	    e->src_format == src_format		&&
+	    e->mask_format == mask_format	&&
+	    e->dest_format == dest_format	&&
+	    e->src_flags == src_flags		&&
+	    e->mask_flags == mask_flags		&&
+	    e->dest_flags == dest_flags		&&
+	    e->path)
 	{
-	    *out_imp = cache->cache[i].imp;
-	    *out_func = cache->cache[i].fast_path.func;
+	    imp = cache_entry_imp (toplevel, e);
+
+	    *out_imp = imp;
+	    *out_func = imp->fast_paths[e->path - 1].func;
+
+	    cache->n_hits++;
+	    set[i].n_hits++;
+
+	    if (i == 0)
+		return;
+
+	    entry = set[i];
 
 	    goto update_cache;
 	}
     }
 
-    for (imp = toplevel; imp != NULL; imp = imp->fallback)
+    cache->n_misses++;
+
+    for (imp = toplevel, level = 0; imp != NULL; imp = imp->fallback, ++level)
     {
 	const pixman_fast_path_t *info = imp->fast_paths;
 
@@ -137,10 +215,26 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 		*out_imp = imp;
 		*out_func = info->func;
 
-		/* Set i to the last spot in the cache so that the
-		 * move-to-front code below will work
+		/* Only cache what the compact entries can refer to */
+		if (level > 0xff || info - imp->fast_paths >= 0xffff)
+		    return;
+
+		entry.op = op;
+		entry.src_format = src_format;
+		entry.src_flags = src_flags;
+		entry.mask_format = mask_format;
+		entry.mask_flags = mask_flags;
+		entry.dest_format = dest_format;
+		entry.dest_flags = dest_flags;
+		entry.imp_level = level;
+		entry.path = info - imp->fast_paths + 1;
+		entry.n_hits = 0;
+
+		/* Set i to the last way in the set so that the
+		 * move-to-front code below will evict the least
+		 * recently used entry
 		 */
-		i = N_CACHED_FAST_PATHS - 1;
+		i = N_CACHE_WAYS - 1;
 
 		goto update_cache;
 	    }
@@ -162,21 +256,70 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
     return;
 
 update_cache:
-    if (i)
+    while (i--)
+	set[i + 1] = set[i];
+
+    set[0] = entry;
+}
+
+/* These functions are exported for the sake of the test suite and
+ * benchmarks and not part of the ABI. They only see the cache of the
+ * calling thread.
+ */
+PIXMAN_EXPORT int
+_pixman_internal_only_get_fast_path_cache_stats (
+    pixman_cached_fast_path_t *entries,
+    int                        n_entries,
+    uint64_t                  *n_hits,
+    uint64_t                  *n_misses)
+{
+    cache_t *cache = PIXMAN_GET_THREAD_LOCAL (fast_path_cache);
+    int i, j, n = 0;
+
+    if (n_hits)
+	*n_hits = cache->n_hits;
+    if (n_misses)
+	*n_misses = cache->n_misses;
+
+    for (i = 0; i < N_CACHE_SETS; ++i)
     {
-	while (i--)
-	    cache->cache[i + 1] = cache->cache[i];
-
-	cache->cache[0].imp = *out_imp;
-	cache->cache[0].fast_path.op = op;
-	cache->cache[0].fast_path.src_format = src_format;
-	cache->cache[0].fast_path.src_flags = src_flags;
-	cache->cache[0].fast_path.mask_format = mask_format;
-	cache->cache[0].fast_path.mask_flags = mask_flags;
-	cache->cache[0].fast_path.dest_format = dest_format;
-	cache->cache[0].fast_path.dest_flags = dest_flags;
-	cache->cache[0].fast_path.func = *out_func;
+	for (j = 0; j < N_CACHE_WAYS; ++j)
+	{
+	    const cache_entry_t *e = &cache->cache[i][j];
+
+	    if (!e->path)
+		continue;
+
+	    if (n < n_entries)
+	    {
+		pixman_implementation_t *imp =
+		    cache_entry_imp (get_implementation (), e);
+		pixman_fast_path_t *path = &entries[n].fast_path;
+
+		path->op = e->op;
+		path->src_format = e->src_format;
+		path->src_flags = e->src_flags;
+		path->mask_format = e->mask_format;
+		path->mask_flags = e->mask_flags;
+		path->dest_format = e->dest_format;
+		path->dest_flags = e->dest_flags;
+		path->func = imp->fast_paths[e->path - 1].func;
+		entries[n].n_hits = e->n_hits;
+	    }
+
+	    n++;
+	}
     }
+
+    return n;
+}
+
+PIXMAN_EXPORT void
+_pixman_internal_only_reset_fast_path_cache (void)
+{
+    cache_t *cache = PIXMAN_GET_THREAD_LOCAL (fast_path_cache);
+
+    memset (cache, 0, sizeof *cache);
 }
 
 static void
@@ -402,6 +545,8 @@ _pixman_choose_implementation (void)
 
     imp = _pixman_implementation_create_noop (imp);
 
+    _pixman_trace_init ();
+
     if (_pixman_disabled ("wholeops"))
     {
         pixman_implementation_t *cur;
@@ -165,6 +165,11 @@ linear_get_scanline (pixman_iter_t                 *iter,
 	{
 	    fill_pixel (&walker, t, buffer, end);
 	}
+	else if (Bpp == 4)
+	{
+	    _pixman_gradient_walker_write_narrow_span (
+		&walker, t, inc, mask, buffer, end);
+	}
 	else
 	{
 	    int i;
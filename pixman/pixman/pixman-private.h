@@ -133,6 +133,12 @@ struct gradient
     image_common_t	    common;
     int                     n_stops;
     pixman_gradient_stop_t *stops;
+
+    /* Premultiplied colors for one period of the gradient, see
+     * _pixman_gradient_update_ramp()
+     */
+    uint32_t *              ramp;
+    pixman_repeat_t	    ramp_repeat;
 };
 
 struct linear_gradient
@@ -355,9 +361,19 @@ typedef struct
     int                     num_stops;
     pixman_repeat_t	    repeat;
 
+    const uint32_t *        ramp;
+    pixman_fixed_48_16_t    last_x;	  /* of the last narrow pixel written */
+    uint32_t *              last_buffer;
+
     pixman_bool_t           need_reset;
 } pixman_gradient_walker_t;
 
+#define GRADIENT_RAMP_BITS	10
+#define GRADIENT_RAMP_SIZE	(1 << GRADIENT_RAMP_BITS)
+
+void
+_pixman_gradient_update_ramp (gradient_t *gradient);
+
 void
 _pixman_gradient_walker_init (pixman_gradient_walker_t *walker,
                               gradient_t *              gradient,
@@ -388,6 +404,14 @@ typedef void (*pixman_gradient_walker_fill_t) (
     uint32_t                 *buffer,
     uint32_t                 *end);
 
+void
+_pixman_gradient_walker_write_narrow_span(pixman_gradient_walker_t *walker,
+					  pixman_fixed_48_16_t      x,
+					  double                    inc,
+					  const uint32_t           *mask,
+					  uint32_t                 *buffer,
+					  uint32_t                 *end);
+
 void
 _pixman_gradient_walker_fill_narrow(pixman_gradient_walker_t *walker,
 				    pixman_fixed_48_16_t      x,
@@ -630,6 +654,11 @@ pixman_implementation_t *
 _pixman_implementation_create_ssse3 (pixman_implementation_t *fallback);
 #endif
 
+#ifdef USE_AVX2
+pixman_implementation_t *
+_pixman_implementation_create_avx2 (pixman_implementation_t *fallback);
+#endif
+
 #ifdef USE_ARM_SIMD
 pixman_implementation_t *
 _pixman_implementation_create_arm_simd (pixman_implementation_t *fallback);
@@ -738,6 +767,7 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 #define FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR	(1 << 24)
 #define FAST_PATH_BITS_IMAGE			(1 << 25)
 #define FAST_PATH_SEPARABLE_CONVOLUTION_FILTER  (1 << 26)
+#define FAST_PATH_NO_DITHER			(1 << 27)
 
 #define FAST_PATH_PAD_REPEAT						\
     (FAST_PATH_NO_NONE_REPEAT		|				\
@@ -770,6 +800,11 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
      FAST_PATH_NO_ALPHA_MAP		|				\
      FAST_PATH_NARROW_FORMAT)
 
+#define FAST_PATH_WIDE_DEST_FLAGS					\
+    (FAST_PATH_NO_ACCESSORS		|				\
+     FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_NO_DITHER)
+
 #define SOURCE_FLAGS(format)						\
     (FAST_PATH_STANDARD_FLAGS |						\
      ((PIXMAN_ ## format == PIXMAN_solid) ?				\
@@ -804,6 +839,18 @@ _pixman_iter_init_bits_stride (pixman_iter_t *iter, const pixman_iter_info_t *in
 	    dest, FAST_PATH_STD_DEST_FLAGS,				\
 	    func) }
 
+/* Fast paths where any of the images may have more than 8 bits per
+ * channel. These must give the same results as the general wide
+ * pipeline, and they do not handle dithering.
+ */
+#define PIXMAN_WIDE_FAST_PATH(op, src, mask, dest, func)		\
+    { FAST_PATH (							\
+	    op,								\
+	    src,  SOURCE_FLAGS (src) & ~FAST_PATH_NARROW_FORMAT,	\
+	    mask, MASK_FLAGS (mask, FAST_PATH_UNIFIED_ALPHA),		\
+	    dest, FAST_PATH_WIDE_DEST_FLAGS,				\
+	    func) }
+
 extern pixman_implementation_t *global_implementation;
 
 static force_inline pixman_implementation_t *
@@ -822,6 +869,78 @@ get_implementation (void)
 PIXMAN_EXPORT pixman_implementation_t *
 _pixman_internal_only_get_implementation (void);
 
+/* Composite dispatch cache introspection, also for the test suite and
+ * benchmarks only. The statistics are those of the calling thread.
+ * Returns the number of cached fast paths, of which at most n_entries
+ * are copied to entries.
+ */
+typedef struct
+{
+    pixman_fast_path_t	fast_path;
+    uint32_t		n_hits;
+} pixman_cached_fast_path_t;
+
+PIXMAN_EXPORT int
+_pixman_internal_only_get_fast_path_cache_stats (
+    pixman_cached_fast_path_t *entries,
+    int                        n_entries,
+    uint64_t                  *n_hits,
+    uint64_t                  *n_misses);
+
+PIXMAN_EXPORT void
+_pixman_internal_only_reset_fast_path_cache (void);
+
+/* Thread pool */
+typedef void (*pixman_band_func_t) (void *data, int band, int n_bands);
+
+int
+_pixman_thread_pool_get_n_threads (void);
+
+pixman_bool_t
+_pixman_thread_pool_run (pixman_band_func_t func, void *data, int n_bands);
+
+/* Call recording, see pixman-trace.c */
+extern pixman_bool_t _pixman_trace_enabled;
+
+void
+_pixman_trace_init (void);
+
+void
+_pixman_trace_composite (pixman_op_t      op,
+			 pixman_image_t * src,
+			 pixman_image_t * mask,
+			 pixman_image_t * dest,
+			 int32_t          src_x,
+			 int32_t          src_y,
+			 int32_t          mask_x,
+			 int32_t          mask_y,
+			 int32_t          dest_x,
+			 int32_t          dest_y,
+			 int32_t          width,
+			 int32_t          height,
+			 pixman_bool_t    threaded);
+
+void
+_pixman_trace_fill (int      stride,
+		    int      bpp,
+		    int      x,
+		    int      y,
+		    int      width,
+		    int      height,
+		    uint32_t filler);
+
+void
+_pixman_trace_blt (int src_stride,
+		   int dst_stride,
+		   int src_bpp,
+		   int dst_bpp,
+		   int src_x,
+		   int src_y,
+		   int dest_x,
+		   int dest_y,
+		   int width,
+		   int height);
+
 /* Memory allocation helpers */
 void *
 pixman_malloc_ab (unsigned int n, unsigned int b);
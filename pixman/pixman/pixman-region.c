@@ -1367,6 +1367,33 @@ PREFIX (_union_rect) (region_type_t *dest,
     return PREFIX (_union) (dest, source, &region);
 }
 
+/* Union of a region with an arbitrary array of boxes. The boxes are
+ * sorted and merged into a banded region in one go, and that is then
+ * merged with source in a single sweep, instead of one sweep over the
+ * whole region per box as with repeated calls to _union_rect().
+ */
+PIXMAN_EXPORT pixman_bool_t
+PREFIX (_union_boxes) (region_type_t *      dest,
+                       const region_type_t *source,
+                       const box_type_t *   boxes,
+                       int                  count)
+{
+    region_type_t region;
+    pixman_bool_t ret;
+
+    if (!PREFIX (_init_rects) (&region, boxes, count))
+    {
+	PREFIX (_fini) (&region);
+	return pixman_break (dest);
+    }
+
+    ret = PREFIX (_union) (dest, source, &region);
+
+    PREFIX (_fini) (&region);
+
+    return ret;
+}
+
 PIXMAN_EXPORT pixman_bool_t
 PREFIX (_union) (region_type_t *      new_reg,
                  const region_type_t *reg1,
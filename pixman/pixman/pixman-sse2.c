@@ -4479,6 +4479,48 @@ sse2_composite_add_8_8 (pixman_implementation_t *imp,
 	src_line += src_stride;
 	w = width;
 
+	/* Narrow spans, as when accumulating glyphs into a mask, are
+	 * not worth aligning; add them 8 and 4 bytes at a time.
+	 */
+	if (w < 16)
+	{
+	    if (w >= 8)
+	    {
+		_mm_storel_epi64 (
+		    (__m128i *)dst,
+		    _mm_adds_epu8 (_mm_loadl_epi64 ((__m128i *)src),
+				   _mm_loadl_epi64 ((__m128i *)dst)));
+
+		dst += 8;
+		src += 8;
+		w -= 8;
+	    }
+
+	    if (w >= 4)
+	    {
+		uint32_t s, d;
+
+		memcpy (&s, src, sizeof (uint32_t));
+		memcpy (&d, dst, sizeof (uint32_t));
+		d = _mm_cvtsi128_si32 (
+		    _mm_adds_epu8 (_mm_cvtsi32_si128 (s), _mm_cvtsi32_si128 (d)));
+		memcpy (dst, &d, sizeof (uint32_t));
+
+		dst += 4;
+		src += 4;
+		w -= 4;
+	    }
+
+	    while (w)
+	    {
+		t = (*dst) + (*src++);
+		*dst++ = t | (0 - (t >> 8));
+		w--;
+	    }
+
+	    continue;
+	}
+
 	/* Small head */
 	while (w && (uintptr_t)dst & 3)
 	{
@@ -4826,6 +4868,415 @@ sse2_composite_copy_area (pixman_implementation_t *imp,
 	      src_x, src_y, dest_x, dest_y, width, height);
 }
 
+/*
+ * Fast paths for destinations with more than 8 bits per channel. The
+ * general implementation composites those in floating point, so to
+ * give identical results the pixels are converted and combined with
+ * exactly the same float operations as pixman-access.c and
+ * pixman-combine-float.c use, just four pixels at a time.
+ */
+static force_inline void
+expand_8888_float (__m128i p, pixman_bool_t has_alpha,
+		   __m128 *a, __m128 *r, __m128 *g, __m128 *b)
+{
+    const __m128 scale = _mm_set1_ps (1.f / 255.f);
+    const __m128i mask = _mm_set1_epi32 (0xff);
+
+    if (has_alpha)
+	*a = _mm_mul_ps (_mm_cvtepi32_ps (_mm_srli_epi32 (p, 24)), scale);
+    else
+	*a = _mm_set1_ps (1.f);
+
+    *r = _mm_mul_ps (_mm_cvtepi32_ps (
+			 _mm_and_si128 (_mm_srli_epi32 (p, 16), mask)), scale);
+    *g = _mm_mul_ps (_mm_cvtepi32_ps (
+			 _mm_and_si128 (_mm_srli_epi32 (p, 8), mask)), scale);
+    *b = _mm_mul_ps (_mm_cvtepi32_ps (_mm_and_si128 (p, mask)), scale);
+}
+
+static force_inline void
+expand_2x10_float (__m128i p, pixman_bool_t has_alpha,
+		   __m128 *a, __m128 *r, __m128 *g, __m128 *b)
+{
+    const __m128 scale = _mm_set1_ps (1.f / 1023.f);
+    const __m128i mask = _mm_set1_epi32 (0x3ff);
+
+    if (has_alpha)
+    {
+	*a = _mm_mul_ps (_mm_cvtepi32_ps (_mm_srli_epi32 (p, 30)),
+			 _mm_set1_ps (1.f / 3.f));
+    }
+    else
+    {
+	*a = _mm_set1_ps (1.f);
+    }
+
+    *r = _mm_mul_ps (_mm_cvtepi32_ps (
+			 _mm_and_si128 (_mm_srli_epi32 (p, 20), mask)), scale);
+    *g = _mm_mul_ps (_mm_cvtepi32_ps (
+			 _mm_and_si128 (_mm_srli_epi32 (p, 10), mask)), scale);
+    *b = _mm_mul_ps (_mm_cvtepi32_ps (_mm_and_si128 (p, mask)), scale);
+}
+
+/* pixman_float_to_unorm() */
+static force_inline __m128i
+float_to_unorm_sse2 (__m128 f, int n_bits)
+{
+    __m128i u;
+
+    f = _mm_min_ps (f, _mm_set1_ps (1.f));
+    f = _mm_max_ps (f, _mm_setzero_ps ());
+
+    u = _mm_cvttps_epi32 (_mm_mul_ps (f, _mm_set1_ps (1 << n_bits)));
+
+    return _mm_sub_epi32 (u, _mm_srli_epi32 (u, n_bits));
+}
+
+static force_inline __m128i
+contract_2x10_float (__m128 a, __m128 r, __m128 g, __m128 b,
+		     pixman_bool_t has_alpha)
+{
+    __m128i p;
+
+    p = _mm_or_si128 (_mm_slli_epi32 (float_to_unorm_sse2 (r, 10), 20),
+		      _mm_slli_epi32 (float_to_unorm_sse2 (g, 10), 10));
+    p = _mm_or_si128 (p, float_to_unorm_sse2 (b, 10));
+
+    if (has_alpha)
+	p = _mm_or_si128 (p, _mm_slli_epi32 (float_to_unorm_sse2 (a, 2), 30));
+
+    return p;
+}
+
+/* MIN (1, s + d * (1 - sa)) for each channel, as combine_over_u_float() */
+static force_inline void
+over_float_sse2 (__m128 sa, __m128 sr, __m128 sg, __m128 sb,
+		 __m128 *da, __m128 *dr, __m128 *dg, __m128 *db)
+{
+    const __m128 one = _mm_set1_ps (1.f);
+    __m128 isa = _mm_sub_ps (one, sa);
+
+    *da = _mm_min_ps (one, _mm_add_ps (sa, _mm_mul_ps (*da, isa)));
+    *dr = _mm_min_ps (one, _mm_add_ps (sr, _mm_mul_ps (*dr, isa)));
+    *dg = _mm_min_ps (one, _mm_add_ps (sg, _mm_mul_ps (*dg, isa)));
+    *db = _mm_min_ps (one, _mm_add_ps (sb, _mm_mul_ps (*db, isa)));
+}
+
+static force_inline __m128i
+over_8888_2x10_4 (__m128i s, uint32_t *dst, pixman_bool_t dst_alpha)
+{
+    __m128 sa, sr, sg, sb, da, dr, dg, db;
+
+    expand_8888_float (s, TRUE, &sa, &sr, &sg, &sb);
+
+    /* An opaque source replaces the destination, as d * 0 is 0 */
+    if (!is_opaque (s))
+    {
+	__m128i d = load_128_unaligned ((__m128i *)dst);
+
+	expand_2x10_float (d, dst_alpha, &da, &dr, &dg, &db);
+	over_float_sse2 (sa, sr, sg, sb, &da, &dr, &dg, &db);
+
+	return contract_2x10_float (da, dr, dg, db, dst_alpha);
+    }
+
+    return contract_2x10_float (sa, sr, sg, sb, dst_alpha);
+}
+
+static force_inline void
+over_8888_2x10 (uint32_t *dst, const uint32_t *src, int w,
+		pixman_bool_t dst_alpha)
+{
+    __m128 sa, sr, sg, sb, da, dr, dg, db;
+
+    while (w >= 4)
+    {
+	__m128i s = load_128_unaligned ((__m128i *)src);
+
+	/* A transparent source leaves the destination as it is */
+	if (!is_zero (s))
+	    save_128_unaligned ((__m128i *)dst, over_8888_2x10_4 (s, dst, dst_alpha));
+
+	dst += 4;
+	src += 4;
+	w -= 4;
+    }
+
+    while (w--)
+    {
+	uint32_t s = *src++;
+
+	if (s)
+	{
+	    expand_8888_float (_mm_cvtsi32_si128 (s), TRUE, &sa, &sr, &sg, &sb);
+	    expand_2x10_float (_mm_cvtsi32_si128 (*dst), dst_alpha,
+			       &da, &dr, &dg, &db);
+	    over_float_sse2 (sa, sr, sg, sb, &da, &dr, &dg, &db);
+
+	    *dst = _mm_cvtsi128_si32 (
+		contract_2x10_float (da, dr, dg, db, dst_alpha));
+	}
+
+	dst++;
+    }
+}
+
+static void
+sse2_composite_over_8888_2x10 (pixman_implementation_t *imp,
+			       pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_bool_t dst_alpha = PIXMAN_FORMAT_A (dest_image->bits.format) != 0;
+    uint32_t *dst_line, *src_line;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	if (dst_alpha)
+	    over_8888_2x10 (dst_line, src_line, width, TRUE);
+	else
+	    over_8888_2x10 (dst_line, src_line, width, FALSE);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static force_inline void
+src_x888_2x10 (uint32_t *dst, const uint32_t *src, int w,
+	       pixman_bool_t src_alpha, pixman_bool_t dst_alpha)
+{
+    __m128 a, r, g, b;
+
+    while (w >= 4)
+    {
+	expand_8888_float (load_128_unaligned ((__m128i *)src), src_alpha,
+			   &a, &r, &g, &b);
+	save_128_unaligned ((__m128i *)dst,
+			    contract_2x10_float (a, r, g, b, dst_alpha));
+
+	dst += 4;
+	src += 4;
+	w -= 4;
+    }
+
+    while (w--)
+    {
+	expand_8888_float (_mm_cvtsi32_si128 (*src++), src_alpha,
+			   &a, &r, &g, &b);
+	*dst++ = _mm_cvtsi128_si32 (contract_2x10_float (a, r, g, b, dst_alpha));
+    }
+}
+
+static void
+sse2_composite_src_x888_2x10 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_bool_t src_alpha = PIXMAN_FORMAT_A (src_image->bits.format) != 0;
+    pixman_bool_t dst_alpha = PIXMAN_FORMAT_A (dest_image->bits.format) != 0;
+    uint32_t *dst_line, *src_line;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, uint32_t, src_stride, src_line, 1);
+
+    while (height--)
+    {
+	if (!dst_alpha)
+	    src_x888_2x10 (dst_line, src_line, width, FALSE, FALSE);
+	else if (src_alpha)
+	    src_x888_2x10 (dst_line, src_line, width, TRUE, TRUE);
+	else
+	    src_x888_2x10 (dst_line, src_line, width, FALSE, TRUE);
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static force_inline void
+over_n_8_2x10 (uint32_t *dst, const uint8_t *mask, int w, const argb_t *c,
+	       pixman_bool_t dst_alpha)
+{
+    const __m128 scale = _mm_set1_ps (1.f / 255.f);
+    __m128 da, dr, dg, db, ma;
+
+    while (w >= 4)
+    {
+	uint32_t m;
+
+	memcpy (&m, mask, 4);
+
+	if (m)
+	{
+	    __m128i mm = _mm_unpacklo_epi16 (
+		_mm_unpacklo_epi8 (_mm_cvtsi32_si128 (m), _mm_setzero_si128 ()),
+		_mm_setzero_si128 ());
+
+	    ma = _mm_mul_ps (_mm_cvtepi32_ps (mm), scale);
+
+	    expand_2x10_float (load_128_unaligned ((__m128i *)dst), dst_alpha,
+			       &da, &dr, &dg, &db);
+	    over_float_sse2 (_mm_mul_ps (_mm_set1_ps (c->a), ma),
+			     _mm_mul_ps (_mm_set1_ps (c->r), ma),
+			     _mm_mul_ps (_mm_set1_ps (c->g), ma),
+			     _mm_mul_ps (_mm_set1_ps (c->b), ma),
+			     &da, &dr, &dg, &db);
+	    save_128_unaligned ((__m128i *)dst,
+				contract_2x10_float (da, dr, dg, db, dst_alpha));
+	}
+
+	dst += 4;
+	mask += 4;
+	w -= 4;
+    }
+
+    while (w--)
+    {
+	uint8_t m = *mask++;
+
+	if (m)
+	{
+	    ma = _mm_mul_ps (_mm_set1_ps (m), scale);
+
+	    expand_2x10_float (_mm_cvtsi32_si128 (*dst), dst_alpha,
+			       &da, &dr, &dg, &db);
+	    over_float_sse2 (_mm_mul_ps (_mm_set1_ps (c->a), ma),
+			     _mm_mul_ps (_mm_set1_ps (c->r), ma),
+			     _mm_mul_ps (_mm_set1_ps (c->g), ma),
+			     _mm_mul_ps (_mm_set1_ps (c->b), ma),
+			     &da, &dr, &dg, &db);
+	    *dst = _mm_cvtsi128_si32 (
+		contract_2x10_float (da, dr, dg, db, dst_alpha));
+	}
+
+	dst++;
+    }
+}
+
+static void
+sse2_composite_over_n_8_2x10 (pixman_implementation_t *imp,
+			      pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_bool_t dst_alpha = PIXMAN_FORMAT_A (dest_image->bits.format) != 0;
+    uint32_t *dst_line;
+    uint8_t *mask_line;
+    int dst_stride, mask_stride;
+    argb_t c;
+
+    /* The color as the wide solid source iterator sees it */
+    if (src_image->type == SOLID)
+	c = src_image->solid.color_float;
+    else
+	c = src_image->bits.fetch_pixel_float (&src_image->bits, 0, 0);
+
+    if (c.a == 0.f && c.r == 0.f && c.g == 0.f && c.b == 0.f)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, mask_x, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    while (height--)
+    {
+	if (dst_alpha)
+	    over_n_8_2x10 (dst_line, mask_line, width, &c, TRUE);
+	else
+	    over_n_8_2x10 (dst_line, mask_line, width, &c, FALSE);
+
+	dst_line += dst_stride;
+	mask_line += mask_stride;
+    }
+}
+
+static void
+sse2_composite_over_float (pixman_implementation_t *imp,
+			   pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    const __m128 one = _mm_set1_ps (1.f);
+    float *dst_line, *src_line;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, float, dst_stride, dst_line, 4);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, float, src_stride, src_line, 4);
+
+    while (height--)
+    {
+	float *dst = dst_line;
+	const float *src = src_line;
+	int32_t w = width;
+
+	/* Pixels are r, g, b, a; the same expression applies to all
+	 * four channels.
+	 */
+	while (w--)
+	{
+	    __m128 s = _mm_loadu_ps (src);
+	    __m128 sa = _mm_shuffle_ps (s, s, _MM_SHUFFLE (3, 3, 3, 3));
+	    __m128 d = _mm_loadu_ps (dst);
+
+	    d = _mm_add_ps (s, _mm_mul_ps (d, _mm_sub_ps (one, sa)));
+	    _mm_storeu_ps (dst, _mm_min_ps (one, d));
+
+	    dst += 4;
+	    src += 4;
+	}
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
+static void
+sse2_composite_src_float (pixman_implementation_t *imp,
+			  pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    const __m128 one = _mm_set1_ps (1.f);
+    const __m128 zero = _mm_setzero_ps ();
+    float *dst_line, *src_line;
+    int dst_stride, src_stride;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, float, dst_stride, dst_line, 4);
+    PIXMAN_IMAGE_GET_LINE (
+	src_image, src_x, src_y, float, src_stride, src_line, 4);
+
+    while (height--)
+    {
+	float *dst = dst_line;
+	const float *src = src_line;
+	int32_t w = width;
+
+	/* combine_src_u_float() clamps to 1 */
+	while (w--)
+	{
+	    __m128 s = _mm_add_ps (_mm_loadu_ps (src), zero);
+
+	    _mm_storeu_ps (dst, _mm_min_ps (one, s));
+
+	    dst += 4;
+	    src += 4;
+	}
+
+	dst_line += dst_stride;
+	src_line += src_stride;
+    }
+}
+
 static void
 sse2_composite_over_x888_8_8888 (pixman_implementation_t *imp,
                                  pixman_composite_info_t *info)
@@ -6273,6 +6724,21 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     PIXMAN_STD_FAST_PATH (SRC, r5g6b5, null, r5g6b5, sse2_composite_copy_area),
     PIXMAN_STD_FAST_PATH (SRC, b5g6r5, null, b5g6r5, sse2_composite_copy_area),
 
+    /* Wide formats */
+    PIXMAN_WIDE_FAST_PATH (OVER, a8r8g8b8, null, a2r10g10b10, sse2_composite_over_8888_2x10),
+    PIXMAN_WIDE_FAST_PATH (OVER, a8r8g8b8, null, x2r10g10b10, sse2_composite_over_8888_2x10),
+    PIXMAN_WIDE_FAST_PATH (OVER, solid, a8, a2r10g10b10, sse2_composite_over_n_8_2x10),
+    PIXMAN_WIDE_FAST_PATH (OVER, solid, a8, x2r10g10b10, sse2_composite_over_n_8_2x10),
+    PIXMAN_WIDE_FAST_PATH (OVER, rgba_float, null, rgba_float, sse2_composite_over_float),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8r8g8b8, null, a2r10g10b10, sse2_composite_src_x888_2x10),
+    PIXMAN_WIDE_FAST_PATH (SRC, a8r8g8b8, null, x2r10g10b10, sse2_composite_src_x888_2x10),
+    PIXMAN_WIDE_FAST_PATH (SRC, x8r8g8b8, null, a2r10g10b10, sse2_composite_src_x888_2x10),
+    PIXMAN_WIDE_FAST_PATH (SRC, x8r8g8b8, null, x2r10g10b10, sse2_composite_src_x888_2x10),
+    PIXMAN_WIDE_FAST_PATH (SRC, a2r10g10b10, null, a2r10g10b10, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (SRC, a2r10g10b10, null, x2r10g10b10, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (SRC, x2r10g10b10, null, x2r10g10b10, sse2_composite_copy_area),
+    PIXMAN_WIDE_FAST_PATH (SRC, rgba_float, null, rgba_float, sse2_composite_src_float),
+
     /* PIXMAN_OP_IN */
     PIXMAN_STD_FAST_PATH (IN, a8, null, a8, sse2_composite_in_8_8),
     PIXMAN_STD_FAST_PATH (IN, solid, a8, a8, sse2_composite_in_n_8_8),
@@ -6448,6 +6914,407 @@ sse2_fetch_a8 (pixman_iter_t *iter, const uint32_t *mask)
     return iter->buffer;
 }
 
+/* Separable convolution of scaled 32 bpp images
+ *
+ * With a scale transform every pixel of a scanline uses the same y
+ * phase, so the combined weights
+ *
+ *     f = ((pixman_fixed_32_32_t)fx * fy + 0x8000) >> 16
+ *
+ * that the generic code computes for each tap can be built once per y
+ * phase for all x phases. The taps are then summed with pmaddwd in the
+ * same integer arithmetic as the C code, so the results are
+ * identical. When all weights fit in 16 bits (downscaling, where the
+ * kernels are wide and the weights small) two taps go into each
+ * pmaddwd; otherwise each weight is split as f = 128 * fh + fl and
+ * multiplied with the pair (c << 7, c).
+ */
+#define SEPARABLE_MAX_WEIGHT_BYTES	(256 * 1024)
+
+typedef enum
+{
+    SEPARABLE_WEIGHTS_SHORT,
+    SEPARABLE_WEIGHTS_SPLIT,
+    SEPARABLE_WEIGHTS_NONE
+} separable_weights_t;
+
+typedef struct
+{
+    const pixman_fixed_t *	params;
+    int				cwidth;
+    int				cheight;
+    int				cwidth4;	/* cwidth rounded up to 4 */
+    int				x_phase_bits;
+    int				y_phase_bits;
+    int				py;		/* -1 if no weights are built */
+    separable_weights_t		type;
+    uint32_t			alpha;
+    __m128i *			weights;	/* NULL if too large */
+    int32_t *			products;
+    const uint32_t **		rows;
+    uint32_t *			tmp;
+} separable_info_t;
+
+static void
+sse2_separable_build_weights (separable_info_t *info, int py)
+{
+    int n_x_phases = 1 << info->x_phase_bits;
+    int cwidth = info->cwidth;
+    int cheight = info->cheight;
+    int cwidth4 = info->cwidth4;
+    const pixman_fixed_t *y_params =
+	info->params + 4 + n_x_phases * cwidth + py * cheight;
+    separable_weights_t type = SEPARABLE_WEIGHTS_SHORT;
+    int32_t *f = info->products;
+    __m128i *w = info->weights;
+    int px, i, j;
+
+    for (px = 0; px < n_x_phases; ++px)
+    {
+	const pixman_fixed_t *x_params = info->params + 4 + px * cwidth;
+
+	for (i = 0; i < cheight; ++i)
+	{
+	    for (j = 0; j < cwidth4; ++j)
+	    {
+		int32_t p = 0;
+
+		if (j < cwidth)
+		{
+		    p = ((pixman_fixed_32_32_t)x_params[j] * y_params[i] +
+			 0x8000) >> 16;
+		}
+
+		if (p < -0x8000 || p > 0x7fff)
+		{
+		    if (p < -(1 << 22) || p >= (1 << 22))
+			type = SEPARABLE_WEIGHTS_NONE;
+		    else if (type == SEPARABLE_WEIGHTS_SHORT)
+			type = SEPARABLE_WEIGHTS_SPLIT;
+		}
+
+		*f++ = p;
+	    }
+	}
+    }
+
+    info->py = py;
+    info->type = type;
+
+    f = info->products;
+    if (type == SEPARABLE_WEIGHTS_SHORT)
+    {
+	/* Taps 0 and 2 of each group of four pair up in the first
+	 * vector, taps 1 and 3 in the second.
+	 */
+	for (i = 0; i < n_x_phases * cheight * cwidth4; i += 4)
+	{
+	    *w++ = _mm_set1_epi32 ((f[i + 0] & 0xffff) | (f[i + 2] << 16));
+	    *w++ = _mm_set1_epi32 ((f[i + 1] & 0xffff) | (f[i + 3] << 16));
+	}
+    }
+    else if (type == SEPARABLE_WEIGHTS_SPLIT)
+    {
+	for (i = 0; i < n_x_phases * cheight * cwidth4; ++i)
+	    *w++ = _mm_set1_epi32 (((f[i] >> 7) & 0xffff) | ((f[i] & 0x7f) << 16));
+    }
+}
+
+static force_inline __m128i
+sse2_separable_row (const uint32_t *pixels, const __m128i *w, int n,
+		    separable_weights_t type, __m128i alpha, __m128i acc)
+{
+    __m128i zero = _mm_setzero_si128 ();
+    int i;
+
+    for (i = 0; i < n; i += 4)
+    {
+	__m128i p = _mm_or_si128 (
+	    _mm_loadu_si128 ((const __m128i *)(pixels + i)), alpha);
+	__m128i lo = _mm_unpacklo_epi8 (p, zero);
+	__m128i hi = _mm_unpackhi_epi8 (p, zero);
+
+	if (type == SEPARABLE_WEIGHTS_SHORT)
+	{
+	    acc = _mm_add_epi32 (
+		acc, _mm_madd_epi16 (_mm_unpacklo_epi16 (lo, hi), w[0]));
+	    acc = _mm_add_epi32 (
+		acc, _mm_madd_epi16 (_mm_unpackhi_epi16 (lo, hi), w[1]));
+	    w += 2;
+	}
+	else
+	{
+	    __m128i slo = _mm_slli_epi16 (lo, 7);
+	    __m128i shi = _mm_slli_epi16 (hi, 7);
+
+	    acc = _mm_add_epi32 (
+		acc, _mm_madd_epi16 (_mm_unpacklo_epi16 (slo, lo), w[0]));
+	    acc = _mm_add_epi32 (
+		acc, _mm_madd_epi16 (_mm_unpackhi_epi16 (slo, lo), w[1]));
+	    acc = _mm_add_epi32 (
+		acc, _mm_madd_epi16 (_mm_unpacklo_epi16 (shi, hi), w[2]));
+	    acc = _mm_add_epi32 (
+		acc, _mm_madd_epi16 (_mm_unpackhi_epi16 (shi, hi), w[3]));
+	    w += 4;
+	}
+    }
+
+    return acc;
+}
+
+static force_inline uint32_t
+sse2_separable_pixel (separable_info_t *info, bits_image_t *bits,
+		      pixman_repeat_t repeat_mode, int x1, int px,
+		      separable_weights_t type)
+{
+    int cwidth4 = info->cwidth4;
+    int vectors = (type == SEPARABLE_WEIGHTS_SHORT)? cwidth4 / 2 : cwidth4;
+    const __m128i *w = info->weights + px * info->cheight * vectors;
+    __m128i acc = _mm_setzero_si128 ();
+    int i, j;
+
+    if (x1 >= 0 && x1 + cwidth4 <= bits->width)
+    {
+	__m128i alpha = _mm_set1_epi32 (info->alpha);
+
+	for (i = 0; i < info->cheight; ++i, w += vectors)
+	{
+	    if (info->rows[i])
+	    {
+		acc = sse2_separable_row (
+		    info->rows[i] + x1, w, cwidth4, type, alpha, acc);
+	    }
+	}
+    }
+    else
+    {
+	for (i = 0; i < info->cheight; ++i, w += vectors)
+	{
+	    if (!info->rows[i])
+		continue;
+
+	    for (j = 0; j < info->cwidth; ++j)
+	    {
+		int rx = x1 + j;
+
+		if (repeat (repeat_mode, &rx, bits->width))
+		    info->tmp[j] = info->rows[i][rx] | info->alpha;
+		else
+		    info->tmp[j] = 0;
+	    }
+
+	    acc = sse2_separable_row (
+		info->tmp, w, cwidth4, type, _mm_setzero_si128 (), acc);
+	}
+    }
+
+    acc = _mm_srai_epi32 (_mm_add_epi32 (acc, _mm_set1_epi32 (0x8000)), 16);
+    acc = _mm_packs_epi32 (acc, acc);
+
+    return _mm_cvtsi128_si32 (_mm_packus_epi16 (acc, acc));
+}
+
+static uint32_t
+sse2_separable_pixel_scalar (separable_info_t *info, bits_image_t *bits,
+			     pixman_repeat_t repeat_mode, int x1, int px, int py)
+{
+    int n_x_phases = 1 << info->x_phase_bits;
+    const pixman_fixed_t *y_params =
+	info->params + 4 + n_x_phases * info->cwidth + py * info->cheight;
+    int satot, srtot, sgtot, sbtot;
+    int i, j;
+
+    satot = srtot = sgtot = sbtot = 0;
+
+    for (i = 0; i < info->cheight; ++i)
+    {
+	const pixman_fixed_t *x_params = info->params + 4 + px * info->cwidth;
+	pixman_fixed_t fy = y_params[i];
+
+	if (!fy || !info->rows[i])
+	    continue;
+
+	for (j = 0; j < info->cwidth; ++j)
+	{
+	    pixman_fixed_t fx = x_params[j];
+	    pixman_fixed_t f;
+	    uint32_t pixel;
+	    int rx = x1 + j;
+
+	    if (!fx || !repeat (repeat_mode, &rx, bits->width))
+		continue;
+
+	    pixel = info->rows[i][rx] | info->alpha;
+
+	    f = ((pixman_fixed_32_32_t)fx * fy + 0x8000) >> 16;
+	    srtot += (int)RED_8 (pixel) * f;
+	    sgtot += (int)GREEN_8 (pixel) * f;
+	    sbtot += (int)BLUE_8 (pixel) * f;
+	    satot += (int)ALPHA_8 (pixel) * f;
+	}
+    }
+
+    satot = CLIP ((satot + 0x8000) >> 16, 0, 0xff);
+    srtot = CLIP ((srtot + 0x8000) >> 16, 0, 0xff);
+    sgtot = CLIP ((sgtot + 0x8000) >> 16, 0, 0xff);
+    sbtot = CLIP ((sbtot + 0x8000) >> 16, 0, 0xff);
+
+    return (satot << 24) | (srtot << 16) | (sgtot << 8) | (sbtot << 0);
+}
+
+static uint32_t *
+sse2_fetch_separable_convolution (pixman_iter_t *iter, const uint32_t *mask)
+{
+    separable_info_t *info = iter->data;
+    pixman_image_t *image = iter->image;
+    bits_image_t *bits = &image->bits;
+    pixman_repeat_t repeat_mode = image->common.repeat;
+    int x_off = ((info->cwidth << 16) - pixman_fixed_1) >> 1;
+    int y_off = ((info->cheight << 16) - pixman_fixed_1) >> 1;
+    int x_phase_shift = 16 - info->x_phase_bits;
+    int y_phase_shift = 16 - info->y_phase_bits;
+    separable_weights_t type;
+    pixman_fixed_t vx, ux, y;
+    pixman_vector_t v;
+    int py, y1, i, k;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y++) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return iter->buffer;
+
+    ux = image->common.transform->matrix[0][0];
+    vx = v.vector[0];
+
+    y = ((v.vector[1] >> y_phase_shift) << y_phase_shift) +
+	((1 << y_phase_shift) >> 1);
+    py = (y & 0xffff) >> y_phase_shift;
+    y1 = pixman_fixed_to_int (y - pixman_fixed_e - y_off);
+
+    for (i = 0; i < info->cheight; ++i)
+    {
+	int ry = y1 + i;
+
+	if (repeat (repeat_mode, &ry, bits->height))
+	    info->rows[i] = bits->bits + bits->rowstride * ry;
+	else
+	    info->rows[i] = NULL;
+    }
+
+    if (info->weights && info->py != py)
+	sse2_separable_build_weights (info, py);
+
+    type = info->weights? info->type : SEPARABLE_WEIGHTS_NONE;
+
+    for (k = 0; k < iter->width; ++k, vx += ux)
+    {
+	pixman_fixed_t x;
+	int px, x1;
+
+	if (mask && !mask[k])
+	    continue;
+
+	/* Round x to the middle of the closest phase, like
+	 * bits_image_fetch_separable_convolution_affine() does.
+	 */
+	x = ((vx >> x_phase_shift) << x_phase_shift) +
+	    ((1 << x_phase_shift) >> 1);
+	px = (x & 0xffff) >> x_phase_shift;
+	x1 = pixman_fixed_to_int (x - pixman_fixed_e - x_off);
+
+	if (type == SEPARABLE_WEIGHTS_SHORT)
+	{
+	    iter->buffer[k] = sse2_separable_pixel (
+		info, bits, repeat_mode, x1, px, SEPARABLE_WEIGHTS_SHORT);
+	}
+	else if (type == SEPARABLE_WEIGHTS_SPLIT)
+	{
+	    iter->buffer[k] = sse2_separable_pixel (
+		info, bits, repeat_mode, x1, px, SEPARABLE_WEIGHTS_SPLIT);
+	}
+	else
+	{
+	    iter->buffer[k] = sse2_separable_pixel_scalar (
+		info, bits, repeat_mode, x1, px, py);
+	}
+    }
+
+    return iter->buffer;
+}
+
+static void
+sse2_separable_iter_fini (pixman_iter_t *iter)
+{
+    free (iter->data);
+}
+
+static void
+sse2_separable_iter_init (pixman_iter_t *iter, const pixman_iter_info_t *iter_info)
+{
+    const pixman_fixed_t *params = iter->image->common.filter_params;
+    int cwidth = pixman_fixed_to_int (params[0]);
+    int cheight = pixman_fixed_to_int (params[1]);
+    int x_phase_bits = pixman_fixed_to_int (params[2]);
+    int cwidth4 = (cwidth + 3) & ~3;
+    size_t n_weights = ((size_t)cheight * cwidth4) << x_phase_bits;
+    separable_info_t *info;
+    size_t size;
+    uint8_t *p;
+
+    size = sizeof (*info) + 16 + cheight * sizeof (uint32_t *) +
+	(cwidth4 + 4) * sizeof (uint32_t);
+
+    if (n_weights * sizeof (__m128i) > SEPARABLE_MAX_WEIGHT_BYTES)
+	n_weights = 0;
+
+    size += n_weights * (sizeof (__m128i) + sizeof (int32_t));
+
+    info = malloc (size);
+    if (!info)
+    {
+	_pixman_log_error (FUNC, "Allocation failure, skipping rendering\n");
+
+	iter->get_scanline = _pixman_iter_get_scanline_noop;
+	iter->fini = NULL;
+	return;
+    }
+
+    info->params = params;
+    info->cwidth = cwidth;
+    info->cheight = cheight;
+    info->cwidth4 = cwidth4;
+    info->x_phase_bits = x_phase_bits;
+    info->y_phase_bits = pixman_fixed_to_int (params[3]);
+    info->py = -1;
+    info->type = SEPARABLE_WEIGHTS_NONE;
+    info->alpha = PIXMAN_FORMAT_A (iter->image->bits.format)? 0 : 0xff000000;
+
+    p = (uint8_t *)(((uintptr_t)(info + 1) + 15) & ~(uintptr_t)15);
+    info->weights = n_weights? (__m128i *)p : NULL;
+    p += n_weights * sizeof (__m128i);
+    info->products = (int32_t *)p;
+    p += n_weights * sizeof (int32_t);
+    info->rows = (const uint32_t **)p;
+    p += cheight * sizeof (uint32_t *);
+    info->tmp = (uint32_t *)p;
+
+    memset (info->tmp, 0, cwidth4 * sizeof (uint32_t));
+
+    iter->get_scanline = sse2_fetch_separable_convolution;
+    iter->fini = sse2_separable_iter_fini;
+    iter->data = info;
+}
+
+#define SEPARABLE_IMAGE_FLAGS						\
+    (FAST_PATH_NO_ACCESSORS		|				\
+     FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_NARROW_FORMAT		|				\
+     FAST_PATH_SCALE_TRANSFORM		|				\
+     FAST_PATH_SEPARABLE_CONVOLUTION_FILTER)
+
 #define IMAGE_FLAGS							\
     (FAST_PATH_STANDARD_FLAGS | FAST_PATH_ID_TRANSFORM |		\
      FAST_PATH_BITS_IMAGE | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)
@@ -6463,6 +7330,12 @@ static const pixman_iter_info_t sse2_iters[] =
     { PIXMAN_a8, IMAGE_FLAGS, ITER_NARROW,
       _pixman_iter_init_bits_stride, sse2_fetch_a8, NULL
     },
+    { PIXMAN_a8r8g8b8, SEPARABLE_IMAGE_FLAGS, ITER_NARROW | ITER_SRC,
+      sse2_separable_iter_init, NULL, NULL
+    },
+    { PIXMAN_x8r8g8b8, SEPARABLE_IMAGE_FLAGS, ITER_NARROW | ITER_SRC,
+      sse2_separable_iter_init, NULL, NULL
+    },
     { PIXMAN_null },
 };
 
@@ -0,0 +1,336 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include "pixman-private.h"
+
+/* A minimal pool of worker threads used for banded compositing.
+ *
+ * The pool is created the first time it is needed. It has one thread
+ * per online CPU minus one, because the calling thread also works on
+ * the bands. The PIXMAN_NUM_THREADS environment variable overrides
+ * the total number of threads. It uses pthreads where available and
+ * the native primitives on Windows; elsewhere compositing stays on
+ * the calling thread.
+ *
+ * Only one batch of bands runs at a time. If another thread already
+ * uses the pool, _pixman_thread_pool_run() returns FALSE and the
+ * caller does the work itself. Bands are handed out in order but may
+ * complete in any order, so band functions must not depend on each
+ * other.
+ */
+
+#define MAX_THREADS	64
+
+#if defined(HAVE_PTHREADS)
+
+#include <pthread.h>
+#include <unistd.h>
+
+typedef pthread_mutex_t		pool_mutex_t;
+typedef pthread_cond_t		pool_cond_t;
+
+#define POOL_MUTEX_INIT		PTHREAD_MUTEX_INITIALIZER
+#define POOL_COND_INIT		PTHREAD_COND_INITIALIZER
+
+#define mutex_lock(m)		pthread_mutex_lock (m)
+#define mutex_trylock(m)	(pthread_mutex_trylock (m) == 0)
+#define mutex_unlock(m)		pthread_mutex_unlock (m)
+#define cond_wait(c, m)		pthread_cond_wait (c, m)
+#define cond_signal(c)		pthread_cond_signal (c)
+#define cond_broadcast(c)	pthread_cond_broadcast (c)
+
+#define HAVE_THREAD_POOL
+
+#elif defined(_WIN32)
+
+/* SRW locks and condition variables need Windows 7 for
+ * TryAcquireSRWLockExclusive()
+ */
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+typedef SRWLOCK			pool_mutex_t;
+typedef CONDITION_VARIABLE	pool_cond_t;
+
+#define POOL_MUTEX_INIT		SRWLOCK_INIT
+#define POOL_COND_INIT		CONDITION_VARIABLE_INIT
+
+#define mutex_lock(m)		AcquireSRWLockExclusive (m)
+#define mutex_trylock(m)	TryAcquireSRWLockExclusive (m)
+#define mutex_unlock(m)		ReleaseSRWLockExclusive (m)
+#define cond_wait(c, m)		SleepConditionVariableSRW (c, m, INFINITE, 0)
+#define cond_signal(c)		WakeConditionVariable (c)
+#define cond_broadcast(c)	WakeAllConditionVariable (c)
+
+#define HAVE_THREAD_POOL
+
+#endif
+
+#ifdef HAVE_THREAD_POOL
+
+typedef struct
+{
+    pool_mutex_t	busy;
+    pool_mutex_t	lock;
+    pool_cond_t		work_cond;
+    pool_cond_t		done_cond;
+
+    int			n_threads;
+    unsigned int	generation;
+
+    pixman_band_func_t	func;
+    void *		data;
+    int			n_bands;
+    int			next_band;
+    int			n_done;
+} thread_pool_t;
+
+static thread_pool_t pool =
+{
+    POOL_MUTEX_INIT,
+    POOL_MUTEX_INIT,
+    POOL_COND_INIT,
+    POOL_COND_INIT,
+};
+
+/* Called and returns with pool.lock held */
+static void
+run_bands (void)
+{
+    pixman_band_func_t func = pool.func;
+    void *data = pool.data;
+    int n_bands = pool.n_bands;
+
+    while (pool.next_band < n_bands)
+    {
+	int band = pool.next_band++;
+
+	mutex_unlock (&pool.lock);
+
+	func (data, band, n_bands);
+
+	mutex_lock (&pool.lock);
+
+	if (++pool.n_done == n_bands)
+	    cond_signal (&pool.done_cond);
+    }
+}
+
+static void
+worker_loop (void)
+{
+    unsigned int generation;
+
+    mutex_lock (&pool.lock);
+
+    generation = pool.generation;
+
+    for (;;)
+    {
+	while (pool.generation == generation)
+	    cond_wait (&pool.work_cond, &pool.lock);
+
+	generation = pool.generation;
+
+	run_bands ();
+    }
+}
+
+static int
+get_n_cpus (void)
+{
+#if defined(HAVE_PTHREADS) && defined(_SC_NPROCESSORS_ONLN)
+    return sysconf (_SC_NPROCESSORS_ONLN);
+#elif defined(HAVE_PTHREADS)
+    return 1;
+#else
+    SYSTEM_INFO info;
+
+    GetSystemInfo (&info);
+
+    return info.dwNumberOfProcessors;
+#endif
+}
+
+static int
+get_n_threads (void)
+{
+    const char *env = getenv ("PIXMAN_NUM_THREADS");
+    long n;
+
+    if (env)
+	n = strtol (env, NULL, 10);
+    else
+	n = get_n_cpus ();
+
+    if (n < 1)
+	n = 1;
+    if (n > MAX_THREADS)
+	n = MAX_THREADS;
+
+    return n;
+}
+
+#ifdef HAVE_PTHREADS
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static void *
+worker_main (void *arg)
+{
+    worker_loop ();
+
+    return NULL;
+}
+
+static void
+create_pool (void)
+{
+    pthread_attr_t attr;
+    int n_threads = get_n_threads ();
+
+    pool.n_threads = 1;
+
+    if (n_threads == 1 || pthread_attr_init (&attr) != 0)
+	return;
+
+    pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+
+    while (pool.n_threads < n_threads)
+    {
+	pthread_t thread;
+
+	if (pthread_create (&thread, &attr, worker_main, NULL) != 0)
+	    break;
+
+	pool.n_threads++;
+    }
+
+    pthread_attr_destroy (&attr);
+}
+
+int
+_pixman_thread_pool_get_n_threads (void)
+{
+    if (pthread_once (&pool_once, create_pool) != 0)
+	return 1;
+
+    return pool.n_threads;
+}
+
+#else
+
+static INIT_ONCE pool_once = INIT_ONCE_STATIC_INIT;
+
+static DWORD WINAPI
+worker_main (LPVOID arg)
+{
+    worker_loop ();
+
+    return 0;
+}
+
+static BOOL CALLBACK
+create_pool (PINIT_ONCE once, PVOID param, PVOID *context)
+{
+    int n_threads = get_n_threads ();
+
+    pool.n_threads = 1;
+
+    while (pool.n_threads < n_threads)
+    {
+	HANDLE thread = CreateThread (NULL, 0, worker_main, NULL, 0, NULL);
+
+	if (!thread)
+	    break;
+
+	CloseHandle (thread);
+
+	pool.n_threads++;
+    }
+
+    return TRUE;
+}
+
+int
+_pixman_thread_pool_get_n_threads (void)
+{
+    if (!InitOnceExecuteOnce (&pool_once, create_pool, NULL, NULL))
+	return 1;
+
+    return pool.n_threads;
+}
+
+#endif
+
+pixman_bool_t
+_pixman_thread_pool_run (pixman_band_func_t func, void *data, int n_bands)
+{
+    if (_pixman_thread_pool_get_n_threads () < 2 || n_bands < 2)
+	return FALSE;
+
+    if (!mutex_trylock (&pool.busy))
+	return FALSE;
+
+    mutex_lock (&pool.lock);
+
+    pool.func = func;
+    pool.data = data;
+    pool.n_bands = n_bands;
+    pool.next_band = 0;
+    pool.n_done = 0;
+    pool.generation++;
+
+    cond_broadcast (&pool.work_cond);
+
+    run_bands ();
+
+    while (pool.n_done < n_bands)
+	cond_wait (&pool.done_cond, &pool.lock);
+
+    mutex_unlock (&pool.lock);
+    mutex_unlock (&pool.busy);
+
+    return TRUE;
+}
+
+#else
+
+int
+_pixman_thread_pool_get_n_threads (void)
+{
+    return 1;
+}
+
+pixman_bool_t
+_pixman_thread_pool_run (pixman_band_func_t func, void *data, int n_bands)
+{
+    return FALSE;
+}
+
+#endif
@@ -0,0 +1,386 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pixman-private.h"
+#include "pixman-trace.h"
+
+/* Recording of composite, fill and blt calls, for replaying the
+ * workload of a real application with test/trace-replay.
+ *
+ * Setting PIXMAN_TRACE to a file name makes pixman write every call to
+ * that file, in the format described in pixman-trace.h. Only image
+ * metadata is recorded unless PIXMAN_TRACE_PIXELS is also set, in which
+ * case the pixels of source and mask images are included as well.
+ *
+ * Each record is assembled in memory and written with a single fwrite()
+ * so that records from different threads don't interleave.
+ */
+
+pixman_bool_t _pixman_trace_enabled;
+
+static FILE *trace_file;
+static pixman_bool_t trace_pixels;
+
+typedef struct
+{
+    uint8_t *	data;
+    size_t	len;
+    size_t	size;
+    pixman_bool_t failed;
+} trace_buffer_t;
+
+static void
+put (trace_buffer_t *buf, const void *data, size_t len)
+{
+    if (buf->failed)
+	return;
+
+    if (buf->len + len > buf->size)
+    {
+	size_t size = buf->size ? buf->size : 256;
+	uint8_t *new_data;
+
+	while (size < buf->len + len)
+	    size *= 2;
+
+	if (!(new_data = realloc (buf->data, size)))
+	{
+	    buf->failed = TRUE;
+	    return;
+	}
+
+	buf->data = new_data;
+	buf->size = size;
+    }
+
+    memcpy (buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+static void
+put_u8 (trace_buffer_t *buf, uint8_t v)
+{
+    put (buf, &v, sizeof (v));
+}
+
+static void
+put_u16 (trace_buffer_t *buf, uint16_t v)
+{
+    put (buf, &v, sizeof (v));
+}
+
+static void
+put_u32 (trace_buffer_t *buf, uint32_t v)
+{
+    put (buf, &v, sizeof (v));
+}
+
+static void
+put_s32 (trace_buffer_t *buf, int32_t v)
+{
+    put (buf, &v, sizeof (v));
+}
+
+static void
+put_color (trace_buffer_t *buf, const pixman_color_t *color)
+{
+    put_u16 (buf, color->red);
+    put_u16 (buf, color->green);
+    put_u16 (buf, color->blue);
+    put_u16 (buf, color->alpha);
+}
+
+static void
+put_stops (trace_buffer_t *buf, const gradient_t *gradient)
+{
+    int i;
+
+    put_u32 (buf, gradient->n_stops);
+
+    for (i = 0; i < gradient->n_stops; i++)
+    {
+	put_s32 (buf, gradient->stops[i].x);
+	put_color (buf, &gradient->stops[i].color);
+    }
+}
+
+static void
+put_image (trace_buffer_t *buf, pixman_image_t *image, pixman_bool_t pixels)
+{
+    image_common_t *common;
+    uint8_t flags = 0;
+    int i;
+
+    if (!image)
+    {
+	put_u8 (buf, PIXMAN_TRACE_IMAGE_NONE);
+	return;
+    }
+
+    common = &image->common;
+
+    switch (image->type)
+    {
+    case BITS:
+	put_u8 (buf, PIXMAN_TRACE_IMAGE_BITS);
+	break;
+    case SOLID:
+	put_u8 (buf, PIXMAN_TRACE_IMAGE_SOLID);
+	break;
+    case LINEAR:
+	put_u8 (buf, PIXMAN_TRACE_IMAGE_LINEAR);
+	break;
+    case RADIAL:
+	put_u8 (buf, PIXMAN_TRACE_IMAGE_RADIAL);
+	break;
+    case CONICAL:
+	put_u8 (buf, PIXMAN_TRACE_IMAGE_CONICAL);
+	break;
+    }
+
+    /* Pixels behind accessors may not be directly readable */
+    if (pixels && image->type == BITS && image->bits.rowstride > 0 &&
+	!image->bits.read_func)
+    {
+	flags |= PIXMAN_TRACE_PIXELS;
+    }
+
+    if (common->transform)
+	flags |= PIXMAN_TRACE_TRANSFORM;
+    if (common->have_clip_region)
+	flags |= PIXMAN_TRACE_CLIP;
+    if (common->clip_sources)
+	flags |= PIXMAN_TRACE_CLIP_SOURCES;
+    if (common->alpha_map)
+	flags |= PIXMAN_TRACE_ALPHA_MAP;
+
+    put_u8 (buf, common->repeat);
+    put_u8 (buf, common->filter);
+    put_u8 (buf, common->component_alpha);
+    put_u8 (buf, flags);
+
+    if (flags & PIXMAN_TRACE_TRANSFORM)
+    {
+	for (i = 0; i < 9; i++)
+	    put_s32 (buf, common->transform->matrix[i / 3][i % 3]);
+    }
+
+    if (flags & PIXMAN_TRACE_CLIP)
+    {
+	const pixman_box32_t *boxes;
+	int n_boxes;
+
+	boxes = pixman_region32_rectangles (&common->clip_region, &n_boxes);
+
+	put_u32 (buf, n_boxes);
+	put (buf, boxes, n_boxes * sizeof (pixman_box32_t));
+    }
+
+    if (flags & PIXMAN_TRACE_ALPHA_MAP)
+    {
+	put_u32 (buf, common->alpha_map->format);
+	put_s32 (buf, common->alpha_map->width);
+	put_s32 (buf, common->alpha_map->height);
+	put_s32 (buf, common->alpha_origin_x);
+	put_s32 (buf, common->alpha_origin_y);
+    }
+
+    put_u32 (buf, common->n_filter_params);
+    put (buf, common->filter_params,
+	 common->n_filter_params * sizeof (pixman_fixed_t));
+
+    switch (image->type)
+    {
+    case BITS:
+	put_u32 (buf, image->bits.format);
+	put_s32 (buf, image->bits.width);
+	put_s32 (buf, image->bits.height);
+	put_s32 (buf, image->bits.rowstride);
+
+	if (flags & PIXMAN_TRACE_PIXELS)
+	{
+	    put (buf, image->bits.bits,
+		 (size_t)image->bits.rowstride * 4 * image->bits.height);
+	}
+	break;
+
+    case SOLID:
+	put_color (buf, &image->solid.color);
+	break;
+
+    case LINEAR:
+	put_s32 (buf, image->linear.p1.x);
+	put_s32 (buf, image->linear.p1.y);
+	put_s32 (buf, image->linear.p2.x);
+	put_s32 (buf, image->linear.p2.y);
+	put_stops (buf, &image->gradient);
+	break;
+
+    case RADIAL:
+	put_s32 (buf, image->radial.c1.x);
+	put_s32 (buf, image->radial.c1.y);
+	put_s32 (buf, image->radial.c1.radius);
+	put_s32 (buf, image->radial.c2.x);
+	put_s32 (buf, image->radial.c2.y);
+	put_s32 (buf, image->radial.c2.radius);
+	put_stops (buf, &image->gradient);
+	break;
+
+    case CONICAL:
+	put_s32 (buf, image->conical.center.x);
+	put_s32 (buf, image->conical.center.y);
+	put_s32 (buf, pixman_double_to_fixed (
+		     image->conical.angle * 180.0 / M_PI));
+	put_stops (buf, &image->gradient);
+	break;
+    }
+}
+
+static void
+write_record (trace_buffer_t *buf)
+{
+    if (!buf->failed)
+	fwrite (buf->data, 1, buf->len, trace_file);
+
+    free (buf->data);
+}
+
+void
+_pixman_trace_init (void)
+{
+    const char *env = getenv ("PIXMAN_TRACE");
+    uint32_t header[2] = { PIXMAN_TRACE_MAGIC, PIXMAN_TRACE_VERSION };
+
+    if (!env || !*env)
+	return;
+
+    if (!(trace_file = fopen (env, "wb")))
+    {
+	fprintf (stderr, "pixman: Could not open trace file %s\n", env);
+	return;
+    }
+
+    if (fwrite (header, sizeof (header), 1, trace_file) != 1)
+    {
+	fclose (trace_file);
+	trace_file = NULL;
+	return;
+    }
+
+    trace_pixels = getenv ("PIXMAN_TRACE_PIXELS") != NULL;
+    _pixman_trace_enabled = TRUE;
+}
+
+void
+_pixman_trace_composite (pixman_op_t      op,
+			 pixman_image_t * src,
+			 pixman_image_t * mask,
+			 pixman_image_t * dest,
+			 int32_t          src_x,
+			 int32_t          src_y,
+			 int32_t          mask_x,
+			 int32_t          mask_y,
+			 int32_t          dest_x,
+			 int32_t          dest_y,
+			 int32_t          width,
+			 int32_t          height,
+			 pixman_bool_t    threaded)
+{
+    trace_buffer_t buf = { NULL, 0, 0, FALSE };
+
+    put_u8 (&buf, PIXMAN_TRACE_COMPOSITE);
+    put_u8 (&buf, op);
+    put_u8 (&buf, threaded != FALSE);
+    put_s32 (&buf, src_x);
+    put_s32 (&buf, src_y);
+    put_s32 (&buf, mask_x);
+    put_s32 (&buf, mask_y);
+    put_s32 (&buf, dest_x);
+    put_s32 (&buf, dest_y);
+    put_s32 (&buf, width);
+    put_s32 (&buf, height);
+
+    put_image (&buf, src, trace_pixels);
+    put_image (&buf, mask, trace_pixels);
+    put_image (&buf, dest, FALSE);
+
+    write_record (&buf);
+}
+
+void
+_pixman_trace_fill (int      stride,
+		    int      bpp,
+		    int      x,
+		    int      y,
+		    int      width,
+		    int      height,
+		    uint32_t filler)
+{
+    trace_buffer_t buf = { NULL, 0, 0, FALSE };
+
+    put_u8 (&buf, PIXMAN_TRACE_FILL);
+    put_u32 (&buf, bpp);
+    put_s32 (&buf, stride);
+    put_s32 (&buf, x);
+    put_s32 (&buf, y);
+    put_s32 (&buf, width);
+    put_s32 (&buf, height);
+    put_u32 (&buf, filler);
+
+    write_record (&buf);
+}
+
+void
+_pixman_trace_blt (int src_stride,
+		   int dst_stride,
+		   int src_bpp,
+		   int dst_bpp,
+		   int src_x,
+		   int src_y,
+		   int dest_x,
+		   int dest_y,
+		   int width,
+		   int height)
+{
+    trace_buffer_t buf = { NULL, 0, 0, FALSE };
+
+    put_u8 (&buf, PIXMAN_TRACE_BLT);
+    put_u32 (&buf, src_bpp);
+    put_u32 (&buf, dst_bpp);
+    put_s32 (&buf, src_stride);
+    put_s32 (&buf, dst_stride);
+    put_s32 (&buf, src_x);
+    put_s32 (&buf, src_y);
+    put_s32 (&buf, dest_x);
+    put_s32 (&buf, dest_y);
+    put_s32 (&buf, width);
+    put_s32 (&buf, height);
+
+    write_record (&buf);
+}
@@ -0,0 +1,91 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PIXMAN_TRACE_H
+#define PIXMAN_TRACE_H
+
+/* Format of the traces written by pixman-trace.c and read by
+ * test/trace-replay.c.
+ *
+ * A trace is the 32 bit magic and version followed by records. All
+ * fields are in host byte order, which the magic identifies, and are
+ * packed without padding. Records start with a one byte type:
+ *
+ *   COMPOSITE  u8 op, u8 threaded,
+ *              s32 src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+ *              s32 width, height,
+ *              image src, image mask, image dest
+ *
+ *   FILL       u32 bpp, s32 stride, x, y, width, height, u32 filler
+ *
+ *   BLT        u32 src_bpp, dst_bpp, s32 src_stride, dst_stride,
+ *              s32 src_x, src_y, dest_x, dest_y, width, height
+ *
+ * Strides are in uint32_t units as in the API. An image is a u8 kind;
+ * anything but NONE continues with
+ *
+ *   u8 repeat, u8 filter, u8 component_alpha, u8 flags,
+ *   s32 transform[3][3]              if flags & TRANSFORM
+ *   u32 n_boxes, s32 boxes[n][4]     if flags & CLIP
+ *   u32 format, s32 width, height,
+ *   s32 origin_x, origin_y           if flags & ALPHA_MAP
+ *   u32 n_params, s32 params[n]
+ *
+ * and then, by kind,
+ *
+ *   BITS       u32 format, s32 width, height, rowstride,
+ *              u8 pixels[rowstride * 4 * height] if flags & PIXELS
+ *   SOLID      u16 red, green, blue, alpha
+ *   LINEAR     s32 p1.x, p1.y, p2.x, p2.y, stops
+ *   RADIAL     s32 c1.x, c1.y, c1.radius, c2.x, c2.y, c2.radius, stops
+ *   CONICAL    s32 center.x, center.y, angle, stops
+ *
+ * where the conical angle is in 16.16 degrees and stops are a u32 count
+ * followed by s32 x and u16 red, green, blue, alpha for each stop.
+ */
+
+#define PIXMAN_TRACE_MAGIC		0x52545850	/* "PXTR" */
+#define PIXMAN_TRACE_VERSION		1
+
+typedef enum
+{
+    PIXMAN_TRACE_COMPOSITE = 1,
+    PIXMAN_TRACE_FILL,
+    PIXMAN_TRACE_BLT
+} pixman_trace_record_t;
+
+typedef enum
+{
+    PIXMAN_TRACE_IMAGE_NONE,
+    PIXMAN_TRACE_IMAGE_BITS,
+    PIXMAN_TRACE_IMAGE_SOLID,
+    PIXMAN_TRACE_IMAGE_LINEAR,
+    PIXMAN_TRACE_IMAGE_RADIAL,
+    PIXMAN_TRACE_IMAGE_CONICAL
+} pixman_trace_image_t;
+
+#define PIXMAN_TRACE_TRANSFORM		(1 << 0)
+#define PIXMAN_TRACE_CLIP		(1 << 1)
+#define PIXMAN_TRACE_ALPHA_MAP		(1 << 2)
+#define PIXMAN_TRACE_PIXELS		(1 << 3)
+#define PIXMAN_TRACE_CLIP_SOURCES	(1 << 4)
+
+#endif
@@ -27,6 +27,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include "pixman-private.h"
 
 /*
@@ -468,6 +470,237 @@ get_trap_extents (pixman_op_t op, pixman_image_t *dest,
     return TRUE;
 }
 
+/* Trapezoids from tessellated strokes are often thin and spread across
+ * a large area, so instead of rasterizing into a mask covering the
+ * bounding box of all of them, they are rasterized a band of rows at a
+ * time into a reusable mask. The band is divided into tiles, and for
+ * each tile we keep track of the rows that the trapezoids may have
+ * touched; only those are composited and cleared again. Rasterization
+ * is the same as for the full mask, so the results are identical.
+ */
+#define TRAP_BAND_HEIGHT	16
+#define TRAP_TILE_SHIFT		6
+#define TRAP_TILE_WIDTH		(1 << TRAP_TILE_SHIFT)
+
+typedef struct
+{
+    int		y1, y2;
+} trap_tile_t;
+
+static int
+compare_trap_tops (const void *a, const void *b)
+{
+    const pixman_trapezoid_t *ta = *(const pixman_trapezoid_t **)a;
+    const pixman_trapezoid_t *tb = *(const pixman_trapezoid_t **)b;
+
+    return (ta->top > tb->top) - (ta->top < tb->top);
+}
+
+/* Mark the tiles of the band starting at @band_y that rasterizing
+ * @trap can touch. This is conservative: the extents of each row are
+ * computed from the edge lines rather than the sample positions, and
+ * padded by a pixel on either side.
+ */
+static void
+add_trap_tiles (trap_tile_t *tiles, int band_y, int band_height,
+		int x_off, int width, const pixman_trapezoid_t *trap)
+{
+    const pixman_line_fixed_t *left = &trap->left;
+    const pixman_line_fixed_t *right = &trap->right;
+    double dl = (double)(left->p2.x - left->p1.x) / (left->p2.y - left->p1.y);
+    double dr = (double)(right->p2.x - right->p1.x) / (right->p2.y - right->p1.y);
+    int y1 = MAX (pixman_fixed_to_int (trap->top), band_y);
+    int y2 = MIN (pixman_fixed_to_int (pixman_fixed_ceil (trap->bottom)),
+		  band_y + band_height);
+    int y;
+
+    for (y = y1; y < y2; ++y)
+    {
+	pixman_fixed_t ya = MAX (trap->top, pixman_int_to_fixed (y));
+	pixman_fixed_t yb = MIN (trap->bottom, pixman_int_to_fixed (y + 1));
+	double l1 = left->p1.x + ((double)ya - left->p1.y) * dl;
+	double l2 = left->p1.x + ((double)yb - left->p1.y) * dl;
+	double r1 = right->p1.x + ((double)ya - right->p1.y) * dr;
+	double r2 = right->p1.x + ((double)yb - right->p1.y) * dr;
+	double lo = MIN (MIN (l1, l2), MIN (r1, r2)) / pixman_fixed_1;
+	double hi = MAX (MAX (l1, l2), MAX (r1, r2)) / pixman_fixed_1;
+	int x1, x2, c;
+
+	/* Nearly horizontal edges can put these far outside the band, and
+	 * out of the range of int, so clamp them before converting.
+	 */
+	lo = CLIP (lo, -x_off - 1, width - x_off + 1);
+	hi = CLIP (hi, -x_off - 1, width - x_off + 1);
+
+	x1 = (int)floor (lo) + x_off - 1;
+	x2 = (int)floor (hi) + x_off + 2;
+
+	if (x1 < 0)
+	    x1 = 0;
+	if (x2 > width)
+	    x2 = width;
+	if (x1 >= x2)
+	    continue;
+
+	for (c = x1 >> TRAP_TILE_SHIFT; c <= (x2 - 1) >> TRAP_TILE_SHIFT; ++c)
+	{
+	    trap_tile_t *tile = &tiles[c];
+
+	    if (y - band_y < tile->y1)
+		tile->y1 = y - band_y;
+	    if (y - band_y + 1 > tile->y2)
+		tile->y2 = y - band_y + 1;
+	}
+    }
+}
+
+static void
+composite_band (pixman_op_t op, pixman_image_t *src, pixman_image_t *band,
+		pixman_image_t *dst, trap_tile_t *tiles, int n_tiles,
+		int x_src, int y_src, int x_dst, int y_dst)
+{
+    int bpp = PIXMAN_FORMAT_BPP (band->bits.format);
+    uint8_t *bits = (uint8_t *)band->bits.bits;
+    int stride = band->bits.rowstride * sizeof (uint32_t);
+    int width = band->bits.width;
+    int c, y;
+
+    for (c = 0; c < n_tiles; ++c)
+    {
+	int c1, x1, x2, y1, y2;
+
+	if (tiles[c].y1 >= tiles[c].y2)
+	    continue;
+
+	/* Composite runs of touched tiles in one go */
+	y1 = tiles[c].y1;
+	y2 = tiles[c].y2;
+	for (c1 = c + 1; c1 < n_tiles && tiles[c1].y1 < tiles[c1].y2; ++c1)
+	{
+	    y1 = MIN (y1, tiles[c1].y1);
+	    y2 = MAX (y2, tiles[c1].y2);
+	}
+
+	x1 = c << TRAP_TILE_SHIFT;
+	x2 = MIN (c1 << TRAP_TILE_SHIFT, width);
+
+	pixman_image_composite32 (op, src, band, dst,
+				  x_src + x1, y_src + y1,
+				  x1, y1,
+				  x_dst + x1, y_dst + y1,
+				  x2 - x1, y2 - y1);
+
+	/* Clear the band for the next round */
+	for (; c < c1; ++c)
+	{
+	    trap_tile_t *tile = &tiles[c];
+	    int tx1 = c << TRAP_TILE_SHIFT;
+	    int tx2 = MIN (tx1 + TRAP_TILE_WIDTH, width);
+
+	    for (y = tile->y1; y < tile->y2; ++y)
+	    {
+		memset (bits + y * stride + tx1 * bpp / 8, 0,
+			(tx2 * bpp + 7) / 8 - tx1 * bpp / 8);
+	    }
+
+	    tile->y1 = TRAP_BAND_HEIGHT;
+	    tile->y2 = 0;
+	}
+    }
+}
+
+static void
+composite_trapezoids_sparse (pixman_op_t		op,
+			     pixman_image_t *		src,
+			     pixman_image_t *		dst,
+			     pixman_format_code_t	mask_format,
+			     int			x_src,
+			     int			y_src,
+			     int			x_dst,
+			     int			y_dst,
+			     int			n_traps,
+			     const pixman_trapezoid_t *	traps,
+			     const pixman_box32_t *	box)
+{
+    const pixman_trapezoid_t **sorted, **active;
+    int width = box->x2 - box->x1;
+    int n_tiles = (width + TRAP_TILE_WIDTH - 1) >> TRAP_TILE_SHIFT;
+    int n_sorted, n_active, next;
+    trap_tile_t *tiles;
+    pixman_image_t *band;
+    int band_y, i;
+
+    if (!(sorted = pixman_malloc_ab (n_traps, 2 * sizeof (*sorted))))
+	return;
+    active = sorted + n_traps;
+
+    if (!(tiles = pixman_malloc_ab (n_tiles, sizeof (trap_tile_t))))
+    {
+	free (sorted);
+	return;
+    }
+
+    if (!(band = pixman_image_create_bits (
+	      mask_format, width, TRAP_BAND_HEIGHT, NULL, -1)))
+    {
+	free (tiles);
+	free (sorted);
+	return;
+    }
+
+    for (i = 0; i < n_tiles; ++i)
+    {
+	tiles[i].y1 = TRAP_BAND_HEIGHT;
+	tiles[i].y2 = 0;
+    }
+
+    n_sorted = 0;
+    for (i = 0; i < n_traps; ++i)
+    {
+	if (pixman_trapezoid_valid (&traps[i]))
+	    sorted[n_sorted++] = &traps[i];
+    }
+
+    qsort (sorted, n_sorted, sizeof (*sorted), compare_trap_tops);
+
+    n_active = 0;
+    next = 0;
+
+    for (band_y = box->y1; band_y < box->y2; band_y += TRAP_BAND_HEIGHT)
+    {
+	int band_height = MIN (TRAP_BAND_HEIGHT, box->y2 - band_y);
+	pixman_fixed_t band_bottom = pixman_int_to_fixed (band_y + band_height);
+	int n;
+
+	while (next < n_sorted && sorted[next]->top < band_bottom)
+	    active[n_active++] = sorted[next++];
+
+	if (!n_active)
+	    continue;
+
+	for (i = 0, n = 0; i < n_active; ++i)
+	{
+	    const pixman_trapezoid_t *trap = active[i];
+
+	    pixman_rasterize_trapezoid (band, trap, - box->x1, - band_y);
+	    add_trap_tiles (tiles, band_y, band_height, - box->x1, width, trap);
+
+	    /* Keep the trapezoids that reach into the next band */
+	    if (trap->bottom > band_bottom)
+		active[n++] = trap;
+	}
+	n_active = n;
+
+	composite_band (op, src, band, dst, tiles, n_tiles,
+			x_src + box->x1, y_src + band_y,
+			x_dst + box->x1, y_dst + band_y);
+    }
+
+    pixman_image_unref (band);
+    free (tiles);
+    free (sorted);
+}
+
 /*
  * pixman_composite_trapezoids()
  *
@@ -522,6 +755,14 @@ pixman_composite_trapezoids (pixman_op_t		op,
 
 	if (!get_trap_extents (op, dst, traps, n_traps, &box))
 	    return;
+
+	if (zero_src_has_no_effect[op])
+	{
+	    composite_trapezoids_sparse (op, src, dst, mask_format,
+					 x_src, y_src, x_dst, y_dst,
+					 n_traps, traps, &box);
+	    return;
+	}
 	
 	if (!(tmp = pixman_image_create_bits (
 		  mask_format, box.x2 - box.x1, box.y2 - box.y1, NULL, -1)))
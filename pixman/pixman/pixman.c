@@ -556,22 +556,194 @@ analyze_extent (pixman_image_t       *image,
  *
  * See https://bugs.freedesktop.org/show_bug.cgi?id=15693
  */
-#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
-__attribute__((__force_align_arg_pointer__))
-#endif
-PIXMAN_EXPORT void
-pixman_image_composite32 (pixman_op_t      op,
-                          pixman_image_t * src,
-                          pixman_image_t * mask,
-                          pixman_image_t * dest,
-                          int32_t          src_x,
-                          int32_t          src_y,
-                          int32_t          mask_x,
-                          int32_t          mask_y,
-                          int32_t          dest_x,
-                          int32_t          dest_y,
-                          int32_t          width,
-                          int32_t          height)
+/* Composites smaller than this are not worth waking up other threads
+ * for, and bands are never made shorter than THREADED_MIN_BAND_HEIGHT.
+ */
+#define THREADED_MIN_PIXELS		(256 * 256)
+#define THREADED_MIN_BAND_HEIGHT	16
+
+typedef struct
+{
+    pixman_implementation_t *	imp;
+    pixman_composite_func_t	func;
+    pixman_composite_info_t	info;
+    const pixman_box32_t *	boxes;
+    int				n_boxes;
+    int32_t			src_dx, src_dy;
+    int32_t			mask_dx, mask_dy;
+    int32_t			y, height;
+} composite_bands_t;
+
+/* Bands are horizontal and the composite functions compute every
+ * scanline from its absolute coordinates, so splitting a box at a
+ * band boundary doesn't change any pixel.
+ */
+static void
+composite_band (void *data, int band, int n_bands)
+{
+    composite_bands_t *bands = data;
+    pixman_composite_info_t info = bands->info;
+    const pixman_box32_t *pbox = bands->boxes;
+    int32_t y1, y2;
+    int n;
+
+    y1 = bands->y + (int32_t)((int64_t)bands->height * band / n_bands);
+    y2 = bands->y + (int32_t)((int64_t)bands->height * (band + 1) / n_bands);
+
+    for (n = bands->n_boxes; n > 0 && pbox->y1 < y2; n--, pbox++)
+    {
+	int32_t by1 = MAX (pbox->y1, y1);
+	int32_t by2 = MIN (pbox->y2, y2);
+
+	if (by1 >= by2)
+	    continue;
+
+	info.src_x = pbox->x1 + bands->src_dx;
+	info.src_y = by1 + bands->src_dy;
+	info.mask_x = pbox->x1 + bands->mask_dx;
+	info.mask_y = by1 + bands->mask_dy;
+	info.dest_x = pbox->x1;
+	info.dest_y = by1;
+	info.width = pbox->x2 - pbox->x1;
+	info.height = by2 - by1;
+
+	bands->func (bands->imp, &info);
+    }
+}
+
+static pixman_bool_t
+image_has_accessors (pixman_image_t *image)
+{
+    bits_image_t *alpha_map = image->common.alpha_map;
+
+    if (alpha_map && (alpha_map->read_func || alpha_map->write_func))
+	return TRUE;
+
+    return image->type == BITS &&
+	(image->bits.read_func || image->bits.write_func);
+}
+
+static void
+bits_extent (bits_image_t *bits, uintptr_t *start, uintptr_t *end)
+{
+    intptr_t stride = bits->rowstride * (intptr_t)sizeof (uint32_t);
+    uintptr_t first = (uintptr_t)bits->bits;
+
+    if (stride >= 0)
+    {
+	*start = first;
+	*end = first + stride * bits->height;
+    }
+    else
+    {
+	*start = first + stride * (bits->height - 1);
+	*end = first - stride;
+    }
+}
+
+static pixman_bool_t
+bits_overlap (bits_image_t *a, bits_image_t *b)
+{
+    uintptr_t a_start, a_end, b_start, b_end;
+
+    bits_extent (a, &a_start, &a_end);
+    bits_extent (b, &b_start, &b_end);
+
+    return a_start < b_end && b_start < a_end;
+}
+
+/* Whether compositing from image may read memory that compositing to
+ * dest writes. Sub-images and alpha maps can share a buffer at
+ * different start addresses, so compare the byte ranges.
+ */
+static pixman_bool_t
+image_reads_dest (pixman_image_t *image, pixman_image_t *dest)
+{
+    bits_image_t *reads[2] = { NULL, image->common.alpha_map };
+    bits_image_t *writes[2] = { &dest->bits, dest->common.alpha_map };
+    int i, j;
+
+    if (image->type == BITS)
+	reads[0] = &image->bits;
+
+    for (i = 0; i < 2; ++i)
+    {
+	for (j = 0; j < 2; ++j)
+	{
+	    if (reads[i] && writes[j] && bits_overlap (reads[i], writes[j]))
+		return TRUE;
+	}
+    }
+
+    return FALSE;
+}
+
+static pixman_bool_t
+composite_threaded (pixman_implementation_t *imp,
+		    pixman_composite_func_t  func,
+		    pixman_composite_info_t *info,
+		    pixman_region32_t       *region,
+		    int32_t                  src_x,
+		    int32_t                  src_y,
+		    int32_t                  mask_x,
+		    int32_t                  mask_y,
+		    int32_t                  dest_x,
+		    int32_t                  dest_y)
+{
+    const pixman_box32_t *extents = pixman_region32_extents (region);
+    composite_bands_t bands;
+    int n_bands;
+
+    if ((int64_t)(extents->x2 - extents->x1) *
+	(extents->y2 - extents->y1) < THREADED_MIN_PIXELS)
+    {
+	return FALSE;
+    }
+
+    if (image_has_accessors (info->src_image)				||
+	image_has_accessors (info->dest_image)				||
+	image_reads_dest (info->src_image, info->dest_image)		||
+	(info->mask_image &&
+	 (image_has_accessors (info->mask_image)			||
+	  image_reads_dest (info->mask_image, info->dest_image))))
+    {
+	return FALSE;
+    }
+
+    n_bands = MIN (_pixman_thread_pool_get_n_threads (),
+		   (extents->y2 - extents->y1) / THREADED_MIN_BAND_HEIGHT);
+
+    if (n_bands < 2)
+	return FALSE;
+
+    bands.imp = imp;
+    bands.func = func;
+    bands.info = *info;
+    bands.boxes = pixman_region32_rectangles (region, &bands.n_boxes);
+    bands.src_dx = src_x - dest_x;
+    bands.src_dy = src_y - dest_y;
+    bands.mask_dx = mask_x - dest_x;
+    bands.mask_dy = mask_y - dest_y;
+    bands.y = extents->y1;
+    bands.height = extents->y2 - extents->y1;
+
+    return _pixman_thread_pool_run (composite_band, &bands, n_bands);
+}
+
+static void
+composite32 (pixman_op_t      op,
+	     pixman_image_t * src,
+	     pixman_image_t * mask,
+	     pixman_image_t * dest,
+	     int32_t          src_x,
+	     int32_t          src_y,
+	     int32_t          mask_x,
+	     int32_t          mask_y,
+	     int32_t          dest_x,
+	     int32_t          dest_y,
+	     int32_t          width,
+	     int32_t          height,
+	     pixman_bool_t    threaded)
 {
     pixman_format_code_t src_format, mask_format, dest_format;
     pixman_region32_t region;
@@ -582,6 +754,13 @@ pixman_image_composite32 (pixman_op_t      op,
     const pixman_box32_t *pbox;
     int n;
 
+    if (_pixman_trace_enabled)
+    {
+	_pixman_trace_composite (op, src, mask, dest,
+				 src_x, src_y, mask_x, mask_y,
+				 dest_x, dest_y, width, height, threaded);
+    }
+
     _pixman_image_validate (src);
     if (mask)
 	_pixman_image_validate (mask);
@@ -684,6 +863,13 @@ pixman_image_composite32 (pixman_op_t      op,
     info.mask_image = mask;
     info.dest_image = dest;
 
+    if (threaded && composite_threaded (imp, func, &info, &region,
+					src_x, src_y, mask_x, mask_y,
+					dest_x, dest_y))
+    {
+	goto out;
+    }
+
     pbox = pixman_region32_rectangles (&region, &n);
 
     while (n--)
@@ -706,6 +892,50 @@ out:
     pixman_region32_fini (&region);
 }
 
+#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+PIXMAN_EXPORT void
+pixman_image_composite32 (pixman_op_t      op,
+                          pixman_image_t * src,
+                          pixman_image_t * mask,
+                          pixman_image_t * dest,
+                          int32_t          src_x,
+                          int32_t          src_y,
+                          int32_t          mask_x,
+                          int32_t          mask_y,
+                          int32_t          dest_x,
+                          int32_t          dest_y,
+                          int32_t          width,
+                          int32_t          height)
+{
+    composite32 (op, src, mask, dest,
+		 src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+		 width, height, FALSE);
+}
+
+#if defined (USE_SSE2) && defined(__GNUC__) && !defined(__x86_64__) && !defined(__amd64__)
+__attribute__((__force_align_arg_pointer__))
+#endif
+PIXMAN_EXPORT void
+pixman_image_composite32_threaded (pixman_op_t      op,
+				   pixman_image_t * src,
+				   pixman_image_t * mask,
+				   pixman_image_t * dest,
+				   int32_t          src_x,
+				   int32_t          src_y,
+				   int32_t          mask_x,
+				   int32_t          mask_y,
+				   int32_t          dest_x,
+				   int32_t          dest_y,
+				   int32_t          width,
+				   int32_t          height)
+{
+    composite32 (op, src, mask, dest,
+		 src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+		 width, height, TRUE);
+}
+
 PIXMAN_EXPORT void
 pixman_image_composite (pixman_op_t      op,
                         pixman_image_t * src,
@@ -738,6 +968,12 @@ pixman_blt (uint32_t *src_bits,
             int       width,
             int       height)
 {
+    if (_pixman_trace_enabled)
+    {
+	_pixman_trace_blt (src_stride, dst_stride, src_bpp, dst_bpp,
+			   src_x, src_y, dest_x, dest_y, width, height);
+    }
+
     return _pixman_implementation_blt (get_implementation(),
 				       src_bits, dst_bits, src_stride, dst_stride,
                                        src_bpp, dst_bpp,
@@ -756,6 +992,9 @@ pixman_fill (uint32_t *bits,
              int       height,
              uint32_t  filler)
 {
+    if (_pixman_trace_enabled)
+	_pixman_trace_fill (stride, bpp, x, y, width, height, filler);
+
     return _pixman_implementation_fill (
 	get_implementation(), bits, stride, bpp, x, y, width, height, filler);
 }
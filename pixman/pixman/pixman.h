@@ -553,6 +553,12 @@ pixman_bool_t           pixman_region_union_rect         (pixman_region16_t
 							  unsigned int            width,
 							  unsigned int            height);
 
+PIXMAN_API
+pixman_bool_t           pixman_region_union_boxes        (pixman_region16_t       *dest,
+							  const pixman_region16_t *source,
+							  const pixman_box16_t    *boxes,
+							  int                      count);
+
 PIXMAN_API
 pixman_bool_t		pixman_region_intersect_rect     (pixman_region16_t       *dest,
 							  const pixman_region16_t *source,
@@ -702,6 +708,12 @@ pixman_bool_t           pixman_region32_union_rect         (pixman_region32_t
 							    unsigned int             width,
 							    unsigned int             height);
 
+PIXMAN_API
+pixman_bool_t           pixman_region32_union_boxes        (pixman_region32_t       *dest,
+							    const pixman_region32_t *source,
+							    const pixman_box32_t    *boxes,
+							    int                      count);
+
 PIXMAN_API
 pixman_bool_t           pixman_region32_subtract           (pixman_region32_t       *reg_d,
 							    const pixman_region32_t *reg_m,
@@ -1170,6 +1182,28 @@ void          pixman_image_composite32        (pixman_op_t        op,
 					       int32_t            width,
 					       int32_t            height);
 
+/* Same as pixman_image_composite32(), but large composites are split
+ * into horizontal bands that are run on an internal thread pool. The
+ * result is identical to the serial one. The pool has one thread per
+ * CPU unless the PIXMAN_NUM_THREADS environment variable says
+ * otherwise. Small composites, images with accessors and composites
+ * that read from the destination's own pixels run on the calling
+ * thread.
+ */
+PIXMAN_API
+void          pixman_image_composite32_threaded (pixman_op_t        op,
+						 pixman_image_t    *src,
+						 pixman_image_t    *mask,
+						 pixman_image_t    *dest,
+						 int32_t            src_x,
+						 int32_t            src_y,
+						 int32_t            mask_x,
+						 int32_t            mask_y,
+						 int32_t            dest_x,
+						 int32_t            dest_y,
+						 int32_t            width,
+						 int32_t            height);
+
 /* Executive Summary: This function is a no-op that only exists
  * for historical reasons.
  *
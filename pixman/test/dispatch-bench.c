@@ -0,0 +1,254 @@
+/*
+ * Replays a synthetic trace of small composite operations that mixes
+ * glyph masks, solid fills, gradients and scaled images, the way a
+ * text-heavy desktop workload does. With glyph-sized rectangles the
+ * fast path lookup is a large share of the cost, so this is mostly a
+ * benchmark for the composite dispatch cache. The cache statistics of
+ * the replay are printed afterwards.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+
+#define WIDTH		64
+#define HEIGHT		64
+#define TRACE_LENGTH	4096
+#define N_REPLAYS	200
+
+typedef struct
+{
+    pixman_op_t		op;
+    int			src;
+    int			mask;
+    int			dest;
+    int			width;
+    int			height;
+} trace_op_t;
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_SRC,
+    PIXMAN_OP_OVER,
+    PIXMAN_OP_ADD,
+    PIXMAN_OP_IN,
+    PIXMAN_OP_OVER_REVERSE,
+};
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+    PIXMAN_r5g6b5,
+    PIXMAN_a8,
+};
+
+#define N_SOURCES	16
+#define N_MASKS		8
+#define N_DESTS		ARRAY_LENGTH (formats)
+
+static pixman_image_t *sources[N_SOURCES];
+static pixman_image_t *masks[N_MASKS];
+static pixman_image_t *dests[N_DESTS];
+
+static pixman_image_t *
+create_bits (pixman_format_code_t format)
+{
+    pixman_image_t *image;
+
+    image = pixman_image_create_bits (format, WIDTH, HEIGHT, NULL, 0);
+    prng_randmemset (pixman_image_get_data (image),
+		     pixman_image_get_stride (image) * HEIGHT, 0);
+
+    return image;
+}
+
+static pixman_image_t *
+create_gradient (int radial)
+{
+    static const pixman_gradient_stop_t stops[] =
+    {
+	{ pixman_int_to_fixed (0), { 0xffff, 0x0000, 0x0000, 0xffff } },
+	{ pixman_int_to_fixed (1), { 0x0000, 0x0000, 0xffff, 0x8000 } },
+    };
+    pixman_point_fixed_t p1 = { 0, 0 };
+    pixman_point_fixed_t p2 = { pixman_int_to_fixed (WIDTH),
+				pixman_int_to_fixed (HEIGHT) };
+
+    if (radial)
+    {
+	return pixman_image_create_radial_gradient (
+	    &p1, &p1, 0, pixman_int_to_fixed (WIDTH),
+	    stops, ARRAY_LENGTH (stops));
+    }
+
+    return pixman_image_create_linear_gradient (
+	&p1, &p2, stops, ARRAY_LENGTH (stops));
+}
+
+static pixman_image_t *
+create_source (int i)
+{
+    pixman_image_t *image;
+    pixman_color_t color;
+    pixman_transform_t transform;
+
+    switch (i % 8)
+    {
+    case 0:
+	color.red = prng_rand () & 0xffff;
+	color.green = prng_rand () & 0xffff;
+	color.blue = prng_rand () & 0xffff;
+	color.alpha = (i & 8) ? 0xffff : prng_rand () & 0xffff;
+	return pixman_image_create_solid_fill (&color);
+
+    case 1:
+	return create_gradient (FALSE);
+
+    case 2:
+	return create_gradient (TRUE);
+
+    case 3:
+    case 4:
+	image = create_bits (formats[prng_rand_n (ARRAY_LENGTH (formats))]);
+	pixman_transform_init_scale (&transform,
+				     pixman_double_to_fixed (0.75),
+				     pixman_double_to_fixed (0.75));
+	pixman_image_set_transform (image, &transform);
+	pixman_image_set_filter (
+	    image, (i % 8) == 3 ? PIXMAN_FILTER_NEAREST : PIXMAN_FILTER_BILINEAR,
+	    NULL, 0);
+	pixman_image_set_repeat (image, prng_rand_n (4));
+	return image;
+
+    default:
+	image = create_bits (formats[prng_rand_n (ARRAY_LENGTH (formats))]);
+	if (prng_rand_n (4) == 0)
+	    pixman_image_set_repeat (image, PIXMAN_REPEAT_NORMAL);
+	return image;
+    }
+}
+
+static pixman_image_t *
+create_mask (int i)
+{
+    pixman_image_t *image;
+
+    if (i == 0)
+	return NULL;
+
+    if (i < 5)
+	return create_bits (PIXMAN_a8);
+
+    image = create_bits (PIXMAN_a8r8g8b8);
+    pixman_image_set_component_alpha (image, TRUE);
+
+    return image;
+}
+
+static void
+replay (const trace_op_t *trace, int n)
+{
+    int i;
+
+    for (i = 0; i < n; ++i)
+    {
+	const trace_op_t *t = &trace[i];
+
+	pixman_image_composite32 (t->op,
+				  sources[t->src], masks[t->mask], dests[t->dest],
+				  0, 0, 0, 0, 0, 0, t->width, t->height);
+    }
+}
+
+static int
+compare_hits (const void *a, const void *b)
+{
+    const pixman_cached_fast_path_t *fa = a;
+    const pixman_cached_fast_path_t *fb = b;
+
+    if (fa->n_hits == fb->n_hits)
+	return 0;
+
+    return fa->n_hits < fb->n_hits ? 1 : -1;
+}
+
+int
+main (int argc, char *argv[])
+{
+    pixman_cached_fast_path_t *entries;
+    uint64_t n_hits, n_misses;
+    trace_op_t *trace;
+    double t1, t2;
+    int i, n_entries;
+
+    prng_srand (0x6e37aa2d);
+
+    for (i = 0; i < N_SOURCES; ++i)
+	sources[i] = create_source (i);
+    for (i = 0; i < N_MASKS; ++i)
+	masks[i] = create_mask (i);
+    for (i = 0; i < (int)N_DESTS; ++i)
+	dests[i] = create_bits (formats[i]);
+
+    trace = malloc (TRACE_LENGTH * sizeof (trace_op_t));
+    for (i = 0; i < TRACE_LENGTH; ++i)
+    {
+	trace[i].op = ops[prng_rand_n (ARRAY_LENGTH (ops))];
+	trace[i].src = prng_rand_n (N_SOURCES);
+	trace[i].mask = prng_rand_n (N_MASKS);
+	trace[i].dest = prng_rand_n (N_DESTS);
+	trace[i].width = 4 + prng_rand_n (12);
+	trace[i].height = 8 + prng_rand_n (8);
+    }
+
+    /* Warm up, then measure from a clean cache */
+    replay (trace, TRACE_LENGTH);
+    _pixman_internal_only_reset_fast_path_cache ();
+
+    t1 = gettime ();
+    for (i = 0; i < N_REPLAYS; ++i)
+	replay (trace, TRACE_LENGTH);
+    t2 = gettime ();
+
+    printf ("%d composites: %.1f ns per composite\n",
+	    TRACE_LENGTH * N_REPLAYS,
+	    (t2 - t1) * 1000000000.0 / (TRACE_LENGTH * N_REPLAYS));
+
+    n_entries = _pixman_internal_only_get_fast_path_cache_stats (
+	NULL, 0, &n_hits, &n_misses);
+    entries = malloc (n_entries * sizeof (pixman_cached_fast_path_t));
+    n_entries = _pixman_internal_only_get_fast_path_cache_stats (
+	entries, n_entries, NULL, NULL);
+
+    printf ("fast path cache: %d entries, %llu hits, %llu misses (%.2f%%)\n",
+	    n_entries,
+	    (unsigned long long)n_hits, (unsigned long long)n_misses,
+	    100.0 * n_misses / (n_hits + n_misses));
+
+    qsort (entries, n_entries, sizeof (pixman_cached_fast_path_t), compare_hits);
+
+    printf ("\n%-4s %-10s %-10s %-10s %-10s %-10s %-10s %s\n",
+	    "op", "src", "src flags", "mask", "mask flags",
+	    "dest", "dest flags", "hits");
+    for (i = 0; i < n_entries && i < 16; ++i)
+    {
+	const pixman_fast_path_t *f = &entries[i].fast_path;
+
+	printf ("%-4d %08x   %08x   %08x   %08x   %08x   %08x   %u\n",
+		f->op, f->src_format, f->src_flags,
+		f->mask_format, f->mask_flags,
+		f->dest_format, f->dest_flags, entries[i].n_hits);
+    }
+
+    free (entries);
+    free (trace);
+
+    for (i = 0; i < N_SOURCES; ++i)
+	pixman_image_unref (sources[i]);
+    for (i = 1; i < N_MASKS; ++i)
+	pixman_image_unref (masks[i]);
+    for (i = 0; i < (int)N_DESTS; ++i)
+	pixman_image_unref (dests[i]);
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+ * Times pixman_composite_glyphs() and pixman_composite_glyphs_no_mask()
+ * drawing a screenful of terminal text: 80x24 cells of 8x16
+ * antialiased a8 glyphs, in a solid color onto an x8r8g8b8 window,
+ * as the X server does for RENDER text. The "overhang" run uses
+ * glyphs that are wider than their advance, as with italic fonts.
+ */
+#include <stdlib.h>
+#include "utils.h"
+
+#define COLUMNS		80
+#define ROWS		24
+#define CELL_WIDTH	8
+#define CELL_HEIGHT	16
+#define N_GLYPHS	95	/* printable ASCII */
+#define MIN_TIME	0.3
+
+static pixman_image_t *
+make_glyph (int width, int height)
+{
+    pixman_image_t *image =
+	pixman_image_create_bits (PIXMAN_a8, width, height, NULL, 0);
+    uint8_t *bits = (uint8_t *)pixman_image_get_data (image);
+    int stride = pixman_image_get_stride (image);
+    int x, y;
+
+    /* Some strokes with antialiased edges; the exact shape does not
+     * matter, only that most pixels are blank and the rest mixed.
+     */
+    for (y = 2; y < height - 3; y++)
+    {
+	for (x = 1; x < width - 1; x++)
+	{
+	    if (prng_rand_n (3) == 0)
+		bits[y * stride + x] = prng_rand_n (2) ? 0xff : prng_rand_n (256);
+	}
+    }
+
+    return image;
+}
+
+static void
+fill_screen (pixman_glyph_cache_t *cache, pixman_glyph_t *glyphs,
+	     int glyph_width)
+{
+    int i;
+
+    pixman_glyph_cache_freeze (cache);
+
+    for (i = 0; i < COLUMNS * ROWS; i++)
+    {
+	int c = prng_rand_n (N_GLYPHS);
+	void *key1 = (void *)(uintptr_t)(c + 1);
+	void *key2 = (void *)(uintptr_t)glyph_width;
+	const void *glyph;
+
+	if (!(glyph = pixman_glyph_cache_lookup (cache, key1, key2)))
+	{
+	    pixman_image_t *image = make_glyph (glyph_width, CELL_HEIGHT);
+
+	    glyph = pixman_glyph_cache_insert (
+		cache, key1, key2, 0, CELL_HEIGHT - 4, image);
+	    pixman_image_unref (image);
+	}
+
+	glyphs[i].glyph = glyph;
+	glyphs[i].x = (i % COLUMNS) * CELL_WIDTH;
+	glyphs[i].y = (i / COLUMNS) * CELL_HEIGHT + CELL_HEIGHT - 4;
+    }
+
+    pixman_glyph_cache_thaw (cache);
+}
+
+static void
+bench (const char *name, pixman_glyph_cache_t *cache,
+       const pixman_glyph_t *glyphs, pixman_image_t *src, pixman_image_t *dest)
+{
+    double start, t1, t2;
+    int n;
+
+    start = gettime ();
+    n = 0;
+    do
+    {
+	pixman_composite_glyphs (
+	    PIXMAN_OP_OVER, src, dest, PIXMAN_a8, 0, 0, 0, 0, 0, 0,
+	    COLUMNS * CELL_WIDTH, ROWS * CELL_HEIGHT,
+	    cache, COLUMNS * ROWS, glyphs);
+	n++;
+	t1 = gettime () - start;
+    }
+    while (t1 < MIN_TIME);
+    t1 /= n;
+
+    start = gettime ();
+    n = 0;
+    do
+    {
+	pixman_composite_glyphs_no_mask (
+	    PIXMAN_OP_OVER, src, dest, 0, 0, 0, 0,
+	    cache, COLUMNS * ROWS, glyphs);
+	n++;
+	t2 = gettime () - start;
+    }
+    while (t2 < MIN_TIME);
+    t2 /= n;
+
+    printf ("%-12s %12.1f %12.1f %12.2f\n", name,
+	    t1 * 1000000, t2 * 1000000,
+	    COLUMNS * ROWS / t1 / 1000000);
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const pixman_color_t color = { 0xc000, 0xc000, 0xc000, 0xffff };
+    pixman_glyph_t glyphs[COLUMNS * ROWS];
+    pixman_glyph_cache_t *cache;
+    pixman_image_t *src, *dest;
+
+    prng_srand (0x7e41a1c5);
+
+    cache = pixman_glyph_cache_create ();
+    src = pixman_image_create_solid_fill (&color);
+    dest = pixman_image_create_bits (
+	PIXMAN_x8r8g8b8, COLUMNS * CELL_WIDTH, ROWS * CELL_HEIGHT, NULL, 0);
+
+    printf ("# %-10s %12s %12s %12s\n",
+	    "glyphs", "mask/us", "no_mask/us", "Mglyph/s");
+
+    fill_screen (cache, glyphs, CELL_WIDTH);
+    bench ("monospace", cache, glyphs, src, dest);
+
+    fill_screen (cache, glyphs, CELL_WIDTH + 2);
+    bench ("overhang", cache, glyphs, src, dest);
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    pixman_glyph_cache_destroy (cache);
+
+    return 0;
+}
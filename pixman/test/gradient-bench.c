@@ -0,0 +1,124 @@
+/*
+ * Times linear, radial and conical gradients composited onto a
+ * 32 bpp destination in all four repeat modes.
+ */
+#include <stdlib.h>
+#include "utils.h"
+
+#define WIDTH		512
+#define HEIGHT		512
+#define MIN_TIME	0.2
+
+static const pixman_gradient_stop_t stops[] =
+{
+    { pixman_double_to_fixed (0.0),  { 0xffff, 0x0000, 0x0000, 0xffff } },
+    { pixman_double_to_fixed (0.3),  { 0x0000, 0xffff, 0x0000, 0xc000 } },
+    { pixman_double_to_fixed (0.7),  { 0x0000, 0x0000, 0xffff, 0x8000 } },
+    { pixman_double_to_fixed (1.0),  { 0xffff, 0xffff, 0xffff, 0xffff } },
+};
+
+static const struct
+{
+    pixman_repeat_t	repeat;
+    const char *	name;
+} repeats[] =
+{
+    { PIXMAN_REPEAT_NONE,	"none" },
+    { PIXMAN_REPEAT_PAD,	"pad" },
+    { PIXMAN_REPEAT_NORMAL,	"normal" },
+    { PIXMAN_REPEAT_REFLECT,	"reflect" },
+};
+
+static pixman_image_t *
+create_gradient (int type)
+{
+    pixman_point_fixed_t p1, p2;
+
+    switch (type)
+    {
+    case 0: /* horizontal */
+	p1.x = pixman_int_to_fixed (WIDTH / 4);
+	p1.y = 0;
+	p2.x = pixman_int_to_fixed (WIDTH / 2);
+	p2.y = 0;
+	return pixman_image_create_linear_gradient (
+	    &p1, &p2, stops, ARRAY_LENGTH (stops));
+
+    case 1: /* diagonal */
+	p1.x = pixman_int_to_fixed (WIDTH / 4);
+	p1.y = pixman_int_to_fixed (HEIGHT / 3);
+	p2.x = pixman_int_to_fixed (WIDTH / 2);
+	p2.y = pixman_int_to_fixed (HEIGHT / 2);
+	return pixman_image_create_linear_gradient (
+	    &p1, &p2, stops, ARRAY_LENGTH (stops));
+
+    case 2: /* radial */
+	p1.x = pixman_int_to_fixed (WIDTH / 2);
+	p1.y = pixman_int_to_fixed (HEIGHT / 2);
+	p2.x = pixman_int_to_fixed (WIDTH / 3);
+	p2.y = pixman_int_to_fixed (HEIGHT / 3);
+	return pixman_image_create_radial_gradient (
+	    &p1, &p2, pixman_int_to_fixed (10), pixman_int_to_fixed (WIDTH / 4),
+	    stops, ARRAY_LENGTH (stops));
+
+    default: /* conical */
+	p1.x = pixman_int_to_fixed (WIDTH / 2);
+	p1.y = pixman_int_to_fixed (HEIGHT / 2);
+	return pixman_image_create_conical_gradient (
+	    &p1, pixman_int_to_fixed (30), stops, ARRAY_LENGTH (stops));
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const char *names[] =
+    {
+	"linear horizontal", "linear diagonal", "radial", "conical"
+    };
+    pixman_image_t *dest;
+    int type, r;
+
+    dest = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, 0);
+
+    printf ("# %-20s %-8s %10s %10s\n", "gradient", "repeat", "SRC", "OVER");
+
+    for (type = 0; type < 4; type++)
+    {
+	for (r = 0; r < (int)ARRAY_LENGTH (repeats); r++)
+	{
+	    pixman_image_t *src = create_gradient (type);
+	    double mpix[2];
+	    int op;
+
+	    pixman_image_set_repeat (src, repeats[r].repeat);
+
+	    for (op = 0; op < 2; op++)
+	    {
+		double start = gettime (), t;
+		int n = 0;
+
+		do
+		{
+		    pixman_image_composite32 (
+			op == 0 ? PIXMAN_OP_SRC : PIXMAN_OP_OVER,
+			src, NULL, dest, 0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+		    n++;
+		    t = gettime () - start;
+		}
+		while (t < MIN_TIME);
+
+		mpix[op] = (double)n * WIDTH * HEIGHT / t / 1000000.0;
+	    }
+
+	    printf ("%-22s %-8s %10.2f %10.2f Mpix/s\n",
+		    names[type], repeats[r].name, mpix[0], mpix[1]);
+
+	    pixman_image_unref (src);
+	}
+    }
+
+    pixman_image_unref (dest);
+
+    return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * Region microbenchmarks. Accumulating damage compares adding boxes
+ * one at a time with pixman_region32_union_rect() against
+ * pixman_region32_init_rects() followed by a union, and against
+ * pixman_region32_union_boxes(). The set operations time union,
+ * intersect and subtract of two complex regions, as done for clip
+ * validation.
+ */
+#include <stdlib.h>
+#include "utils.h"
+
+#define SIZE		2048
+#define MIN_TIME	0.2
+
+typedef void (* bench_func_t) (void *data);
+
+typedef struct
+{
+    pixman_region32_t		base;
+    const pixman_box32_t *	boxes;
+    int				n_boxes;
+} damage_t;
+
+typedef struct
+{
+    pixman_region32_t		r1;
+    pixman_region32_t		r2;
+} set_op_t;
+
+static double
+bench (bench_func_t func, void *data)
+{
+    double start = gettime ();
+    double t;
+    int n = 0;
+
+    do
+    {
+	func (data);
+	n++;
+	t = gettime () - start;
+    }
+    while (t < MIN_TIME);
+
+    return t * 1000000 / n;
+}
+
+static pixman_box32_t *
+random_boxes (int n, int max_size, pixman_bool_t sorted)
+{
+    pixman_box32_t *boxes = malloc (n * sizeof (pixman_box32_t));
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+	if (sorted)
+	{
+	    /* Lines of glyph sized boxes in raster order */
+	    int per_line = SIZE / (max_size + 1);
+
+	    boxes[i].x1 = (i % per_line) * (max_size + 1);
+	    boxes[i].y1 = (i / per_line) * (max_size + 1);
+	}
+	else
+	{
+	    boxes[i].x1 = prng_rand_n (SIZE);
+	    boxes[i].y1 = prng_rand_n (SIZE);
+	}
+
+	boxes[i].x2 = boxes[i].x1 + 1 + prng_rand_n (max_size);
+	boxes[i].y2 = boxes[i].y1 + 1 + prng_rand_n (max_size);
+    }
+
+    return boxes;
+}
+
+static void
+damage_union_rect (void *data)
+{
+    damage_t *d = data;
+    pixman_region32_t region;
+    int i;
+
+    pixman_region32_init (&region);
+    pixman_region32_copy (&region, &d->base);
+
+    for (i = 0; i < d->n_boxes; i++)
+    {
+	const pixman_box32_t *b = &d->boxes[i];
+
+	pixman_region32_union_rect (&region, &region,
+				    b->x1, b->y1, b->x2 - b->x1, b->y2 - b->y1);
+    }
+
+    pixman_region32_fini (&region);
+}
+
+static void
+damage_init_rects (void *data)
+{
+    damage_t *d = data;
+    pixman_region32_t region, tmp;
+
+    pixman_region32_init_rects (&tmp, d->boxes, d->n_boxes);
+    pixman_region32_init (&region);
+    pixman_region32_union (&region, &d->base, &tmp);
+
+    pixman_region32_fini (&tmp);
+    pixman_region32_fini (&region);
+}
+
+static void
+damage_union_boxes (void *data)
+{
+    damage_t *d = data;
+    pixman_region32_t region;
+
+    pixman_region32_init (&region);
+    pixman_region32_union_boxes (&region, &d->base, d->boxes, d->n_boxes);
+    pixman_region32_fini (&region);
+}
+
+static void
+set_op_union (void *data)
+{
+    set_op_t *s = data;
+    pixman_region32_t region;
+
+    pixman_region32_init (&region);
+    pixman_region32_union (&region, &s->r1, &s->r2);
+    pixman_region32_fini (&region);
+}
+
+static void
+set_op_intersect (void *data)
+{
+    set_op_t *s = data;
+    pixman_region32_t region;
+
+    pixman_region32_init (&region);
+    pixman_region32_intersect (&region, &s->r1, &s->r2);
+    pixman_region32_fini (&region);
+}
+
+static void
+set_op_subtract (void *data)
+{
+    set_op_t *s = data;
+    pixman_region32_t region;
+
+    pixman_region32_init (&region);
+    pixman_region32_subtract (&region, &s->r1, &s->r2);
+    pixman_region32_fini (&region);
+}
+
+static void
+bench_damage (const char *name, int n_boxes, int max_size, pixman_bool_t sorted)
+{
+    pixman_box32_t *base_boxes = random_boxes (64, 256, FALSE);
+    damage_t d;
+    double t1, t2, t3;
+
+    pixman_region32_init_rects (&d.base, base_boxes, 64);
+    d.boxes = random_boxes (n_boxes, max_size, sorted);
+    d.n_boxes = n_boxes;
+
+    t1 = bench (damage_union_rect, &d);
+    t2 = bench (damage_init_rects, &d);
+    t3 = bench (damage_union_boxes, &d);
+
+    printf ("%-24s %6d %12.2f %12.2f %12.2f\n", name, n_boxes, t1, t2, t3);
+
+    pixman_region32_fini (&d.base);
+    free ((void *)d.boxes);
+    free (base_boxes);
+}
+
+static void
+bench_set_ops (int n_boxes)
+{
+    pixman_box32_t *boxes1 = random_boxes (n_boxes, 64, FALSE);
+    pixman_box32_t *boxes2 = random_boxes (n_boxes, 64, FALSE);
+    set_op_t s;
+
+    pixman_region32_init_rects (&s.r1, boxes1, n_boxes);
+    pixman_region32_init_rects (&s.r2, boxes2, n_boxes);
+
+    printf ("%-24s %6d %12.2f %12.2f %12.2f\n", "set ops", n_boxes,
+	    bench (set_op_union, &s),
+	    bench (set_op_intersect, &s),
+	    bench (set_op_subtract, &s));
+
+    pixman_region32_fini (&s.r1);
+    pixman_region32_fini (&s.r2);
+    free (boxes1);
+    free (boxes2);
+}
+
+int
+main (int argc, char *argv[])
+{
+    prng_srand (0x1a5e9d3b);
+
+    printf ("# times in us per operation\n");
+    printf ("# %-22s %6s %12s %12s %12s\n",
+	    "damage", "boxes", "union_rect", "init_rects", "union_boxes");
+
+    bench_damage ("random", 16, 32, FALSE);
+    bench_damage ("random", 256, 32, FALSE);
+    bench_damage ("random", 1024, 32, FALSE);
+    bench_damage ("raster order", 256, 12, TRUE);
+    bench_damage ("raster order", 4096, 12, TRUE);
+
+    printf ("\n# %-22s %6s %12s %12s %12s\n",
+	    "set ops", "boxes", "union", "intersect", "subtract");
+
+    bench_set_ops (64);
+    bench_set_ops (512);
+    bench_set_ops (4096);
+
+    return 0;
+}
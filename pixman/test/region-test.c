@@ -121,5 +121,40 @@ main ()
     }
     pixman_image_unref (fill);
 
+    /* Adding boxes all at once must give the same region as adding
+     * them one at a time
+     */
+    for (i = 0; i < 100; i++)
+    {
+	pixman_box32_t random_boxes[64];
+	int image_size = 128;
+
+	pixman_region32_init_rect (&r1, prng_rand_n (image_size),
+				   prng_rand_n (image_size), 32, 32);
+	pixman_region32_init (&r2);
+	pixman_region32_copy (&r2, &r1);
+
+	for (j = 0; j < 64; j++)
+	{
+	    random_boxes[j].x1 = prng_rand_n (image_size);
+	    random_boxes[j].y1 = prng_rand_n (image_size);
+	    random_boxes[j].x2 = random_boxes[j].x1 + prng_rand_n (25);
+	    random_boxes[j].y2 = random_boxes[j].y1 + prng_rand_n (25);
+
+	    pixman_region32_union_rect (&r1, &r1,
+					random_boxes[j].x1,
+					random_boxes[j].y1,
+					random_boxes[j].x2 - random_boxes[j].x1,
+					random_boxes[j].y2 - random_boxes[j].y1);
+	}
+
+	pixman_region32_union_boxes (&r2, &r2, random_boxes, 64);
+	assert (pixman_region32_selfcheck (&r2));
+	assert (pixman_region32_equal (&r1, &r2));
+
+	pixman_region32_fini (&r1);
+	pixman_region32_fini (&r2);
+    }
+
     return 0;
 }
@@ -0,0 +1,126 @@
+/*
+ * Times high quality downscaling with a SEPARABLE_CONVOLUTION filter,
+ * as done when making thumbnails of screenshots, and the cost of
+ * creating the filter parameters for each image.
+ */
+#include <stdlib.h>
+#include "utils.h"
+
+#define SOURCE_WIDTH	1920
+#define SOURCE_HEIGHT	1080
+#define MIN_TIME	0.3
+
+static const struct
+{
+    const char *	name;
+    pixman_kernel_t	reconstruct;
+    pixman_kernel_t	sample;
+    int			subsample_bits;
+} filters[] =
+{
+    { "box.box",	PIXMAN_KERNEL_BOX,	PIXMAN_KERNEL_BOX,	4 },
+    { "linear.box",	PIXMAN_KERNEL_LINEAR,	PIXMAN_KERNEL_BOX,	4 },
+    { "cubic.box",	PIXMAN_KERNEL_CUBIC,	PIXMAN_KERNEL_BOX,	4 },
+    { "lanczos3.box",	PIXMAN_KERNEL_LANCZOS3,	PIXMAN_KERNEL_BOX,	4 },
+};
+
+static pixman_fixed_t *
+create_filter (int i, pixman_fixed_t scale, int *n_params)
+{
+    return pixman_filter_create_separable_convolution (
+	n_params, scale, scale,
+	filters[i].reconstruct, filters[i].reconstruct,
+	filters[i].sample, filters[i].sample,
+	filters[i].subsample_bits, filters[i].subsample_bits);
+}
+
+static void
+bench (pixman_image_t *src, pixman_format_code_t format, int f, double scale)
+{
+    int dest_width = SOURCE_WIDTH / scale + 0.5;
+    int dest_height = SOURCE_HEIGHT / scale + 0.5;
+    pixman_fixed_t s = pixman_double_to_fixed (scale);
+    pixman_transform_t transform;
+    pixman_fixed_t *params;
+    pixman_image_t *dest;
+    double start, t_filter, t;
+    int n_params, n;
+
+    /* Filter creation */
+    start = gettime ();
+    n = 0;
+    do
+    {
+	free (create_filter (f, s, &n_params));
+	n++;
+	t_filter = gettime () - start;
+    }
+    while (t_filter < MIN_TIME / 4);
+    t_filter /= n;
+
+    params = create_filter (f, s, &n_params);
+    pixman_image_set_filter (
+	src, PIXMAN_FILTER_SEPARABLE_CONVOLUTION, params, n_params);
+    free (params);
+
+    pixman_transform_init_scale (&transform, s, s);
+    pixman_image_set_transform (src, &transform);
+
+    dest = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, dest_width, dest_height, NULL, 0);
+
+    start = gettime ();
+    n = 0;
+    do
+    {
+	pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+				  0, 0, 0, 0, 0, 0, dest_width, dest_height);
+	n++;
+	t = gettime () - start;
+    }
+    while (t < MIN_TIME);
+    t /= n;
+
+    printf ("%-10s %-14s %5.2f %4dx%-4d %12.2f %12.3f\n",
+	    format == PIXMAN_a8r8g8b8 ? "a8r8g8b8" : "x8r8g8b8",
+	    filters[f].name, scale, dest_width, dest_height,
+	    t_filter * 1000000, t * 1000);
+
+    pixman_image_unref (dest);
+}
+
+int
+main (int argc, char *argv[])
+{
+    static const double scales[] = { 1.5, 4.0, 8.0 };
+    static const pixman_format_code_t formats[] =
+    {
+	PIXMAN_a8r8g8b8, PIXMAN_x8r8g8b8
+    };
+    int i, f, s;
+
+    prng_srand (0x5e9a7a3b);
+
+    printf ("# %-8s %-14s %5s %9s %12s %12s\n",
+	    "format", "filter", "scale", "dest", "filter/us", "time/ms");
+
+    for (i = 0; i < (int)ARRAY_LENGTH (formats); i++)
+    {
+	pixman_image_t *src = pixman_image_create_bits (
+	    formats[i], SOURCE_WIDTH, SOURCE_HEIGHT, NULL, 0);
+
+	prng_randmemset (pixman_image_get_data (src),
+			 pixman_image_get_stride (src) * SOURCE_HEIGHT, 0);
+	pixman_image_set_repeat (src, PIXMAN_REPEAT_PAD);
+
+	for (f = 0; f < (int)ARRAY_LENGTH (filters); f++)
+	{
+	    for (s = 0; s < (int)ARRAY_LENGTH (scales); s++)
+		bench (src, formats[i], f, scales[s]);
+	}
+
+	pixman_image_unref (src);
+    }
+
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*
+ * Checks that pixman_image_composite32_threaded() produces exactly the
+ * same pixels as pixman_image_composite32() for composites that are
+ * large enough to be split into bands.
+ */
+#include <stdlib.h>
+#include "utils.h"
+
+#define N_TESTS		300
+#define WIDTH		400
+#define HEIGHT		300
+
+static const pixman_op_t operators[] =
+{
+    PIXMAN_OP_SRC,
+    PIXMAN_OP_OVER,
+    PIXMAN_OP_ADD,
+    PIXMAN_OP_IN,
+    PIXMAN_OP_OUT_REVERSE,
+    PIXMAN_OP_ATOP,
+    PIXMAN_OP_MULTIPLY,
+    PIXMAN_OP_DIFFERENCE,
+};
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+    PIXMAN_r5g6b5,
+    PIXMAN_a8,
+    PIXMAN_a2r10g10b10,
+    PIXMAN_r8g8b8,
+};
+
+static const pixman_filter_t filters[] =
+{
+    PIXMAN_FILTER_NEAREST,
+    PIXMAN_FILTER_BILINEAR,
+    PIXMAN_FILTER_GOOD,
+};
+
+#define RAND_ELT(arr)							\
+    arr[prng_rand_n (ARRAY_LENGTH (arr))]
+
+static pixman_image_t *
+create_source (void)
+{
+    static const pixman_gradient_stop_t stops[] =
+    {
+	{ pixman_int_to_fixed (0), { 0xffff, 0x2000, 0x0000, 0xffff } },
+	{ pixman_int_to_fixed (1), { 0x0000, 0x8000, 0xffff, 0x4000 } },
+    };
+    pixman_point_fixed_t c1 = { pixman_int_to_fixed (WIDTH / 2),
+				pixman_int_to_fixed (HEIGHT / 2) };
+    pixman_point_fixed_t c2 = { pixman_int_to_fixed (WIDTH / 3),
+				pixman_int_to_fixed (HEIGHT / 4) };
+    pixman_transform_t transform;
+    pixman_image_t *image;
+    int width, height;
+
+    switch (prng_rand_n (4))
+    {
+    case 0:
+	return pixman_image_create_radial_gradient (
+	    &c1, &c2, pixman_int_to_fixed (10), pixman_int_to_fixed (WIDTH),
+	    stops, ARRAY_LENGTH (stops));
+
+    case 1:
+	return pixman_image_create_linear_gradient (
+	    &c2, &c1, stops, ARRAY_LENGTH (stops));
+
+    default:
+	width = 1 + prng_rand_n (WIDTH);
+	height = 1 + prng_rand_n (HEIGHT);
+	image = pixman_image_create_bits (
+	    RAND_ELT (formats), width, height, NULL, 0);
+	prng_randmemset (pixman_image_get_data (image),
+			 pixman_image_get_stride (image) * height, 0);
+
+	pixman_transform_init_identity (&transform);
+	if (prng_rand_n (2))
+	{
+	    pixman_transform_scale (
+		&transform, NULL,
+		pixman_int_to_fixed (1) / 4 + prng_rand_n (pixman_int_to_fixed (3)),
+		pixman_int_to_fixed (1) / 4 + prng_rand_n (pixman_int_to_fixed (3)));
+	}
+	if (prng_rand_n (3) == 0)
+	{
+	    pixman_transform_rotate (
+		&transform, NULL,
+		pixman_double_to_fixed (0.8), pixman_double_to_fixed (0.6));
+	}
+	pixman_image_set_transform (image, &transform);
+	pixman_image_set_filter (image, RAND_ELT (filters), NULL, 0);
+	pixman_image_set_repeat (image, prng_rand_n (4));
+
+	return image;
+    }
+}
+
+static pixman_image_t *
+create_mask (void)
+{
+    pixman_image_t *image;
+
+    switch (prng_rand_n (3))
+    {
+    case 0:
+	return NULL;
+
+    case 1:
+	image = pixman_image_create_bits (PIXMAN_a8, WIDTH, HEIGHT, NULL, 0);
+	break;
+
+    default:
+	image = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, 0);
+	pixman_image_set_component_alpha (image, prng_rand_n (2));
+	break;
+    }
+
+    prng_randmemset (pixman_image_get_data (image),
+		     pixman_image_get_stride (image) * HEIGHT, 0);
+
+    return image;
+}
+
+static void
+set_random_clip (pixman_image_t *dest1, pixman_image_t *dest2)
+{
+    pixman_region32_t clip;
+    int i;
+
+    pixman_region32_init (&clip);
+
+    for (i = 0; i < 5; ++i)
+    {
+	pixman_region32_t box;
+
+	pixman_region32_init_rect (&box,
+				   prng_rand_n (WIDTH), prng_rand_n (HEIGHT),
+				   prng_rand_n (WIDTH), prng_rand_n (HEIGHT));
+	pixman_region32_union (&clip, &clip, &box);
+	pixman_region32_fini (&box);
+    }
+
+    pixman_image_set_clip_region32 (dest1, &clip);
+    pixman_image_set_clip_region32 (dest2, &clip);
+    pixman_region32_fini (&clip);
+}
+
+/* Composites where the source, the mask or the source's alpha map is a
+ * sub-image of the destination's buffer at another start address must
+ * still give the serial result.
+ */
+#define N_ALIAS_TESTS	30
+#define ALIAS_OFFSET	16
+
+static pixman_image_t *
+create_alias (uint32_t *buffer, int row)
+{
+    return pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT,
+				     buffer + row * WIDTH, WIDTH * 4);
+}
+
+static pixman_op_t
+test_aliasing (int n, pixman_bool_t threaded, uint32_t *buffer)
+{
+    pixman_image_t *dest, *src, *mask = NULL, *alias;
+    pixman_op_t op = RAND_ELT (operators);
+    pixman_color_t color = { 0x4000, 0x8000, 0xc000, 0xa000 };
+
+    /* The destination starts ALIAS_OFFSET rows into the buffer, the
+     * alias at its start, so each one reads rows the other writes.
+     */
+    dest = create_alias (buffer, ALIAS_OFFSET);
+    alias = create_alias (buffer, 0);
+
+    switch (n % 3)
+    {
+    case 0:
+	src = pixman_image_ref (alias);
+	break;
+
+    case 1:
+	src = pixman_image_create_solid_fill (&color);
+	mask = pixman_image_ref (alias);
+	pixman_image_set_component_alpha (mask, TRUE);
+	break;
+
+    default:
+	src = pixman_image_create_bits (PIXMAN_a8r8g8b8, WIDTH, HEIGHT, NULL, 0);
+	prng_randmemset (pixman_image_get_data (src), WIDTH * 4 * HEIGHT, 0);
+	pixman_image_set_alpha_map (src, alias, 0, 0);
+	break;
+    }
+
+    if (threaded)
+    {
+	pixman_image_composite32_threaded (op, src, mask, dest,
+					   0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+    }
+    else
+    {
+	pixman_image_composite32 (op, src, mask, dest,
+				  0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+    }
+
+    pixman_image_unref (src);
+    if (mask)
+	pixman_image_unref (mask);
+    pixman_image_unref (alias);
+    pixman_image_unref (dest);
+
+    return op;
+}
+
+static int
+check_aliasing (void)
+{
+    size_t size = WIDTH * 4 * (HEIGHT + ALIAS_OFFSET);
+    uint32_t *serial = malloc (size);
+    uint32_t *threaded = malloc (size);
+    int n_failed = 0;
+    int i;
+
+    for (i = 0; i < N_ALIAS_TESTS; ++i)
+    {
+	uint32_t seed = prng_rand ();
+	pixman_op_t op;
+
+	prng_randmemset (serial, size, 0);
+	memcpy (threaded, serial, size);
+
+	prng_srand (seed);
+	op = test_aliasing (i, FALSE, serial);
+	prng_srand (seed);
+	test_aliasing (i, TRUE, threaded);
+
+	if (memcmp (serial, threaded, size) != 0)
+	{
+	    printf ("threaded-composite-test: mismatch in aliasing test %d "
+		    "(op %s)\n", i, operator_name (op));
+	    n_failed++;
+	}
+    }
+
+    free (serial);
+    free (threaded);
+
+    return n_failed;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    pixman_format_code_t dest_format;
+    pixman_image_t *src, *mask, *serial, *threaded;
+    uint32_t *serial_bits, *threaded_bits;
+    int stride, n_failed = 0;
+    int i;
+
+#ifdef HAVE_PTHREADS
+    /* Force a pool even on single CPU machines */
+    setenv ("PIXMAN_NUM_THREADS", "4", 0);
+#endif
+
+    prng_srand (0);
+
+    for (i = 0; i < N_TESTS; ++i)
+    {
+	pixman_op_t op = RAND_ELT (operators);
+	int src_x = prng_rand_n (64) - 32;
+	int src_y = prng_rand_n (64) - 32;
+
+	dest_format = RAND_ELT (formats);
+	src = create_source ();
+	mask = create_mask ();
+
+	serial = pixman_image_create_bits (dest_format, WIDTH, HEIGHT, NULL, 0);
+	threaded = pixman_image_create_bits (dest_format, WIDTH, HEIGHT, NULL, 0);
+	serial_bits = pixman_image_get_data (serial);
+	threaded_bits = pixman_image_get_data (threaded);
+	stride = pixman_image_get_stride (serial);
+
+	prng_randmemset (serial_bits, stride * HEIGHT, 0);
+	memcpy (threaded_bits, serial_bits, stride * HEIGHT);
+
+	if (prng_rand_n (2))
+	    set_random_clip (serial, threaded);
+
+	pixman_image_composite32 (op, src, mask, serial,
+				  src_x, src_y, 0, 0, 0, 0, WIDTH, HEIGHT);
+	pixman_image_composite32_threaded (op, src, mask, threaded,
+					   src_x, src_y, 0, 0, 0, 0,
+					   WIDTH, HEIGHT);
+
+	if (memcmp (serial_bits, threaded_bits, stride * HEIGHT) != 0)
+	{
+	    printf ("threaded-composite-test: mismatch in test %d "
+		    "(op %s, dest %s)\n",
+		    i, operator_name (op), format_name (dest_format));
+	    n_failed++;
+	}
+
+	pixman_image_unref (src);
+	if (mask)
+	    pixman_image_unref (mask);
+	pixman_image_unref (serial);
+	pixman_image_unref (threaded);
+    }
+
+    n_failed += check_aliasing ();
+
+    return n_failed ? 1 : 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Compares pixman_image_composite32() with
+ * pixman_image_composite32_threaded() on fullscreen scaling and
+ * gradient composites, and checks that both give the same pixels.
+ * Set PIXMAN_NUM_THREADS to choose the size of the thread pool.
+ */
+#include <stdlib.h>
+#include "utils.h"
+
+#define DEST_WIDTH	1920
+#define DEST_HEIGHT	1080
+#define TEST_REPEATS	5
+
+typedef void (* composite_func_t) (pixman_op_t, pixman_image_t *,
+				   pixman_image_t *, pixman_image_t *,
+				   int32_t, int32_t, int32_t, int32_t,
+				   int32_t, int32_t, int32_t, int32_t);
+
+static pixman_image_t *
+make_source (int width, int height, pixman_filter_t filter)
+{
+    pixman_transform_t transform;
+    pixman_image_t *source;
+
+    source = pixman_image_create_bits (PIXMAN_a8r8g8b8, width, height, NULL, 0);
+    prng_randmemset (pixman_image_get_data (source),
+		     pixman_image_get_stride (source) * height, 0);
+
+    pixman_transform_init_scale (
+	&transform,
+	pixman_double_to_fixed ((double)width / DEST_WIDTH),
+	pixman_double_to_fixed ((double)height / DEST_HEIGHT));
+    pixman_image_set_transform (source, &transform);
+    pixman_image_set_filter (source, filter, NULL, 0);
+
+    return source;
+}
+
+static pixman_image_t *
+make_gradient (void)
+{
+    static const pixman_gradient_stop_t stops[] =
+    {
+	{ pixman_int_to_fixed (0), { 0xffff, 0x0000, 0x0000, 0xffff } },
+	{ pixman_int_to_fixed (1), { 0x0000, 0x8000, 0xffff, 0x8000 } },
+    };
+    pixman_point_fixed_t c1 = { pixman_int_to_fixed (DEST_WIDTH / 2),
+				pixman_int_to_fixed (DEST_HEIGHT / 2) };
+    pixman_point_fixed_t c2 = { pixman_int_to_fixed (DEST_WIDTH / 3),
+				pixman_int_to_fixed (DEST_HEIGHT / 3) };
+
+    return pixman_image_create_radial_gradient (
+	&c1, &c2, 0, pixman_int_to_fixed (DEST_WIDTH / 2),
+	stops, ARRAY_LENGTH (stops));
+}
+
+static double
+bench (composite_func_t composite, pixman_op_t op,
+       pixman_image_t *src, pixman_image_t *dest)
+{
+    double t1, t2, t = -1;
+    int i;
+
+    for (i = 0; i < TEST_REPEATS; i++)
+    {
+	memset (pixman_image_get_data (dest), 0,
+		pixman_image_get_stride (dest) * DEST_HEIGHT);
+
+	t1 = gettime ();
+	composite (op, src, NULL, dest,
+		   0, 0, 0, 0, 0, 0, DEST_WIDTH, DEST_HEIGHT);
+	t2 = gettime ();
+
+	if (t < 0 || t2 - t1 < t)
+	    t = t2 - t1;
+    }
+
+    return t;
+}
+
+static int
+run (const char *name, pixman_op_t op, pixman_image_t *src)
+{
+    pixman_image_t *serial, *threaded;
+    double ts, tt;
+    int equal;
+
+    serial = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, DEST_WIDTH, DEST_HEIGHT, NULL, 0);
+    threaded = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, DEST_WIDTH, DEST_HEIGHT, NULL, 0);
+
+    ts = bench (pixman_image_composite32, op, src, serial);
+    tt = bench (pixman_image_composite32_threaded, op, src, threaded);
+
+    equal = memcmp (pixman_image_get_data (serial),
+		    pixman_image_get_data (threaded),
+		    pixman_image_get_stride (serial) * DEST_HEIGHT) == 0;
+
+    printf ("%-28s %10.3f %10.3f %8.2fx %s\n",
+	    name, ts * 1000, tt * 1000, ts / tt, equal ? "" : "MISMATCH");
+
+    pixman_image_unref (serial);
+    pixman_image_unref (threaded);
+
+    return equal;
+}
+
+int
+main (int argc, char *argv[])
+{
+    pixman_image_t *src;
+    int ok = TRUE;
+
+    prng_srand (0x3a1d7c55);
+
+    printf ("# %-26s %10s %10s %9s\n",
+	    "composite", "serial/ms", "thread/ms", "speedup");
+
+    src = make_source (640, 360, PIXMAN_FILTER_BILINEAR);
+    ok &= run ("src 640x360 bilinear", PIXMAN_OP_SRC, src);
+    ok &= run ("over 640x360 bilinear", PIXMAN_OP_OVER, src);
+    pixman_image_unref (src);
+
+    src = make_source (1280, 720, PIXMAN_FILTER_NEAREST);
+    ok &= run ("src 1280x720 nearest", PIXMAN_OP_SRC, src);
+    pixman_image_unref (src);
+
+    src = make_source (3840, 2160, PIXMAN_FILTER_GOOD);
+    ok &= run ("src 3840x2160 good", PIXMAN_OP_SRC, src);
+    pixman_image_unref (src);
+
+    src = make_gradient ();
+    ok &= run ("over radial gradient", PIXMAN_OP_OVER, src);
+    pixman_image_unref (src);
+
+    return ok ? 0 : 1;
+}
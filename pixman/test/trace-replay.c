@@ -0,0 +1,844 @@
+/*
+ * Replays a trace recorded by running an application with PIXMAN_TRACE
+ * set (see pixman/pixman-trace.c) and reports where the time goes.
+ *
+ * Calls are grouped by their operation signature: the operator and the
+ * kind and format of each image, with the properties that select
+ * different paths (component alpha, transforms, repeat, clipping of
+ * sources) appended. Each group is replayed on its own, in trace order,
+ * until it has run for long enough to be timed reliably. The whole trace
+ * is also replayed once in order for the total.
+ *
+ * Images whose pixels were not recorded share buffers filled with random
+ * data; destinations of the same size share one buffer, as they usually
+ * would in the application.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+#include "pixman-trace.h"
+
+/* Each group is timed for MIN_TIME, or less when there are so many
+ * groups that it would take more than MAX_TIME in total.
+ */
+#define MIN_TIME	0.2
+#define MAX_TIME	10.0
+
+typedef enum
+{
+    ROLE_SOURCE,
+    ROLE_MASK,
+    ROLE_DEST,
+    ROLE_ALPHA_MAP,
+    ROLE_BLT_SOURCE
+} role_t;
+
+typedef struct buffer_t buffer_t;
+
+struct buffer_t
+{
+    buffer_t *	next;
+    role_t	role;
+    int		stride;
+    int		rows;
+    uint32_t *	bits;
+};
+
+typedef struct
+{
+    char	name[192];
+    int		n_calls;
+    int		first;		/* of the group's calls in order[] */
+    double	n_pixels;
+    double	time;
+} group_t;
+
+typedef struct
+{
+    pixman_trace_record_t type;
+    int			group;
+
+    pixman_op_t		op;
+    pixman_bool_t	threaded;
+    pixman_image_t *	src;
+    pixman_image_t *	mask;
+    pixman_image_t *	dest;
+
+    uint32_t *		src_bits;
+    uint32_t *		dst_bits;
+    int			src_stride, dst_stride;
+    int			src_bpp, dst_bpp;
+    uint32_t		filler;
+
+    int32_t		src_x, src_y;
+    int32_t		mask_x, mask_y;
+    int32_t		dest_x, dest_y;
+    int32_t		width, height;
+} call_t;
+
+typedef struct
+{
+    const uint8_t *	p;
+    const uint8_t *	end;
+    pixman_bool_t	failed;
+} reader_t;
+
+static buffer_t *buffers;
+static pixman_indexed_t palette;
+
+static void
+get (reader_t *r, void *data, size_t len)
+{
+    if (r->failed || (size_t)(r->end - r->p) < len)
+    {
+	r->failed = TRUE;
+	memset (data, 0, len);
+	return;
+    }
+
+    memcpy (data, r->p, len);
+    r->p += len;
+}
+
+static uint8_t
+get_u8 (reader_t *r)
+{
+    uint8_t v;
+
+    get (r, &v, sizeof (v));
+    return v;
+}
+
+static uint16_t
+get_u16 (reader_t *r)
+{
+    uint16_t v;
+
+    get (r, &v, sizeof (v));
+    return v;
+}
+
+static uint32_t
+get_u32 (reader_t *r)
+{
+    uint32_t v;
+
+    get (r, &v, sizeof (v));
+    return v;
+}
+
+static int32_t
+get_s32 (reader_t *r)
+{
+    int32_t v;
+
+    get (r, &v, sizeof (v));
+    return v;
+}
+
+static void
+get_color (reader_t *r, pixman_color_t *color)
+{
+    color->red = get_u16 (r);
+    color->green = get_u16 (r);
+    color->blue = get_u16 (r);
+    color->alpha = get_u16 (r);
+}
+
+/* Returns a buffer of at least stride * rows uint32_t's, shared with
+ * other images of the same role and size.
+ */
+static uint32_t *
+get_buffer (role_t role, int stride, int rows)
+{
+    buffer_t *buffer;
+
+    for (buffer = buffers; buffer; buffer = buffer->next)
+    {
+	if (buffer->role == role &&
+	    buffer->stride == stride && buffer->rows == rows)
+	{
+	    return buffer->bits;
+	}
+    }
+
+    buffer = malloc (sizeof (buffer_t));
+    buffer->role = role;
+    buffer->stride = stride;
+    buffer->rows = rows;
+    buffer->bits = malloc ((size_t)stride * rows * 4);
+    prng_randmemset (buffer->bits, (size_t)stride * rows * 4, 0);
+    buffer->next = buffers;
+    buffers = buffer;
+
+    return buffer->bits;
+}
+
+static void
+free_buffers (void)
+{
+    while (buffers)
+    {
+	buffer_t *next = buffers->next;
+
+	free (buffers->bits);
+	free (buffers);
+	buffers = next;
+    }
+}
+
+static void
+free_pixels (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+get_gradient (reader_t *r, pixman_trace_image_t kind)
+{
+    pixman_point_fixed_t p1, p2 = { 0, 0 };
+    pixman_fixed_t r1 = 0, r2 = 0, angle = 0;
+    pixman_gradient_stop_t *stops;
+    pixman_image_t *image = NULL;
+    int i, n_stops;
+
+    p1.x = get_s32 (r);
+    p1.y = get_s32 (r);
+
+    if (kind == PIXMAN_TRACE_IMAGE_CONICAL)
+    {
+	angle = get_s32 (r);
+    }
+    else if (kind == PIXMAN_TRACE_IMAGE_RADIAL)
+    {
+	r1 = get_s32 (r);
+	p2.x = get_s32 (r);
+	p2.y = get_s32 (r);
+	r2 = get_s32 (r);
+    }
+    else
+    {
+	p2.x = get_s32 (r);
+	p2.y = get_s32 (r);
+    }
+
+    n_stops = get_u32 (r);
+    if (r->failed || n_stops > (r->end - r->p) / 12)
+    {
+	r->failed = TRUE;
+	return NULL;
+    }
+
+    stops = malloc (n_stops * sizeof (pixman_gradient_stop_t));
+
+    for (i = 0; i < n_stops; i++)
+    {
+	stops[i].x = get_s32 (r);
+	get_color (r, &stops[i].color);
+    }
+
+    switch (kind)
+    {
+    case PIXMAN_TRACE_IMAGE_LINEAR:
+	image = pixman_image_create_linear_gradient (&p1, &p2, stops, n_stops);
+	break;
+    case PIXMAN_TRACE_IMAGE_RADIAL:
+	image = pixman_image_create_radial_gradient (
+	    &p1, &p2, r1, r2, stops, n_stops);
+	break;
+    case PIXMAN_TRACE_IMAGE_CONICAL:
+	image = pixman_image_create_conical_gradient (
+	    &p1, angle, stops, n_stops);
+	break;
+    default:
+	break;
+    }
+
+    free (stops);
+
+    return image;
+}
+
+static pixman_image_t *
+get_bits (reader_t *r, role_t role, uint8_t flags)
+{
+    pixman_format_code_t format = get_u32 (r);
+    int width = get_s32 (r);
+    int height = get_s32 (r);
+    int stride = abs (get_s32 (r));
+    size_t size = (size_t)stride * 4 * height;
+    pixman_image_t *image;
+    uint32_t *bits;
+
+    if (r->failed || width < 0 || height < 0 ||
+	((flags & PIXMAN_TRACE_PIXELS) && (size_t)(r->end - r->p) < size))
+    {
+	r->failed = TRUE;
+	return NULL;
+    }
+
+    if (!pixman_format_supported_source (format))
+    {
+	if (flags & PIXMAN_TRACE_PIXELS)
+	    r->p += size;
+
+	return NULL;
+    }
+
+    if (flags & PIXMAN_TRACE_PIXELS)
+    {
+	bits = malloc (size ? size : 4);
+	get (r, bits, size);
+
+	image = pixman_image_create_bits (
+	    format, width, height, bits, stride * 4);
+	pixman_image_set_destroy_function (image, free_pixels, bits);
+    }
+    else
+    {
+	bits = get_buffer (role, stride, height);
+
+	image = pixman_image_create_bits (
+	    format, width, height, bits, stride * 4);
+    }
+
+    if (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_COLOR ||
+	PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_GRAY)
+    {
+	pixman_image_set_indexed (image, &palette);
+    }
+
+    return image;
+}
+
+static pixman_image_t *
+get_image (reader_t *r, role_t role, char *desc, size_t desc_size)
+{
+    pixman_trace_image_t kind = get_u8 (r);
+    pixman_repeat_t repeat;
+    pixman_filter_t filter;
+    pixman_bool_t component_alpha;
+    pixman_transform_t transform;
+    pixman_region32_t clip;
+    pixman_image_t *alpha_map = NULL;
+    int alpha_x = 0, alpha_y = 0;
+    pixman_fixed_t *params = NULL;
+    pixman_image_t *image = NULL;
+    pixman_color_t color;
+    uint8_t flags;
+    int i, n;
+
+    desc[0] = '\0';
+
+    if (kind == PIXMAN_TRACE_IMAGE_NONE)
+    {
+	snprintf (desc, desc_size, "null");
+	return NULL;
+    }
+
+    repeat = get_u8 (r);
+    filter = get_u8 (r);
+    component_alpha = get_u8 (r);
+    flags = get_u8 (r);
+
+    if (flags & PIXMAN_TRACE_TRANSFORM)
+    {
+	for (i = 0; i < 9; i++)
+	    transform.matrix[i / 3][i % 3] = get_s32 (r);
+    }
+
+    pixman_region32_init (&clip);
+
+    if (flags & PIXMAN_TRACE_CLIP)
+    {
+	n = get_u32 (r);
+	if (r->failed || n > (r->end - r->p) / (int)sizeof (pixman_box32_t))
+	{
+	    r->failed = TRUE;
+	    goto out;
+	}
+
+	pixman_region32_init_rects (&clip, (const pixman_box32_t *)r->p, n);
+	r->p += n * sizeof (pixman_box32_t);
+    }
+
+    if (flags & PIXMAN_TRACE_ALPHA_MAP)
+    {
+	pixman_format_code_t format = get_u32 (r);
+	int width = get_s32 (r);
+	int height = get_s32 (r);
+	int stride = (width * PIXMAN_FORMAT_BPP (format) + 31) / 32;
+
+	alpha_x = get_s32 (r);
+	alpha_y = get_s32 (r);
+
+	if (!r->failed && width >= 0 && height >= 0)
+	{
+	    alpha_map = pixman_image_create_bits (
+		format, width, height,
+		get_buffer (ROLE_ALPHA_MAP, stride, height), stride * 4);
+	}
+    }
+
+    n = get_u32 (r);
+    if (r->failed || n > (r->end - r->p) / (int)sizeof (pixman_fixed_t))
+    {
+	r->failed = TRUE;
+	goto out;
+    }
+    params = malloc ((n + 1) * sizeof (pixman_fixed_t));
+    get (r, params, n * sizeof (pixman_fixed_t));
+
+    switch (kind)
+    {
+    case PIXMAN_TRACE_IMAGE_BITS:
+	image = get_bits (r, role, flags);
+	if (image)
+	{
+	    snprintf (desc, desc_size, "%s",
+		      format_name (image->bits.format));
+	}
+	break;
+
+    case PIXMAN_TRACE_IMAGE_SOLID:
+	get_color (r, &color);
+	image = pixman_image_create_solid_fill (&color);
+	snprintf (desc, desc_size, "solid");
+	break;
+
+    case PIXMAN_TRACE_IMAGE_LINEAR:
+	image = get_gradient (r, kind);
+	snprintf (desc, desc_size, "linear");
+	break;
+
+    case PIXMAN_TRACE_IMAGE_RADIAL:
+	image = get_gradient (r, kind);
+	snprintf (desc, desc_size, "radial");
+	break;
+
+    case PIXMAN_TRACE_IMAGE_CONICAL:
+	image = get_gradient (r, kind);
+	snprintf (desc, desc_size, "conical");
+	break;
+
+    default:
+	r->failed = TRUE;
+	break;
+    }
+
+    if (image && !r->failed)
+    {
+	size_t len;
+
+	pixman_image_set_repeat (image, repeat);
+	pixman_image_set_filter (image, filter, params, n);
+	pixman_image_set_component_alpha (image, component_alpha);
+
+	if (flags & PIXMAN_TRACE_TRANSFORM)
+	    pixman_image_set_transform (image, &transform);
+	if (flags & PIXMAN_TRACE_CLIP)
+	    pixman_image_set_clip_region32 (image, &clip);
+	if (flags & PIXMAN_TRACE_CLIP_SOURCES)
+	    pixman_image_set_source_clipping (image, TRUE);
+	if (alpha_map)
+	    pixman_image_set_alpha_map (image, alpha_map, alpha_x, alpha_y);
+
+	/* Only the properties that matter for the path taken */
+	len = strlen (desc);
+	if (component_alpha && role == ROLE_MASK)
+	    len += snprintf (desc + len, desc_size - len, "/ca");
+	if ((flags & PIXMAN_TRACE_TRANSFORM) && role != ROLE_DEST)
+	    len += snprintf (desc + len, desc_size - len, "/xform");
+	if (repeat != PIXMAN_REPEAT_NONE && role != ROLE_DEST &&
+	    kind == PIXMAN_TRACE_IMAGE_BITS)
+	{
+	    len += snprintf (desc + len, desc_size - len, "/repeat");
+	}
+	if ((flags & PIXMAN_TRACE_TRANSFORM) && role != ROLE_DEST &&
+	    filter != PIXMAN_FILTER_NEAREST && filter != PIXMAN_FILTER_FAST)
+	{
+	    len += snprintf (desc + len, desc_size - len, "/filtered");
+	}
+	if ((flags & PIXMAN_TRACE_CLIP_SOURCES) && role != ROLE_DEST)
+	    len += snprintf (desc + len, desc_size - len, "/clipped");
+	if (alpha_map)
+	    len += snprintf (desc + len, desc_size - len, "/alpha-map");
+    }
+
+out:
+    if (alpha_map)
+	pixman_image_unref (alpha_map);
+    pixman_region32_fini (&clip);
+    free (params);
+
+    return image;
+}
+
+static int
+get_group (group_t **groups, int *n_groups, const char *name)
+{
+    int i;
+
+    for (i = 0; i < *n_groups; i++)
+    {
+	if (strcmp ((*groups)[i].name, name) == 0)
+	    return i;
+    }
+
+    *groups = realloc (*groups, (*n_groups + 1) * sizeof (group_t));
+    memset (&(*groups)[i], 0, sizeof (group_t));
+    snprintf ((*groups)[i].name, sizeof ((*groups)[i].name), "%s", name);
+
+    return (*n_groups)++;
+}
+
+static pixman_bool_t
+get_call (reader_t *r, call_t *call, char *name, size_t name_size)
+{
+    char src[48], mask[48], dest[48];
+    const char *op;
+    int rows;
+
+    memset (call, 0, sizeof (call_t));
+
+    call->type = get_u8 (r);
+
+    switch (call->type)
+    {
+    case PIXMAN_TRACE_COMPOSITE:
+	call->op = get_u8 (r);
+	call->threaded = get_u8 (r);
+	call->src_x = get_s32 (r);
+	call->src_y = get_s32 (r);
+	call->mask_x = get_s32 (r);
+	call->mask_y = get_s32 (r);
+	call->dest_x = get_s32 (r);
+	call->dest_y = get_s32 (r);
+	call->width = get_s32 (r);
+	call->height = get_s32 (r);
+
+	call->src = get_image (r, ROLE_SOURCE, src, sizeof (src));
+	call->mask = get_image (r, ROLE_MASK, mask, sizeof (mask));
+	call->dest = get_image (r, ROLE_DEST, dest, sizeof (dest));
+
+	/* Unsupported formats or invalid gradients */
+	if (!r->failed && (!call->src || !call->dest ||
+			   (!call->mask && strcmp (mask, "null") != 0)))
+	{
+	    return FALSE;
+	}
+
+	op = operator_name (call->op);
+	if (strncmp (op, "PIXMAN_OP_", 10) == 0)
+	    op += 10;
+
+	snprintf (name, name_size, "%s %s %s %s%s",
+		  op, src, mask, dest, call->threaded ? " threaded" : "");
+	break;
+
+    case PIXMAN_TRACE_FILL:
+	call->dst_bpp = get_u32 (r);
+	call->dst_stride = get_s32 (r);
+	call->dest_x = get_s32 (r);
+	call->dest_y = get_s32 (r);
+	call->width = get_s32 (r);
+	call->height = get_s32 (r);
+	call->filler = get_u32 (r);
+
+	rows = call->dest_y + call->height;
+	if (r->failed || call->dst_stride <= 0 || call->dest_y < 0 || rows < 0)
+	    return FALSE;
+
+	call->dst_bits = get_buffer (ROLE_DEST, call->dst_stride, rows);
+
+	snprintf (name, name_size, "fill %dbpp", call->dst_bpp);
+	break;
+
+    case PIXMAN_TRACE_BLT:
+	call->src_bpp = get_u32 (r);
+	call->dst_bpp = get_u32 (r);
+	call->src_stride = get_s32 (r);
+	call->dst_stride = get_s32 (r);
+	call->src_x = get_s32 (r);
+	call->src_y = get_s32 (r);
+	call->dest_x = get_s32 (r);
+	call->dest_y = get_s32 (r);
+	call->width = get_s32 (r);
+	call->height = get_s32 (r);
+
+	if (r->failed || call->src_stride <= 0 || call->dst_stride <= 0 ||
+	    call->src_y < 0 || call->dest_y < 0 || call->height < 0)
+	{
+	    return FALSE;
+	}
+
+	call->src_bits = get_buffer (
+	    ROLE_BLT_SOURCE, call->src_stride, call->src_y + call->height);
+	call->dst_bits = get_buffer (
+	    ROLE_DEST, call->dst_stride, call->dest_y + call->height);
+
+	snprintf (name, name_size, "blt %dbpp -> %dbpp",
+		  call->src_bpp, call->dst_bpp);
+	break;
+
+    default:
+	r->failed = TRUE;
+	break;
+    }
+
+    return !r->failed;
+}
+
+static void
+free_call (call_t *call)
+{
+    if (call->src)
+	pixman_image_unref (call->src);
+    if (call->mask)
+	pixman_image_unref (call->mask);
+    if (call->dest)
+	pixman_image_unref (call->dest);
+}
+
+static void
+run_call (const call_t *call)
+{
+    switch (call->type)
+    {
+    case PIXMAN_TRACE_COMPOSITE:
+	if (call->threaded)
+	{
+	    pixman_image_composite32_threaded (
+		call->op, call->src, call->mask, call->dest,
+		call->src_x, call->src_y, call->mask_x, call->mask_y,
+		call->dest_x, call->dest_y, call->width, call->height);
+	}
+	else
+	{
+	    pixman_image_composite32 (
+		call->op, call->src, call->mask, call->dest,
+		call->src_x, call->src_y, call->mask_x, call->mask_y,
+		call->dest_x, call->dest_y, call->width, call->height);
+	}
+	break;
+
+    case PIXMAN_TRACE_FILL:
+	pixman_fill (call->dst_bits, call->dst_stride, call->dst_bpp,
+		     call->dest_x, call->dest_y, call->width, call->height,
+		     call->filler);
+	break;
+
+    case PIXMAN_TRACE_BLT:
+	pixman_blt (call->src_bits, call->dst_bits,
+		    call->src_stride, call->dst_stride,
+		    call->src_bpp, call->dst_bpp,
+		    call->src_x, call->src_y, call->dest_x, call->dest_y,
+		    call->width, call->height);
+	break;
+    }
+}
+
+static int
+compare_groups (const void *a, const void *b)
+{
+    const group_t *ga = a, *gb = b;
+
+    if (ga->time != gb->time)
+	return ga->time < gb->time ? 1 : -1;
+
+    return strcmp (ga->name, gb->name);
+}
+
+static uint8_t *
+read_file (const char *filename, size_t *size)
+{
+    FILE *f = fopen (filename, "rb");
+    uint8_t *data = NULL;
+    size_t n = 0, allocated = 0;
+
+    if (!f)
+	return NULL;
+
+    for (;;)
+    {
+	if (n == allocated)
+	{
+	    allocated = allocated ? allocated * 2 : 1 << 20;
+	    data = realloc (data, allocated);
+	}
+
+	n += fread (data + n, 1, allocated - n, f);
+
+	if (n < allocated)
+	    break;
+    }
+
+    fclose (f);
+
+    *size = n;
+    return data;
+}
+
+int
+main (int argc, char *argv[])
+{
+    group_t *groups = NULL;
+    call_t *calls = NULL;
+    int *order;
+    int i, j, n_groups = 0, n_calls = 0, n_skipped = 0;
+    double start, total, sum, group_time;
+    uint32_t header[2];
+    uint8_t *data;
+    reader_t r;
+    size_t size;
+
+    if (argc != 2)
+    {
+	printf ("Usage: %s <trace>\n"
+		"\n"
+		"Record a trace by running a program with PIXMAN_TRACE=<trace>\n"
+		"in the environment, and PIXMAN_TRACE_PIXELS=1 to also record\n"
+		"the contents of source and mask images.\n", argv[0]);
+	return 1;
+    }
+
+    if (getenv ("PIXMAN_TRACE"))
+    {
+	printf ("PIXMAN_TRACE must not be set while replaying\n");
+	return 1;
+    }
+
+    if (!(data = read_file (argv[1], &size)))
+    {
+	printf ("Could not read %s\n", argv[1]);
+	return 1;
+    }
+
+    r.p = data;
+    r.end = data + size;
+    r.failed = FALSE;
+
+    get (&r, header, sizeof (header));
+
+    if (header[0] != PIXMAN_TRACE_MAGIC)
+    {
+	printf ("%s is not a pixman trace, or was recorded on a host "
+		"with different byte order\n", argv[1]);
+	return 1;
+    }
+
+    if (header[1] != PIXMAN_TRACE_VERSION)
+    {
+	printf ("%s has unsupported version %u\n", argv[1], header[1]);
+	return 1;
+    }
+
+    prng_srand (0x7ace);
+    initialize_palette (&palette, 8, TRUE);
+
+    while (r.p < r.end && !r.failed)
+    {
+	char name[sizeof (groups->name)];
+	call_t call;
+
+	if (get_call (&r, &call, name, sizeof (name)))
+	{
+	    call.group = get_group (&groups, &n_groups, name);
+	    groups[call.group].n_calls++;
+	    groups[call.group].n_pixels += (double)call.width * call.height;
+
+	    if ((n_calls & (n_calls - 1)) == 0)
+	    {
+		calls = realloc (
+		    calls, (n_calls ? n_calls * 2 : 1) * sizeof (call_t));
+	    }
+	    calls[n_calls++] = call;
+	}
+	else
+	{
+	    free_call (&call);
+	    n_skipped++;
+	}
+    }
+
+    if (r.failed)
+	printf ("# trace is truncated or corrupt, replaying what was read\n");
+    if (n_skipped)
+	printf ("# skipped %d calls that can't be replayed\n", n_skipped);
+
+    /* The whole trace once, in order, which also warms up caches */
+    start = gettime ();
+    for (i = 0; i < n_calls; i++)
+	run_call (&calls[i]);
+    total = gettime () - start;
+
+    /* Calls sorted by group, keeping trace order within each group */
+    order = malloc ((n_calls + 1) * sizeof (int));
+
+    for (i = 0, j = 0; i < n_groups; i++)
+    {
+	groups[i].first = j;
+	j += groups[i].n_calls;
+	groups[i].n_calls = 0;
+    }
+
+    for (i = 0; i < n_calls; i++)
+    {
+	group_t *g = &groups[calls[i].group];
+
+	order[g->first + g->n_calls++] = i;
+    }
+
+    group_time = MIN (MIN_TIME, MAX_TIME / n_groups);
+
+    for (i = 0; i < n_groups; i++)
+    {
+	const int *group_calls = order + groups[i].first;
+	int n = 0;
+	double t;
+
+	start = gettime ();
+	do
+	{
+	    for (j = 0; j < groups[i].n_calls; j++)
+		run_call (&calls[group_calls[j]]);
+	    n++;
+	    t = gettime () - start;
+	}
+	while (t < group_time);
+
+	groups[i].time = t / n;
+    }
+
+    qsort (groups, n_groups, sizeof (group_t), compare_groups);
+
+    sum = 0;
+    for (i = 0; i < n_groups; i++)
+	sum += groups[i].time;
+
+    printf ("# %d calls in %d groups, %.3f ms replayed in order\n",
+	    n_calls, n_groups, total * 1000);
+    printf ("# times in ms per replay of the group, share of the sum of all groups\n");
+    printf ("%-52s %8s %10s %10s %9s %6s\n",
+	    "# signature", "calls", "Mpix", "time", "Mpix/s", "share");
+
+    for (i = 0; i < n_groups; i++)
+    {
+	const group_t *g = &groups[i];
+
+	printf ("%-52s %8d %10.3f %10.3f %9.2f %5.1f%%\n",
+		g->name, g->n_calls, g->n_pixels / 1000000, g->time * 1000,
+		g->n_pixels / 1000000 / g->time, 100 * g->time / sum);
+    }
+
+    for (i = 0; i < n_calls; i++)
+	free_call (&calls[i]);
+    free (calls);
+    free (order);
+    free (groups);
+    free_buffers ();
+    free (data);
+
+    return 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * Times pixman_composite_trapezoids() with trapezoid lists like the
+ * ones cairo produces when tessellating vector graphics: thin slanted
+ * trapezoids from stroking line plots, the outlines of rings, and a
+ * scatter of small filled shapes. They are composited with OVER in a
+ * solid color through an a8 mask onto a full HD destination.
+ */
+#include <stdlib.h>
+#include <math.h>
+#include "utils.h"
+
+#define WIDTH		1920
+#define HEIGHT		1080
+#define MIN_TIME	0.3
+
+static void
+add_trap (pixman_trapezoid_t *trap,
+	  double top, double bottom,
+	  double lx1, double ly1, double lx2, double ly2,
+	  double rx1, double ry1, double rx2, double ry2)
+{
+    trap->top = pixman_double_to_fixed (top);
+    trap->bottom = pixman_double_to_fixed (bottom);
+    trap->left.p1.x = pixman_double_to_fixed (lx1);
+    trap->left.p1.y = pixman_double_to_fixed (ly1);
+    trap->left.p2.x = pixman_double_to_fixed (lx2);
+    trap->left.p2.y = pixman_double_to_fixed (ly2);
+    trap->right.p1.x = pixman_double_to_fixed (rx1);
+    trap->right.p1.y = pixman_double_to_fixed (ry1);
+    trap->right.p2.x = pixman_double_to_fixed (rx2);
+    trap->right.p2.y = pixman_double_to_fixed (ry2);
+}
+
+/* A stroked line segment of the given width as a parallelogram, split
+ * into its top triangle, middle and bottom triangle.
+ */
+static int
+add_stroke (pixman_trapezoid_t *traps,
+	    double x1, double y1, double x2, double y2, double w)
+{
+    double len = sqrt ((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+    double nx = -(y2 - y1) / len * w / 2;
+    double ny = (x2 - x1) / len * w / 2;
+    double px[4], py[4];
+    int i, j, n = 0;
+
+    if (y1 > y2)
+    {
+	double t;
+
+	t = x1; x1 = x2; x2 = t;
+	t = y1; y1 = y2; y2 = t;
+	nx = -nx;
+	ny = -ny;
+    }
+
+    /* Corners in order of increasing y: a, then b and c, then d */
+    px[0] = x1 - nx; py[0] = y1 - ny;
+    px[1] = x1 + nx; py[1] = y1 + ny;
+    px[2] = x2 - nx; py[2] = y2 - ny;
+    px[3] = x2 + nx; py[3] = y2 + ny;
+
+    for (i = 0; i < 4; i++)
+    {
+	for (j = i + 1; j < 4; j++)
+	{
+	    if (py[j] < py[i])
+	    {
+		double t;
+
+		t = px[i]; px[i] = px[j]; px[j] = t;
+		t = py[i]; py[i] = py[j]; py[j] = t;
+	    }
+	}
+    }
+
+    /* Edges a-b, a-c, b-d and c-d; whichever of b and c is to the
+     * left bounds the left side.
+     */
+    if (px[1] > px[2] || (px[1] == px[2] && py[1] > py[2]))
+    {
+	double t;
+
+	t = px[1]; px[1] = px[2]; px[2] = t;
+	t = py[1]; py[1] = py[2]; py[2] = t;
+    }
+
+    if (py[1] < py[2])
+    {
+	/* left turns first */
+	add_trap (&traps[n++], py[0], py[1],
+		  px[0], py[0], px[1], py[1], px[0], py[0], px[2], py[2]);
+	add_trap (&traps[n++], py[1], py[2],
+		  px[1], py[1], px[3], py[3], px[0], py[0], px[2], py[2]);
+	add_trap (&traps[n++], py[2], py[3],
+		  px[1], py[1], px[3], py[3], px[2], py[2], px[3], py[3]);
+    }
+    else
+    {
+	add_trap (&traps[n++], py[0], py[2],
+		  px[0], py[0], px[1], py[1], px[0], py[0], px[2], py[2]);
+	add_trap (&traps[n++], py[2], py[1],
+		  px[0], py[0], px[1], py[1], px[2], py[2], px[3], py[3]);
+	add_trap (&traps[n++], py[1], py[3],
+		  px[1], py[1], px[3], py[3], px[2], py[2], px[3], py[3]);
+    }
+
+    return n;
+}
+
+static int
+make_strokes (pixman_trapezoid_t *traps)
+{
+    int i, j, n = 0;
+
+    /* Line plots: polylines across the width of the screen */
+    for (i = 0; i < 8; i++)
+    {
+	double x = 0;
+	double y = 100 + prng_rand_n (HEIGHT - 200);
+
+	for (j = 0; j < 96; j++)
+	{
+	    double x2 = x + WIDTH / 96.0;
+	    double y2 = y + (int)prng_rand_n (81) - 40;
+
+	    if (y2 < 10 || y2 > HEIGHT - 10)
+		y2 = y;
+
+	    n += add_stroke (traps + n, x, y, x2, y2, 1.5);
+
+	    x = x2;
+	    y = y2;
+	}
+    }
+
+    return n;
+}
+
+static int
+make_rings (pixman_trapezoid_t *traps)
+{
+    int i, j, n = 0;
+
+    for (i = 0; i < 6; i++)
+    {
+	double cx = 200 + prng_rand_n (WIDTH - 400);
+	double cy = 200 + prng_rand_n (HEIGHT - 400);
+	double r = 100 + prng_rand_n (100);
+
+	for (j = 0; j < 64; j++)
+	{
+	    double a1 = j * 2 * M_PI / 64;
+	    double a2 = (j + 1) * 2 * M_PI / 64;
+
+	    n += add_stroke (traps + n,
+			     cx + r * cos (a1), cy + r * sin (a1),
+			     cx + r * cos (a2), cy + r * sin (a2), 2.0);
+	}
+    }
+
+    return n;
+}
+
+static int
+make_scatter (pixman_trapezoid_t *traps)
+{
+    int i, n = 0;
+
+    for (i = 0; i < 200; i++)
+    {
+	double x = prng_rand_n (WIDTH - 20);
+	double y = prng_rand_n (HEIGHT - 20);
+	double s = 4 + prng_rand_n (12);
+
+	/* A small diamond */
+	add_trap (&traps[n++], y, y + s / 2,
+		  x + s / 2, y, x, y + s / 2, x + s / 2, y, x + s, y + s / 2);
+	add_trap (&traps[n++], y + s / 2, y + s,
+		  x, y + s / 2, x + s / 2, y + s, x + s, y + s / 2, x + s / 2, y + s);
+    }
+
+    return n;
+}
+
+static void
+bench (const char *name, pixman_image_t *src, pixman_image_t *dest,
+       const pixman_trapezoid_t *traps, int n_traps)
+{
+    double start = gettime (), t;
+    int n = 0;
+
+    do
+    {
+	pixman_composite_trapezoids (PIXMAN_OP_OVER, src, dest, PIXMAN_a8,
+				     0, 0, 0, 0, n_traps, traps);
+	n++;
+	t = gettime () - start;
+    }
+    while (t < MIN_TIME);
+
+    printf ("%-12s %8d %12.2f\n", name, n_traps, t * 1000000 / n);
+}
+
+int
+main (int argc, char *argv[])
+{
+    pixman_color_t color = { 0x2000, 0x4000, 0x8000, 0xc000 };
+    pixman_trapezoid_t *traps;
+    pixman_image_t *src, *dest;
+
+    prng_srand (0x7e5a11a7);
+
+    traps = malloc (4096 * sizeof (pixman_trapezoid_t));
+    src = pixman_image_create_solid_fill (&color);
+    dest = pixman_image_create_bits (PIXMAN_x8r8g8b8, WIDTH, HEIGHT, NULL, 0);
+
+    printf ("# times in us per pixman_composite_trapezoids() call\n");
+    printf ("# %-10s %8s %12s\n", "scene", "traps", "time");
+
+    bench ("strokes", src, dest, traps, make_strokes (traps));
+    bench ("rings", src, dest, traps, make_rings (traps));
+    bench ("scatter", src, dest, traps, make_scatter (traps));
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    free (traps);
+
+    return 0;
+}
@@ -2784,6 +2784,45 @@ FreeInputMask(OtherInputMasks ** imask)
                          ButtonReleaseMask | \
                          PointerMotionMask)
 
+/**
+ * Update the window's XI and XI2 delivery summaries from its own masks and
+ * its parent's summaries. The summaries are the union over all devices and
+ * ignore the do-not-propagate masks, so they may claim too much but never
+ * too little; DeliverDeviceEvents uses them to stop walking up the tree once
+ * no window left in the ancestry can want the event.
+ */
+static void
+RecalculateWindowInputSummary(WindowPtr pWin)
+{
+    OtherInputMasks *inputMasks = wOtherInputMasks(pWin);
+    size_t i, j;
+
+    pWin->deliverableXIEvents = 0;
+    memset(pWin->deliverableXI2Events, 0, sizeof(pWin->deliverableXI2Events));
+
+    if (inputMasks) {
+        size_t len = min(xi2mask_mask_size(inputMasks->xi2mask),
+                         sizeof(pWin->deliverableXI2Events));
+
+        for (i = 0; i < EMASKSIZE; i++)
+            pWin->deliverableXIEvents |= inputMasks->inputEvents[i];
+        for (i = 0; i < xi2mask_num_masks(inputMasks->xi2mask); i++) {
+            const unsigned char *m =
+                xi2mask_get_one_mask(inputMasks->xi2mask, i);
+
+            for (j = 0; j < len; j++)
+                pWin->deliverableXI2Events[j] |= m[j];
+        }
+    }
+
+    if (pWin->parent) {
+        pWin->deliverableXIEvents |= pWin->parent->deliverableXIEvents;
+        for (j = 0; j < sizeof(pWin->deliverableXI2Events); j++)
+            pWin->deliverableXI2Events[j] |=
+                pWin->parent->deliverableXI2Events[j];
+    }
+}
+
 void
 RecalculateDeviceDeliverableEvents(WindowPtr pWin)
 {
@@ -2812,6 +2851,7 @@ RecalculateDeviceDeliverableEvents(WindowPtr pWin)
                              & ~inputMasks->dontPropagateMask[i] &
                              XIPropagateMask);
         }
+        RecalculateWindowInputSummary(pChild);
         if (pChild->firstChild) {
             pChild = pChild->firstChild;
             continue;
@@ -2783,6 +2783,44 @@ EventIsDeliverable(DeviceIntPtr dev, int evtype, WindowPtr win)
     return rc;
 }
 
+/**
+ * Check if any window from win up to the root may want the event.
+ *
+ * Uses the per-window summaries maintained by RecalculateDeliverableEvents()
+ * and RecalculateDeviceDeliverableEvents(), so the check is independent of
+ * the depth of the window tree. A FALSE return is exact, a TRUE return only
+ * means EventIsDeliverable() needs to look at the individual windows.
+ *
+ * @param[in] dev The device this event is being sent for.
+ * @param[in] evtype The event type of the event that is to be sent.
+ * @param[in] win The current event window.
+ */
+static Bool
+EventMayBeDeliverableAbove(DeviceIntPtr dev, int evtype, WindowPtr win)
+{
+    int filter;
+    int type;
+
+    if ((type = GetXI2Type(evtype)) != 0 &&
+        BitIsOn(win->deliverableXI2Events, type))
+        return TRUE;
+
+    if ((type = GetXIType(evtype)) != 0) {
+        filter = event_get_filter_from_type(dev, type);
+        if (win->deliverableXIEvents & filter)
+            return TRUE;
+    }
+
+    if ((type = GetCoreType(evtype)) != 0) {
+        filter = event_get_filter_from_type(dev, type);
+        /* deliverableEvents only carries the propagating bits upwards */
+        if ((filter & ~PropagateMask) || (win->deliverableEvents & filter))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
 static int
 DeliverEvent(DeviceIntPtr dev, xEvent *xE, int count,
              WindowPtr win, Window child, GrabPtr grab)
@@ -2866,6 +2904,12 @@ DeliverDeviceEvents(WindowPtr pWin, InternalEvent *event, GrabPtr grab,
     verify_internal_event(event);
 
     while (pWin) {
+        /* Nobody from here up to the root selected for it, stop walking */
+        if (!EventMayBeDeliverableAbove(dev, event->any.type, pWin)) {
+            deliveries = 0;
+            break;
+        }
+
         if ((mask = EventIsDeliverable(dev, event->any.type, pWin))) {
             /* XI2 events first */
             if (mask & EVENT_XI2_MASK) {
@@ -6153,8 +6197,8 @@ WriteEventsToClient(ClientPtr pClient, int count, xEvent *events)
     }
 
     if (pClient->swapped) {
-        if (eventlength > swapEventLen) {
-            swapEventLen = eventlength;
+        if (count * eventlength > swapEventLen) {
+            swapEventLen = count * eventlength;
             swapEvent = realloc(swapEvent, swapEventLen);
             if (!swapEvent) {
                 FatalError("WriteEventsToClient: Out of memory.\n");
@@ -6162,17 +6206,18 @@ WriteEventsToClient(ClientPtr pClient, int count, xEvent *events)
             }
         }
 
+        /* swap them all, then write them out in one go */
         for (i = 0; i < count; i++) {
             eventFrom = &events[i];
-            eventTo = swapEvent;
+            eventTo = &swapEvent[i];
 
             /* Remember to strip off the leading bit of type in case
                this event was sent with "SendEvent." */
             (*EventSwapVector[eventFrom->u.u.type & 0177])
                 (eventFrom, eventTo);
-
-            WriteToClient(pClient, eventlength, eventTo);
         }
+
+        WriteToClient(pClient, count * eventlength, swapEvent);
     }
     else {
         /* only one GenericEvent, remember? that means either count is 1 and
@@ -497,6 +497,8 @@ SetWindowToDefaults(WindowPtr pWin)
 
     pWin->eventMask = 0;
     pWin->deliverableEvents = 0;
+    pWin->deliverableXIEvents = 0;
+    memset(pWin->deliverableXI2Events, 0, sizeof(pWin->deliverableXI2Events));
     pWin->dontPropagate = 0;
     pWin->redirectDraw = RedirectDrawNone;
     pWin->forcedBG = FALSE;
@@ -927,6 +929,7 @@ CreateWindow(Window wid, WindowPtr pParent, int x, int y, unsigned w,
 
     if (!(vmask & CWEventMask))
         RecalculateDeliverableEvents(pWin);
+    RecalculateDeviceDeliverableEvents(pWin);
 
     if (vmask)
         *error = ChangeWindowAttributes(pWin, vmask, vlist, wClient(pWin));
@@ -2591,6 +2594,7 @@ ReparentWindow(WindowPtr pWin, WindowPtr pParent,
     if (WasMapped)
         MapWindow(pWin, client);
     RecalculateDeliverableEvents(pWin);
+    RecalculateDeviceDeliverableEvents(pWin);
     return Success;
 }
 
@@ -2052,6 +2052,11 @@ __glXDisp_GetDrawableAttributesSGIX(__GLXclientState * cl, GLbyte * pc)
 ** client library to send batches of GL rendering commands.
 */
 
+/*
+** Smallest reassembly buffer allocated for large commands.
+*/
+#define __GLX_LARGE_CMD_BUF_MIN (64 * 1024)
+
 /*
 ** Reset state used to keep track of large (multi-request) commands.
 */
@@ -2120,6 +2125,21 @@ __glXDisp_Render(__GLXclientState * cl, GLbyte * pc)
         if (left < cmdlen)
             return BadLength;
 
+        /*
+         ** Draw runs of immediate mode vertex commands as vertex arrays.
+         */
+        if (opcode == X_GLrop_Begin && !client->swapped) {
+            int runCommands;
+            int runBytes = __glXRenderVertexRun(pc, left, &runCommands);
+
+            if (runBytes > 0) {
+                pc += runBytes;
+                left -= runBytes;
+                commandsDone += runCommands;
+                continue;
+            }
+        }
+
         /*
          ** Check for core opcodes and grab entry data.
          */
@@ -2269,18 +2289,52 @@ __glXDisp_RenderLarge(__GLXclientState * cl, GLbyte * pc)
         }
 
         /*
-         ** Make enough space in the buffer, then copy the entire request.
+         ** If the whole command arrived in this one request there is
+         ** nothing to reassemble; execute it straight out of the request.
          */
-        if (glxc->largeCmdBufSize < cmdlen) {
-	    GLbyte *newbuf = glxc->largeCmdBuf;
+        if (req->requestTotal == 1) {
+            __GLXdispatchRenderProcPtr proc;
+
+            if (safe_pad(dataBytes) != cmdlen)
+                return BadLength;
 
-	    if (!(newbuf = realloc(newbuf, cmdlen)))
-		return BadAlloc;
+            proc = (__GLXdispatchRenderProcPtr)
+                __glXGetProtocolDecodeFunction(&Render_dispatch_info, opcode,
+                                               client->swapped);
+            if (proc == NULL) {
+                client->errorValue = opcode;
+                return __glXError(GLXBadLargeRequest);
+            }
 
-	    glxc->largeCmdBuf = newbuf;
-            glxc->largeCmdBufSize = cmdlen;
+            (*proc) (pc + __GLX_RENDER_LARGE_HDR_SIZE);
+            glxc->largeCmdBytesDirect += dataBytes;
+            return Success;
+        }
+
+        /*
+         ** Make enough space in the buffer, then copy the entire request.
+         ** The buffer is kept across series and grown geometrically, so
+         ** a client streaming slightly larger uploads doesn't realloc on
+         ** every one.  Nothing in the old buffer is live at this point,
+         ** so don't let realloc copy it.
+         */
+        if (glxc->largeCmdBufSize < cmdlen) {
+            GLint newsize = max(glxc->largeCmdBufSize, __GLX_LARGE_CMD_BUF_MIN);
+
+            while (newsize < cmdlen && newsize <= INT_MAX / 2)
+                newsize *= 2;
+            if (newsize < cmdlen)
+                newsize = cmdlen;
+
+            free(glxc->largeCmdBuf);
+            glxc->largeCmdBufSize = 0;
+            if (!(glxc->largeCmdBuf = malloc(newsize)))
+                return BadAlloc;
+            glxc->largeCmdBufSize = newsize;
+            glxc->largeCmdBufReallocs++;
         }
         memcpy(glxc->largeCmdBuf, pc, dataBytes);
+        glxc->largeCmdBytesCopied += dataBytes;
 
         glxc->largeCmdBytesSoFar = dataBytes;
         glxc->largeCmdBytesTotal = cmdlen;
@@ -2326,6 +2380,7 @@ __glXDisp_RenderLarge(__GLXclientState * cl, GLbyte * pc)
         }
 
         memcpy(glxc->largeCmdBuf + glxc->largeCmdBytesSoFar, pc, dataBytes);
+        glxc->largeCmdBytesCopied += dataBytes;
         glxc->largeCmdBytesSoFar += dataBytes;
         glxc->largeCmdRequestsSoFar++;
 
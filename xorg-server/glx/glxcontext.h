@@ -127,6 +127,14 @@ struct __GLXcontext {
     GLbyte *largeCmdBuf;
     GLint largeCmdBufSize;
 
+    /*
+     ** Copy accounting for pixel and large command traffic.
+     */
+    uint64_t largeCmdBytesCopied;       /* reassembled into largeCmdBuf */
+    uint64_t largeCmdBytesDirect;       /* dispatched from the request  */
+    uint64_t pixelBytesReturned;        /* pixel data sent in replies   */
+    GLuint largeCmdBufReallocs;
+
     /*
      ** The drawable private this context is bound to
      */
@@ -36,6 +36,7 @@
 
 #endif
 
+#include <inttypes.h>
 #include <string.h>
 #include "glxserver.h"
 #include <windowstr.h>
@@ -180,6 +181,16 @@ __glXFreeContext(__GLXcontext * cx)
 
     __glXRemoveFromContextList(cx);
 
+    if (cx->largeCmdBytesCopied || cx->largeCmdBytesDirect ||
+        cx->pixelBytesReturned)
+        LogMessageVerb(X_INFO, 5,
+                       "GLX: context 0x%x: %" PRIu64 " large command bytes "
+                       "copied (%u buffer allocations), %" PRIu64 " dispatched "
+                       "in place, %" PRIu64 " pixel bytes returned\n",
+                       (unsigned) cx->id, cx->largeCmdBytesCopied,
+                       cx->largeCmdBufReallocs, cx->largeCmdBytesDirect,
+                       cx->pixelBytesReturned);
+
     free(cx->feedbackBuf);
     free(cx->selectBuf);
     free(cx->largeCmdBuf);
@@ -206,6 +206,8 @@ extern int __glXImageSize(GLenum format, GLenum type,
                           GLint imageHeight, GLint rowLength, GLint skipImages,
                           GLint skipRows, GLint alignment);
 
+extern int __glXRenderVertexRun(GLbyte * pc, int left, int *commands);
+
 extern unsigned glxMajorVersion;
 extern unsigned glxMinorVersion;
 
@@ -268,3 +268,209 @@ __glXDisp_DrawArrays(GLbyte * pc)
     glDisableClientState(GL_SECONDARY_COLOR_ARRAY);
     glDisableClientState(GL_FOG_COORD_ARRAY);
 }
+
+/*
+** Batched immediate mode.
+**
+** Legacy applications send geometry as long Begin/End runs of tiny
+** Vertex/Normal/Color/TexCoord commands. When every vertex of such a run in
+** a single Render request carries the same set of attribute commands, the
+** run is drawn straight out of the request buffer as interleaved vertex
+** arrays with one DrawArrays, instead of dispatching each command.
+**
+** Group k of a run is everything after vertex k-1 up to and including
+** vertex k. Groups 2..n must be identical, group 1 may have extra leading
+** commands which are simply executed first.
+*/
+
+#define __GLX_VERTEX_RUN_MIN 8          /* shorter runs aren't worth it */
+#define __GLX_VERTEX_RUN_MAX_CMDS 4     /* commands per group */
+
+typedef struct {
+    CARD16 opcode;
+    CARD16 length;                      /* including the header */
+    GLenum array;                       /* 0 for vertex */
+    GLint size;
+    GLenum type;
+    __GLXdispatchRenderProcPtr proc;
+} __GLXvertexRunAttrib;
+
+static const __GLXvertexRunAttrib vertexRunAttribs[] = {
+    {X_GLrop_Vertex2fv, 12, 0, 2, GL_FLOAT, __glXDisp_Vertex2fv},
+    {X_GLrop_Vertex3fv, 16, 0, 3, GL_FLOAT, __glXDisp_Vertex3fv},
+    {X_GLrop_Normal3fv, 16, GL_NORMAL_ARRAY, 3, GL_FLOAT, __glXDisp_Normal3fv},
+    {X_GLrop_Color3fv, 16, GL_COLOR_ARRAY, 3, GL_FLOAT, __glXDisp_Color3fv},
+    {X_GLrop_Color4fv, 20, GL_COLOR_ARRAY, 4, GL_FLOAT, __glXDisp_Color4fv},
+    {X_GLrop_Color3ubv, 8, GL_COLOR_ARRAY, 3, GL_UNSIGNED_BYTE,
+     __glXDisp_Color3ubv},
+    {X_GLrop_Color4ubv, 8, GL_COLOR_ARRAY, 4, GL_UNSIGNED_BYTE,
+     __glXDisp_Color4ubv},
+    {X_GLrop_TexCoord2fv, 12, GL_TEXTURE_COORD_ARRAY, 2, GL_FLOAT,
+     __glXDisp_TexCoord2fv},
+};
+
+static const __GLXvertexRunAttrib *
+vertexRunLookup(const GLbyte * pc, int left)
+{
+    const __GLXrenderHeader *hdr = (const __GLXrenderHeader *) pc;
+    int i;
+
+    if (left < __GLX_RENDER_HDR_SIZE)
+        return NULL;
+
+    for (i = 0; i < ARRAY_SIZE(vertexRunAttribs); i++) {
+        if (vertexRunAttribs[i].opcode == hdr->opcode)
+            return hdr->length == vertexRunAttribs[i].length &&
+                hdr->length <= left ? &vertexRunAttribs[i] : NULL;
+    }
+    return NULL;
+}
+
+/*
+** Try to execute the Begin command at pc, and everything up to the
+** matching End, as a vertex array draw. Only for unswapped clients.
+**
+** Returns the number of bytes consumed and stores the number of commands
+** in *commands, or returns 0 if the run doesn't qualify; nothing has been
+** executed then and the caller dispatches the commands one by one.
+*/
+int
+__glXRenderVertexRun(GLbyte * pc, int left, int *commands)
+{
+    const __GLXvertexRunAttrib *group[__GLX_VERTEX_RUN_MAX_CMDS];
+    const __GLXvertexRunAttrib *attr;
+    const __GLXrenderHeader *hdr;
+    GLbyte *start, *first = NULL, *end, *p;
+    int groupLen = 0, groupCmds = 0, cmds = 0, n = 0, i, offset;
+    GLbitfield arrays = 0;
+    GLenum mode;
+
+    hdr = (const __GLXrenderHeader *) pc;
+    if (hdr->opcode != X_GLrop_Begin || hdr->length != 8 || left < 8)
+        return 0;
+    mode = *(GLenum *) (pc + __GLX_RENDER_HDR_SIZE);
+    start = pc + 8;
+    left -= 8;
+
+    /*
+     ** Find the End, the end of the first group and the layout of the
+     ** second group. Bail out on anything but known attribute commands.
+     */
+    for (p = start; ; p += hdr->length, left -= hdr->length, cmds++) {
+        hdr = (const __GLXrenderHeader *) p;
+        if (left >= __GLX_RENDER_HDR_SIZE && hdr->opcode == X_GLrop_End &&
+            hdr->length == __GLX_RENDER_HDR_SIZE)
+            break;
+        if (!(attr = vertexRunLookup(p, left)))
+            return 0;
+
+        if (n == 1) {
+            if (groupCmds == __GLX_VERTEX_RUN_MAX_CMDS)
+                return 0;
+            for (i = 0; i < groupCmds; i++)
+                if (group[i]->array == attr->array)
+                    return 0;   /* same attribute twice per vertex */
+            group[groupCmds++] = attr;
+            groupLen += attr->length;
+        }
+        if (attr->array == 0) {
+            if (n == 0)
+                first = p + attr->length;
+            n++;
+        }
+    }
+    end = p;
+
+    if (n < __GLX_VERTEX_RUN_MIN)
+        return 0;
+
+    /* group 1 must end like group 2, and groups 2..n must all be equal */
+    if (first - start < groupLen)
+        return 0;
+    for (p = start; p < first - groupLen; p += hdr->length) {
+        hdr = (const __GLXrenderHeader *) p;
+        if (hdr->length > first - groupLen - p)
+            return 0;
+    }
+    if (p != first - groupLen)
+        return 0;
+    for (p = first - groupLen; p + groupLen <= end; ) {
+        for (i = 0; i < groupCmds; i++) {
+            hdr = (const __GLXrenderHeader *) p;
+            if (hdr->opcode != group[i]->opcode)
+                return 0;
+            p += group[i]->length;
+        }
+    }
+    /* whatever follows the last vertex can't contain another vertex */
+    for (; p < end; p += hdr->length) {
+        hdr = (const __GLXrenderHeader *) p;
+        if (vertexRunLookup(p, end - p)->array == 0)
+            return 0;
+    }
+
+    /*
+     ** The run qualifies. Leading commands set the current state first,
+     ** then the groups are drawn as interleaved arrays.
+     */
+    for (p = start; p < first - groupLen; p += hdr->length) {
+        hdr = (const __GLXrenderHeader *) p;
+        vertexRunLookup(p, end - p)->proc(p + __GLX_RENDER_HDR_SIZE);
+    }
+
+    for (i = 0, offset = __GLX_RENDER_HDR_SIZE; i < groupCmds;
+         offset += group[i]->length, i++) {
+        GLbyte *data = first - groupLen + offset;
+
+        attr = group[i];
+        switch (attr->array) {
+        case 0:
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glVertexPointer(attr->size, attr->type, groupLen, data);
+            break;
+        case GL_NORMAL_ARRAY:
+            glEnableClientState(GL_NORMAL_ARRAY);
+            glNormalPointer(attr->type, groupLen, data);
+            arrays |= 1;
+            break;
+        case GL_COLOR_ARRAY:
+            glEnableClientState(GL_COLOR_ARRAY);
+            glColorPointer(attr->size, attr->type, groupLen, data);
+            arrays |= 2;
+            break;
+        case GL_TEXTURE_COORD_ARRAY:
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+            glTexCoordPointer(attr->size, attr->type, groupLen, data);
+            arrays |= 4;
+            break;
+        }
+    }
+
+    glDrawArrays(mode, 0, n);
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (arrays & 1)
+        glDisableClientState(GL_NORMAL_ARRAY);
+    if (arrays & 2)
+        glDisableClientState(GL_COLOR_ARRAY);
+    if (arrays & 4)
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+    /*
+     ** The current attributes are undefined after drawing with arrays,
+     ** restore what the last vertex left behind, then run the trailing
+     ** commands.
+     */
+    p = first - groupLen + (n - 1) * groupLen;
+    for (i = 0; i < groupCmds; p += group[i]->length, i++) {
+        if (group[i]->array != 0)
+            group[i]->proc(p + __GLX_RENDER_HDR_SIZE);
+    }
+    for (; p < end; p += hdr->length) {
+        hdr = (const __GLXrenderHeader *) p;
+        vertexRunLookup(p, end - p)->proc(p + __GLX_RENDER_HDR_SIZE);
+    }
+
+    *commands = cmds + 2;       /* including Begin and End */
+    return end + __GLX_RENDER_HDR_SIZE - pc;
+}
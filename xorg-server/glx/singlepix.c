@@ -89,6 +89,7 @@ __glXDisp_ReadPixels(__GLXclientState * cl, GLbyte * pc)
         __GLX_BEGIN_REPLY(compsize);
         __GLX_SEND_HEADER();
         __GLX_SEND_VOID_ARRAY(compsize);
+        cx->pixelBytesReturned += compsize;
     }
     return Success;
 }
@@ -151,6 +152,7 @@ __glXDisp_GetTexImage(__GLXclientState * cl, GLbyte * pc)
         ((xGLXGetTexImageReply *) &reply)->depth = depth;
         __GLX_SEND_HEADER();
         __GLX_SEND_VOID_ARRAY(compsize);
+        cx->pixelBytesReturned += compsize;
     }
     return Success;
 }
@@ -101,6 +101,7 @@ __glXDispSwap_ReadPixels(__GLXclientState * cl, GLbyte * pc)
         __GLX_SWAP_REPLY_HEADER();
         __GLX_SEND_HEADER();
         __GLX_SEND_VOID_ARRAY(compsize);
+        cx->pixelBytesReturned += compsize;
     }
     return Success;
 }
@@ -176,6 +177,7 @@ __glXDispSwap_GetTexImage(__GLXclientState * cl, GLbyte * pc)
         ((xGLXGetTexImageReply *) &reply)->depth = depth;
         __GLX_SEND_HEADER();
         __GLX_SEND_VOID_ARRAY(compsize);
+        cx->pixelBytesReturned += compsize;
     }
     return Success;
 }
@@ -75,7 +75,7 @@
  */
 #define ABI_ANSIC_VERSION	SET_ABI_VERSION(0, 4)
 #define ABI_VIDEODRV_VERSION	SET_ABI_VERSION(25, 3)
-#define ABI_XINPUT_VERSION	SET_ABI_VERSION(24, 4)
+#define ABI_XINPUT_VERSION	SET_ABI_VERSION(24, 5)
 #define ABI_EXTENSION_VERSION	SET_ABI_VERSION(10, 0)
 
 #define MODINFOSTRING1	0xef23fdc5
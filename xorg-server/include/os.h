@@ -122,6 +122,10 @@ extern _X_EXPORT void FlushIfCriticalOutputPending(void);
 
 extern _X_EXPORT void SetCriticalOutputPending(void);
 
+extern _X_EXPORT void BeginOutputBatch(void);
+
+extern _X_EXPORT void EndOutputBatch(void);
+
 extern _X_EXPORT int WriteToClient(ClientPtr /*who */ , int /*count */ ,
                                    const void * /*buf */ );
 
@@ -57,7 +57,7 @@ typedef double (*PointerAccelerationProfileFunc)
  * a more or less straight line
  */
 typedef struct _MotionTracker {
-    double dx, dy;              /* accumulated delta for each axis */
+    double x, y;                /* accumulated motion at time of creation */
     int time;                   /* time of creation */
     int dir;                    /* initial direction bitfield */
 } MotionTracker, *MotionTrackerPtr;
@@ -88,6 +88,7 @@ typedef struct _DeviceVelocityRec {
     struct {                    /* to be able to query this information */
         int profile_number;
     } statistics;
+    double motion_x, motion_y;  /* motion accumulated since tracker init */
 } DeviceVelocityRec, *DeviceVelocityPtr;
 
 /**
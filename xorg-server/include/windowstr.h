@@ -57,6 +57,7 @@ SOFTWARE.
 #include "privates.h"
 #include "miscstruct.h"
 #include <X11/Xprotostr.h>
+#include <X11/extensions/XI2.h>
 #include "opaque.h"
 
 #define GuaranteeNothing	0
@@ -125,6 +126,12 @@ typedef struct _WindowOpt {
 #define RedirectDrawAutomatic	1
 #define RedirectDrawManual	2
 
+/*
+ * Bytes needed for a per-window XI2 event type summary, one bit per
+ * (1 << type) as in the XI2 protocol masks.
+ */
+#define XI2WINDOWMASKSIZE	((XI_LASTEVENT >> 3) + 1)
+
 typedef struct _Window {
     DrawableRec drawable;
     PrivateRec *devPrivates;
@@ -141,6 +148,8 @@ typedef struct _Window {
     DDXPointRec origin;         /* position relative to parent */
     unsigned short borderWidth;
     unsigned long deliverableEvents;   /* all masks from all clients */
+    Mask deliverableXIEvents;   /* XI masks, any device, this + ancestors */
+    unsigned char deliverableXI2Events[XI2WINDOWMASKSIZE]; /* ditto, XI2 */
     Mask eventMask;             /* mask from the creating client */
     PixUnion background;
     PixUnion border;
@@ -519,6 +519,9 @@ mieqProcessInputEvents(void)
     DeviceIntPtr dev = NULL, master = NULL;
     static Bool inProcessInputEvents = FALSE;
 
+    /* write each client's share of the burst out in one go */
+    BeginOutputBatch();
+
     input_lock();
 
     /*
@@ -578,6 +581,8 @@ mieqProcessInputEvents(void)
     CallCallbacks(&miCallbacksWhenDrained, NULL);
 
     input_unlock();
+
+    EndOutputBatch();
 }
 
 void mieqAddCallbackOnDrained(CallbackProcPtr callback, void *param)
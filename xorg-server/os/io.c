@@ -102,6 +102,8 @@ static ConnectionInputPtr AllocateInputBuffer(void);
 static ConnectionOutputPtr AllocateOutputBuffer(void);
 
 static Bool CriticalOutputPending;
+static int OutputBatchDepth;
+static Bool OutputBatchPending;
 static int timesThisConnection = 0;
 static ConnectionInputPtr FreeInputs = (ConnectionInputPtr) NULL;
 static ConnectionOutputPtr FreeOutputs = (ConnectionOutputPtr) NULL;
@@ -646,6 +648,41 @@ SetCriticalOutputPending(void)
     CriticalOutputPending = TRUE;
 }
 
+/********************
+ * BeginOutputBatch()/EndOutputBatch()
+ *    WriteToClient() normally writes to local clients with an empty
+ *    output buffer right away. Between these calls, that data is buffered
+ *    instead and written out once, when the outermost batch ends. Used
+ *    while draining the input event queue, so a burst of events reaches
+ *    each client in a single write.
+ *
+ **********************/
+
+void
+BeginOutputBatch(void)
+{
+    OutputBatchDepth++;
+}
+
+void
+EndOutputBatch(void)
+{
+    ClientPtr client, tmp;
+    OsCommPtr oc;
+
+    if (--OutputBatchDepth > 0 || !OutputBatchPending)
+        return;
+
+    OutputBatchPending = FALSE;
+    xorg_list_for_each_entry_safe(client, tmp, &output_pending_clients, output_pending) {
+        oc = (OsCommPtr) client->osPrivate;
+        if (client->clientGone || !(oc->flags & OS_COMM_BATCHED))
+            continue;
+        oc->flags &= ~OS_COMM_BATCHED;
+        (void) FlushClient(client, oc, (char *) NULL, 0);
+    }
+}
+
 /*****************
  * AbortClient:
  *    When a write error occurs to a client, close
@@ -790,7 +827,8 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         }
     }
 #endif
-    if ((oco->count == 0 && who->local) || oco->count + count + padBytes > oco->size) {
+    if ((oco->count == 0 && who->local && !OutputBatchDepth) ||
+        oco->count + count + padBytes > oco->size) {
         output_pending_clear(who);
         if (!any_output_pending()) {
             CriticalOutputPending = FALSE;
@@ -800,6 +838,12 @@ WriteToClient(ClientPtr who, int count, const void *__buf)
         return FlushClient(who, oc, buf, count);
     }
 
+    /* written out by EndOutputBatch() instead */
+    if (oco->count == 0 && who->local) {
+        oc->flags |= OS_COMM_BATCHED;
+        OutputBatchPending = TRUE;
+    }
+
     NewOutputPending = TRUE;
     output_pending_mark(who);
     memmove((char *) oco->buf + oco->count, buf, count);
@@ -123,6 +123,7 @@ typedef struct _osComm {
 
 #define OS_COMM_GRAB_IMPERVIOUS 1
 #define OS_COMM_IGNORED         2
+#define OS_COMM_BATCHED         4   /* flush deferred by BeginOutputBatch() */
 
 extern int FlushClient(ClientPtr /*who */ ,
                        OsCommPtr /*oc */ ,
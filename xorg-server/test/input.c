@@ -44,6 +44,7 @@
 #include "eventstr.h"
 #include "inpututils.h"
 #include "mi.h"
+#include "ptrveloc.h"
 #include "assert.h"
 
 #include "tests-common.h"
@@ -1909,6 +1910,59 @@ dix_enqueue_events(void)
     inputInfo.devices = NULL;
 }
 
+/**
+ * Tabulated acceleration profiles must match the direct computation, and
+ * the velocity estimate of a constant motion must be its actual speed.
+ */
+static void
+dix_pointer_acceleration(void)
+{
+    DeviceVelocityRec vel;
+    int profiles[] = {
+        AccelProfileClassic, AccelProfilePolynomial, AccelProfileSmoothLinear,
+        AccelProfileSimple, AccelProfilePower, AccelProfileSmoothLimited,
+    };
+    double thresholds[] = { 0.0, 1.0, 4.0, 7.5 };
+    double accs[] = { 1.0, 2.0, 5.0 };
+    int p, t, a, i;
+
+    InitVelocityData(&vel);
+
+    for (p = 0; p < ARRAY_SIZE(profiles); p++) {
+        assert(SetAccelerationProfile(&vel, profiles[p]));
+        assert(vel.profile_private);
+
+        for (t = 0; t < ARRAY_SIZE(thresholds); t++) {
+            for (a = 0; a < ARRAY_SIZE(accs); a++) {
+                double v;
+
+                for (v = 0.0; v < 40.0; v += 0.01) {
+                    double exact = vel.Profile(NULL, &vel, v, thresholds[t],
+                                               accs[a]);
+                    double table = BasicComputeAcceleration(NULL, &vel, v,
+                                                            thresholds[t],
+                                                            accs[a]);
+
+                    if (exact < vel.min_acceleration)
+                        exact = vel.min_acceleration;
+                    assert(fabs(table - exact) <= 0.005 * fabs(exact));
+                }
+            }
+        }
+    }
+
+    /* cheap profiles are not tabulated */
+    SetAccelerationProfile(&vel, AccelProfileLinear);
+    assert(vel.profile_private == NULL);
+
+    /* 1 unit per ms, velocity is in units per 10 ms by default */
+    for (i = 1; i <= 20; i++)
+        ProcessVelocityData2D(&vel, 1.0, 0.0, i);
+    assert(fabs(vel.velocity - vel.corr_mul) < 1e-9);
+
+    FreeVelocityData(&vel);
+}
+
 int
 input_test(void)
 {
@@ -1931,6 +1985,7 @@ input_test(void)
     dix_get_master();
     input_option_test();
     mieq_test();
+    dix_pointer_acceleration();
 
     return 0;
 }
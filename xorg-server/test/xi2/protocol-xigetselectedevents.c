@@ -36,6 +36,7 @@
  * Zero-length masks if no masks are set.
  * Valid masks for valid devices.
  * Masks set on non-existent devices are not returned.
+ * Per-window delivery summaries follow the masks of the window ancestry.
  *
  * Note that this test is not connected to the XISelectEvents request.
  */
@@ -208,6 +209,48 @@ test_XIGetSelectedEvents(void)
     }
 }
 
+static void
+test_XISetEventMask_summary(void)
+{
+    ClientRec client = init_client(0, NULL);
+    unsigned char mask[XI2MASKSIZE];
+    DeviceIntRec dev;
+
+    printf("Testing window delivery summaries\n");
+    memset(&dev, 0, sizeof(dev));
+    root.firstChild = root.lastChild = &window;
+
+    /* raw events on the root show up below, but don't claim motion */
+    dev.id = XIAllMasterDevices;
+    memset(mask, 0, sizeof(mask));
+    SetBit(mask, XI_RawMotion);
+    SetBit(mask, XI_TouchBegin);
+    XISetEventMask(&dev, &root, &client, sizeof(mask), mask);
+    assert(BitIsOn(root.deliverableXI2Events, XI_RawMotion));
+    assert(BitIsOn(window.deliverableXI2Events, XI_RawMotion));
+    assert(BitIsOn(window.deliverableXI2Events, XI_TouchBegin));
+    assert(!BitIsOn(window.deliverableXI2Events, XI_Motion));
+
+    /* a child's mask never leaks up to the parent */
+    dev.id = 2;
+    memset(mask, 0, sizeof(mask));
+    SetBit(mask, XI_Motion);
+    XISetEventMask(&dev, &window, &client, sizeof(mask), mask);
+    assert(BitIsOn(window.deliverableXI2Events, XI_Motion));
+    assert(!BitIsOn(root.deliverableXI2Events, XI_Motion));
+
+    /* removing the masks clears the summaries again */
+    XISetEventMask(&dev, &window, &client, 0, NULL);
+    assert(!BitIsOn(window.deliverableXI2Events, XI_Motion));
+    dev.id = XIAllMasterDevices;
+    XISetEventMask(&dev, &root, &client, 0, NULL);
+    assert(!BitIsOn(root.deliverableXI2Events, XI_RawMotion));
+    assert(!BitIsOn(window.deliverableXI2Events, XI_RawMotion));
+    assert(!BitIsOn(window.deliverableXI2Events, XI_TouchBegin));
+
+    root.firstChild = root.lastChild = NULL;
+}
+
 int
 protocol_xigetselectedevents_test(void)
 {
@@ -216,6 +259,7 @@ protocol_xigetselectedevents_test(void)
     enable_XISetEventMask_wrap = 0;
 
     test_XIGetSelectedEvents();
+    test_XISetEventMask_summary();
 
     return 0;
 }